@@ -0,0 +1,97 @@
+// Microbenchmark for keyword recognition: the compare chain the lexer used
+// to run for every word against lookupKeyword() from keywords.h. Build and
+// run it with `make bench`.
+#include "../src/lexer/keywords.h"
+#include<chrono>
+#include<iostream>
+#include<random>
+#include<string>
+#include<vector>
+
+using namespace std;
+
+namespace {
+
+// Kept as it was in Lexer::tokenize(), one compare per keyword
+TokenType compareChain(string_view word)
+{
+    TokenType type = T_ID;
+    if (word == "int") type = T_INT;
+    else if (word == "float") type = T_FLOAT;
+    else if (word == "double") type = T_DOUBLE;
+    else if (word == "string") type = T_STRING;
+    else if (word == "char") type = T_CHAR;
+    else if (word == "bool") type = T_BOOL;
+    else if (word == "true") type = T_TRUE;
+    else if (word == "false") type = T_FALSE;
+    else if (word == "else") type = T_ELSE;
+    else if (word == "return") type = T_RETURN;
+    else if (word == "agar") type = T_AGAR;
+    else if (word == "if") type = T_IF;
+    else if (word == "magar") type = T_MAGAR;
+    else if (word == "while") type = T_WHILE;
+    else if (word == "for") type = T_FOR;
+    else if (word == "switch") type = T_SWITCH;
+    else if (word == "case") type = T_CASE;
+    else if (word == "break") type = T_BREAK;
+    else if (word == "continue") type = T_CONTINUE;
+    else if (word == "default") type = T_DEFAULT;
+    else if (word == "do") type = T_DO;
+    else if (word == "cout") type = T_STANDARD_OUTPUT_STREAM;
+    else if (word == "cin") type = T_STARNDARD_INPUT_STREAM;
+    else if (word == "void") type = T_VOID;
+    return type;
+}
+
+// Identifier-like words, a quarter of them keywords, as in typical sources
+vector<string> makeWords(size_t count)
+{
+    mt19937 random(42);
+    vector<string> words;
+    words.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (random() % 4 == 0)
+        {
+            words.emplace_back(KEYWORDS[random() % size(KEYWORDS)].text);
+            continue;
+        }
+        string word(1 + random() % 10, 'a');
+        for (char &c : word) c = static_cast<char>('a' + random() % 26);
+        words.push_back(word);
+    }
+    return words;
+}
+
+template <typename Classify>
+void run(const char *name, const vector<string> &words, Classify classify)
+{
+    auto start = chrono::steady_clock::now();
+    size_t keywords = 0;
+    for (const string &word : words) keywords += classify(word) != T_ID;
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    cout << name << ": " << elapsed.count() << " ms (" << keywords << " keywords)" << endl;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? stoul(argv[1]) : 4000000;
+    vector<string> words = makeWords(count);
+
+    // Both must classify every word the same way before timing means anything
+    for (const string &word : words)
+    {
+        if (compareChain(word) != lookupKeyword(word))
+        {
+            cerr << "lookupKeyword disagrees on \"" << word << "\"" << endl;
+            return 1;
+        }
+    }
+
+    cout << words.size() << " words" << endl;
+    run("compare chain", words, compareChain);
+    run("lookupKeyword", words, lookupKeyword);
+    return 0;
+}
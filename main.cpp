@@ -1,58 +1,277 @@
-
 #include<iostream>
-#include <fstream>
-#include "./src/lexer/lexer.h"
-#include "./src/parser/parser.h"
-#include "./src/assembly/acg.h"
+#include "./src/driver/compiler.h"
+#include "./src/driver/batch.h"
+#include "./src/driver/cache.h"
+#include "./src/driver/incremental.h"
+#include "./src/driver/server.h"
+#include "./src/interpreter/interpreter.h"
+#include "./src/assembly/encoder.h"
+#include "./src/jit/jit.h"
+#include<charconv>
+#include<chrono>
+#include<memory>
+#include<stdexcept>
 
 using namespace std;
 
+// More threads than this is a typo, not a machine
+constexpr uintmax_t MAX_JOBS = 1024;
+
+// A whole decimal number no larger than `limit`; false for anything else,
+// including one too large for uintmax_t
+static bool parseCount(string_view text, uintmax_t limit, uintmax_t &value)
+{
+    auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    return error == errc() && end == text.data() + text.size() && value <= limit;
+}
+
 int main(int argc, char *argv[])
 {
-    // Check if the correct number of arguments is provided
-    if (argc != 2)
+    // Parse the options, then exactly one input file, or any number of
+    // inputs and @manifests with --batch, or none with --serve
+    CompileOptions options;
+    bool runProgram = false;
+    bool jitProgram = false;
+    bool batch = false;
+    bool serve = false;
+    string socketPath;
+    string cacheDirectory;
+    uintmax_t cacheLimit = CompileCache::DEFAULT_SIZE_LIMIT;
+    string statePath;
+    size_t jobs = 0;
+    string outputDirectory = "./target";
+    vector<string> inputs;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++)
     {
-        cerr << "Usage: " << argv[0] << " <filename>" << endl;
-        return 1;
+        string arg = argv[i];
+        if (applyCompileOption(options, arg)) continue;
+        if (arg == "--run") runProgram = true;
+        else if (arg == "--jit") jitProgram = true;
+        else if (arg == "--batch") batch = true;
+        else if (arg == "--serve") serve = true;
+        else if (arg.rfind("--serve=", 0) == 0 && arg.size() > 8)
+        {
+            serve = true;
+            socketPath = arg.substr(8);
+        }
+        else if (arg == "--cache") cacheDirectory = "./target/cache";
+        else if (arg.rfind("--cache=", 0) == 0 && arg.size() > 8) cacheDirectory = arg.substr(8);
+        else if (arg == "--incremental") statePath = "./target/incremental.state";
+        else if (arg.rfind("--incremental=", 0) == 0 && arg.size() > 14) statePath = arg.substr(14);
+        else if (arg.rfind("--cache-limit=", 0) == 0)
+        {
+            // In megabytes, and the size in bytes has to fit too
+            constexpr uintmax_t MEGABYTE = 1024 * 1024;
+            uintmax_t megabytes;
+            valid = parseCount(string_view(arg).substr(14), UINTMAX_MAX / MEGABYTE, megabytes);
+            cacheLimit = megabytes * MEGABYTE;
+        }
+        else if (arg.rfind("--jobs=", 0) == 0)
+        {
+            uintmax_t count;
+            valid = parseCount(string_view(arg).substr(7), MAX_JOBS, count);
+            jobs = static_cast<size_t>(count);
+        }
+        else if (arg.rfind("--out-dir=", 0) == 0 && arg.size() > 10) outputDirectory = arg.substr(10);
+        else if (arg[0] == '@')
+        {
+            try
+            {
+                vector<string> listed = readManifest(arg.substr(1));
+                inputs.insert(inputs.end(), listed.begin(), listed.end());
+            }
+            catch (const runtime_error &error)
+            {
+                cerr << error.what() << endl;
+                return 1;
+            }
+        }
+        else if (arg[0] != '-') inputs.push_back(arg);
+        else valid = false;
     }
-
-    // Open the file
-    ifstream inputFile(argv[1]);
-    if (!inputFile.is_open())
+    if (serve) valid = valid && inputs.empty() && !batch && !runProgram && !jitProgram;
+    else if (batch) valid = valid && !inputs.empty() && !runProgram && !jitProgram;
+    else valid = valid && inputs.size() == 1;
+    if (!statePath.empty()) valid = valid && !serve && !batch && cacheDirectory.empty();
+    if (!valid)
     {
-        cerr << "Error opening file: " << argv[1] << endl;
+        cerr << "Usage: " << argv[0] << " [--lexer=if-chain|dfa] [-O0|-O1|-O2] [--target=x86-64|x86] [--emit=asm|obj] [--cache[=DIR]] [--cache-limit=MB] [--run|--jit] <filename>" << endl;
+        cerr << "       " << argv[0] << " --incremental[=STATE] [options] <filename>" << endl;
+        cerr << "       " << argv[0] << " --batch [--jobs=N] [--out-dir=DIR] [options] <filename|@manifest>..." << endl;
+        cerr << "       " << argv[0] << " --serve[=SOCKET] [--jobs=N] [options]" << endl;
         return 1;
     }
 
-    // // Read and print the file content
-    string input = "", line;
-    while (getline(inputFile, line))
+    if (serve)
     {
-        input += line + "\n";
+        CompileServer server(options, jobs);
+        return socketPath.empty() ? server.serveStandardStreams() : server.serveSocket(socketPath);
     }
 
-    Lexer lexer(input);
-    vector<Token> tokens = lexer.tokenize();
+    // --run and --jit need the program itself, not its outputs, so they
+    // always compile
+    unique_ptr<CompileCache> cache;
+    if (!cacheDirectory.empty() && !runProgram && !jitProgram)
+    {
+        cache = make_unique<CompileCache>(cacheDirectory, cacheLimit);
+    }
 
-    lexer.printTokenizer(tokens);
+    if (batch)
+    {
+        try
+        {
+            return compileBatch(options, inputs, outputDirectory, jobs, cache.get()) == 0 ? 0 : 1;
+        }
+        catch (const exception &error)
+        {
+            cerr << error.what() << endl;
+            return 1;
+        }
+    }
 
-    SymbolTable symTable;
+    // Every error in the program is reported before giving up
     IntermediateCodeGnerator icg;
-    Parser parser(tokens, symTable, icg);
+    Diagnostics diagnostics;
 
-    parser.parseProgram();
-    symTable.printSymbolTable();
+    // Like the cache, the saved state only stands in for the outputs
+    if (!statePath.empty() && !runProgram && !jitProgram)
+    {
+        try
+        {
+            CompileWorkspace workspace;
+            string outputPath = options.emitObject ? "./target/assembly.o" : "./target/assembly.asm";
+            if (!compileIncrementally(options, inputs[0], statePath, "./target/icg.obj", outputPath, workspace, diagnostics, cout))
+            {
+                diagnostics.print(cerr);
+                return 1;
+            }
+        }
+        catch (const exception &error)
+        {
+            cerr << "Error: " << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (cache)
+    {
+        try
+        {
+            CompileWorkspace workspace;
+            string outputPath = options.emitObject ? "./target/assembly.o" : "./target/assembly.asm";
+            if (!compileThroughCache(*cache, options, inputs[0], "./target/icg.obj", outputPath, workspace, diagnostics, cout))
+            {
+                diagnostics.print(cerr);
+                return 1;
+            }
+        }
+        catch (const exception &error)
+        {
+            cerr << "Error: " << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+    try
+    {
+        if (!compileToIntermediate(options, inputs[0].c_str(), icg, diagnostics, cout))
+        {
+            diagnostics.print(cerr);
+            return 1;
+        }
+    }
+    catch (const exception &error)
+    {
+        cerr << error.what() << endl;
+        return 1;
+    }
 
     // cout << "\nThree Address Code:" << endl;
     // icg.printInstructions();
     icg.saveInstructionsToFile("./target/icg.obj");
 
-    AssemblyCodeGenerator acg;
-    acg.generateAssembly(icg.instructions);
+    // --run executes the TAC in-process instead of generating assembly
+    if (runProgram)
+    {
+        Interpreter interpreter;
+        interpreter.load(icg);
+        auto started = chrono::steady_clock::now();
+        int32_t status;
+        try
+        {
+            status = interpreter.run();
+        }
+        catch (const runtime_error &error)
+        {
+            cerr << "Runtime error: " << error.what() << endl;
+            return 1;
+        }
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started);
+
+        cout << "\nProgram state after running:" << endl;
+        interpreter.printVariables(cout);
+        cout << "Program returned " << status << " after " << interpreter.executedInstructions()
+             << " instructions in " << elapsed.count() << " us" << endl;
+        return 0;
+    }
+
+    // --jit encodes x86-64 machine code straight into memory and calls it,
+    // with no assembly file, assembler or linker in between
+    AssemblyCodeGenerator acg(jitProgram ? Target::X86_64 : options.target, jitProgram);
+    generateCode(options, icg, acg, cout);
+
+    if (jitProgram)
+    {
+        JitProgram jit;
+        auto started = chrono::steady_clock::now();
+        int32_t status;
+        try
+        {
+            X86Encoder encoder;
+            encoder.encode(acg.instructions);
+            jit.load(encoder, acg.dataSlots);
+            status = jit.run();
+        }
+        catch (const runtime_error &error)
+        {
+            cerr << "JIT error: " << error.what() << endl;
+            return 1;
+        }
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started);
+
+        cout << "\nProgram state after running:" << endl;
+        for (OperandId id = 0; id < icg.operandKinds.size(); id++)
+        {
+            if (icg.operandKinds[id] == OperandKind::VARIABLE)
+            {
+                cout << icg.operandName(id) << " = " << jit.slotValue(id) << endl;
+            }
+        }
+        cout << "Program returned " << status << " in " << elapsed.count() << " us" << endl;
+        return 0;
+    }
 
     // cout << "\nAssembly Code:" << endl;
     // acg.printAssembly();
-    acg.saveInstructionsToFile("./target/assembly.asm");
+    if (options.emitObject)
+    {
+        // --emit=obj skips the assembly text and the external assembler
+        try
+        {
+            acg.saveObjectFile("./target/assembly.o");
+        }
+        catch (const runtime_error &error)
+        {
+            cerr << "Error: " << error.what() << endl;
+            return 1;
+        }
+    }
+    else
+    {
+        acg.saveInstructionsToFile("./target/assembly.asm");
+    }
 
     return 0;
 }
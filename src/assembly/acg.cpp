@@ -1,207 +1,513 @@
 #include "acg.h"
+#include "./encoder.h"
+#include "./elf.h"
+#include "../optimizer/cfg.h"
+#include "../optimizer/ssa.h"
+#include<cstdint>
 #include<vector>
 #include<string>
 #include<iostream>
 #include <fstream>
+#include<stdexcept>
 
 using namespace std;
 
-void AssemblyCodeGenerator::generateAssembly(const vector<string>& tacInstructions) {
-    // Start with necessary assembly directives
-    // assemblyCode.push_back("%include 'syscall.asm'  ; Include system call definitions");
-    assemblyCode.push_back("section .data");
-    // assemblyCode.push_back("    SYS_EXIT equ 1");
-    // assemblyCode.push_back("    SYS_WRITE equ 4");
-    // assemblyCode.push_back("    STDOUT equ 1");
+static bool isComparison(Opcode op) {
+    return op >= Opcode::LT && op <= Opcode::NE;
+}
+
+static Condition conditionOf(Opcode op) {
+    switch (op) {
+        case Opcode::LT: return Condition::L;
+        case Opcode::GT: return Condition::G;
+        case Opcode::LE: return Condition::LE;
+        case Opcode::GE: return Condition::GE;
+        case Opcode::EQ: return Condition::E;
+        default:         return Condition::NE;
+    }
+}
 
-    // Collect and declare variables
-    collectVariables(tacInstructions);
+// Saved by a callable function, since the allocator and division use them
+static const Register CALLEE_SAVED[] = {
+    Register::EBX, Register::EBP, Register::R12D, Register::R13D, Register::R14D, Register::R15D
+};
 
-    // Start text section
-    assemblyCode.push_back("\nsection .text");
-    assemblyCode.push_back("    global _start");
-    assemblyCode.push_back("_start:");
+// Registers handed to temporaries. Caller-saved ones come first on x86-64.
+static const vector<Register> X86_REGISTERS = {Register::ECX, Register::ESI, Register::EDI, Register::EBP};
+static const vector<Register> X86_64_REGISTERS = {
+    Register::ECX, Register::ESI, Register::EDI, Register::R8D, Register::R9D, Register::R10D,
+    Register::R11D, Register::EBP, Register::R12D, Register::R13D, Register::R14D, Register::R15D
+};
 
-    // Process each TAC instruction
-    for (const auto& instr : tacInstructions) {
-        if (instr.find(" = ") != string::npos) {
-            processAssignment(instr);
+void AssemblyCodeGenerator::generateAssembly(const IntermediateCodeGnerator& icg) {
+    operandNames = icg.operandNames;
+    instructions.clear();
+    addProgramEntry();
+    translateInstructions(icg);
+
+    // Falling off the end exits with status 0
+    if (icg.size() == 0 || icg.opcodes.back() != Opcode::RETURN) {
+        addProgramExit(AsmOperand::immediate(0));
+    }
+}
+
+void AssemblyCodeGenerator::generateFragment(const IntermediateCodeGnerator& icg) {
+    operandNames = icg.operandNames;
+    instructions.clear();
+    translateInstructions(icg);
+}
+
+void AssemblyCodeGenerator::assembleFragments(const IntermediateCodeGnerator& icg, const vector<bool> &spilled,
+                                              const vector<AsmInstruction> &body) {
+    operandNames = icg.operandNames;
+    instructions.clear();
+    allocator.registers.assign(icg.operandKinds.size(), RegisterAllocator::NO_REGISTER);
+    allocator.spilled = spilled;
+    declareVariables(icg);
+
+    addProgramEntry();
+    instructions.insert(instructions.end(), body.begin(), body.end());
+    if (icg.size() == 0 || icg.opcodes.back() != Opcode::RETURN) {
+        addProgramExit(AsmOperand::immediate(0));
+    }
+}
+
+void AssemblyCodeGenerator::addProgramEntry() {
+    if (callable) {
+        for (Register reg : CALLEE_SAVED) {
+            emit(AsmOpcode::PUSH, AsmOperand::registerOperand(reg));
+        }
+    }
+}
+
+void AssemblyCodeGenerator::translateInstructions(const IntermediateCodeGnerator& icg) {
+    // A comparison whose only use is the conditional jump right after it,
+    // possibly through one copy, becomes cmp and jcc without its 0/1 value
+    // ever being materialised
+    size_t operandCount = icg.operandKinds.size();
+    vector<uint32_t> uses(operandCount, 0);
+    vector<uint32_t> definitions(operandCount, 0);
+    for (size_t i = 0; i < icg.size(); i++) {
+        if (icg.arg1s[i] != NO_OPERAND) uses[icg.arg1s[i]]++;
+        if (icg.arg2s[i] != NO_OPERAND) uses[icg.arg2s[i]]++;
+        if (definesResult(icg.opcodes[i])) definitions[icg.results[i]]++;
+    }
+    auto singleUseTemp = [&](OperandId id) {
+        return icg.operandKinds[id] == OperandKind::TEMP && uses[id] == 1 && definitions[id] == 1;
+    };
+
+    vector<size_t> fusedJump(icg.size(), SIZE_MAX);
+    vector<bool> unmaterialised(operandCount, false);
+    for (size_t i = 0; i < icg.size(); i++) {
+        if (!isComparison(icg.opcodes[i]) || !singleUseTemp(icg.results[i])) continue;
+
+        OperandId condition = icg.results[i];
+        size_t j = i + 1;
+        if (j < icg.size() && icg.opcodes[j] == Opcode::COPY && icg.arg1s[j] == condition &&
+            singleUseTemp(icg.results[j])) {
+            condition = icg.results[j];
+            j++;
         }
-        else if (instr.find("if ") != string::npos || instr.find("agar ") != string::npos) {
-            processConditional(instr);
+        if (j < icg.size() && isConditionalJump(icg.opcodes[j]) && icg.arg1s[j] == condition) {
+            fusedJump[i] = j;
+            unmaterialised[icg.results[i]] = true;
+            unmaterialised[condition] = true;
         }
-        else if (instr.find("goto") != string::npos) {
-            processGoto(instr);
+    }
+
+    // Keep temporaries in registers where their live ranges allow
+    allocator.allocate(icg, target == Target::X86_64 ? X86_64_REGISTERS : X86_REGISTERS, unmaterialised);
+
+    // Declare every variable and spilled temporary
+    declareVariables(icg);
+
+    // Process each TAC instruction
+    for (size_t i = 0; i < icg.size(); i++) {
+        switch (icg.opcodes[i]) {
+            case Opcode::COPY:
+                translateCopy(icg, i);
+                break;
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::DIV:
+            case Opcode::AND:
+            case Opcode::OR:
+                translateBinaryOp(icg, i);
+                break;
+            case Opcode::LT:
+            case Opcode::GT:
+            case Opcode::LE:
+            case Opcode::GE:
+            case Opcode::EQ:
+            case Opcode::NE:
+                if (fusedJump[i] != SIZE_MAX) {
+                    translateFusedBranch(icg, i, fusedJump[i]);
+                    i = fusedJump[i];
+                } else {
+                    translateComparison(icg, i);
+                }
+                break;
+            case Opcode::IF_GOTO:
+            case Opcode::AGAR_GOTO:
+            case Opcode::IF_NOT_GOTO:
+                translateConditional(icg, i);
+                break;
+            case Opcode::GOTO:
+                emit(AsmOpcode::JMP, AsmOperand::label(icg.results[i]));
+                break;
+            case Opcode::LABEL:
+                emit(AsmOpcode::LABEL, AsmOperand::label(icg.results[i]));
+                break;
+            case Opcode::RETURN:
+                addProgramExit(operand(icg, icg.arg1s[i]));
+                break;
         }
-        else if (instr.find(":") != string::npos) {
-            processLabel(instr);
+    }
+}
+
+string AssemblyCodeGenerator::instructionText(const AsmInstruction &instruction) const {
+    auto text = [&](const AsmOperand &operand) -> string {
+        switch (operand.kind) {
+            case AsmOperand::REGISTER:
+                return registerName(operand.reg);
+            case AsmOperand::BYTE_REGISTER:
+                return byteRegisterName(operand.reg);
+            case AsmOperand::IMMEDIATE:
+                if (operand.id == NO_OPERAND) return to_string(operand.value);
+                return operandNames[operand.id];
+            case AsmOperand::MEMORY:
+                return "dword [" + operandNames[operand.id] + "]";
+            case AsmOperand::LABEL:
+                return operandNames[operand.id];
+            default:
+                return "";
         }
-        else if (!instr.empty()) {
-            cerr << "Unsupported TAC instruction: " << instr << endl;
+    };
+
+    string line;
+    switch (instruction.opcode) {
+        case AsmOpcode::LABEL:
+            return "\n" + text(instruction.dst) + ":";
+        case AsmOpcode::SETCC:
+            line = string("    set") + conditionName(instruction.condition) + " " + text(instruction.dst);
+            break;
+        case AsmOpcode::JCC:
+            line = string("    j") + conditionName(instruction.condition) + " " + text(instruction.dst);
+            break;
+        case AsmOpcode::JMP:
+            line = "    jmp " + text(instruction.dst);
+            break;
+        case AsmOpcode::IDIV:
+            line = "    idiv " + text(instruction.dst);
+            break;
+        case AsmOpcode::CDQ:
+            line = "    cdq";
+            break;
+        case AsmOpcode::INT:
+            line = "    int 0x80";
+            break;
+        case AsmOpcode::SYSCALL:
+            line = "    syscall";
+            break;
+        case AsmOpcode::PUSH:
+            line = string("    push ") + registerName64(instruction.dst.reg);
+            break;
+        case AsmOpcode::POP:
+            line = string("    pop ") + registerName64(instruction.dst.reg);
+            break;
+        case AsmOpcode::RET:
+            line = "    ret";
+            break;
+        default: {
+            static const char *MNEMONICS[] = {"mov", "movzx", "add", "sub", "imul", "and", "or", "cmp", "test", "xor", "shl"};
+            line = string("    ") + MNEMONICS[static_cast<uint8_t>(instruction.opcode)] + " " +
+                   text(instruction.dst) + ", " + text(instruction.src);
+            break;
         }
     }
+    if (instruction.comment != nullptr) {
+        line += string("  ; ") + instruction.comment;
+    }
+    return line;
+}
+
+void AssemblyCodeGenerator::writeAssembly(ostream &out) const {
+    if (target == Target::X86_64) {
+        out << "bits 64\n";
+        out << "default rel\n";
+    }
+
+    out << "section .data\n";
+    for (OperandId id : dataSlots) {
+        out << "    " << operandNames[id] << " dd 0\n";
+    }
 
-    // Add program exit
-    // addProgramExit();
+    const char *entry = callable ? "run" : "_start";
+    out << "\nsection .text\n";
+    out << "    global " << entry << '\n';
+    out << entry << ":\n";
+    for (const auto &instruction : instructions) {
+        out << instructionText(instruction) << '\n';
+    }
 }
 
 void AssemblyCodeGenerator::printAssembly() const {
-    for (const auto& line : assemblyCode) {
-        cout << line << endl;
-    }
+    writeAssembly(cout);
 }
 
-void AssemblyCodeGenerator::saveInstructionsToFile(const string &filename)
+bool AssemblyCodeGenerator::saveInstructionsToFile(const string &filename, ostream &log)
 {
     // Open a .obj file in text mode
     ofstream outFile(filename);
     if (!outFile.is_open())
     {
         cerr << "Error: Unable to open file for writing!" << endl;
-        return;
+        return false;
     }
 
     // Write each instruction to the file
-    for (const auto &instr : assemblyCode)
-    {
-        outFile << instr << endl;
-    }
+    writeAssembly(outFile);
 
     // Close the file
     outFile.close();
-    cout << "Generated Assembly Code is saved to file: " << filename << endl;
+    log << "Generated Assembly Code is saved to file: " << filename << endl;
+    return true;
 }
 
-void AssemblyCodeGenerator::collectVariables(const vector<string>& instructions) {
-    for (const auto& instr : instructions) {
-        // Extract variables from assignments and conditions
-        extractVariablesFromInstruction(instr);
+vector<uint8_t> AssemblyCodeGenerator::objectImage() const
+{
+    if (target != Target::X86_64)
+    {
+        throw runtime_error("object files are only written for x86-64");
     }
+    X86Encoder encoder;
+    encoder.encode(instructions);
+    ElfObjectWriter writer;
+    return writer.build(encoder, dataSlots, operandNames, callable ? "run" : "_start");
+}
 
-    // Declare collected variables
-    for (const auto& var : definedVariables) {
-        if (isNumeric(var)) {
-            // Skip numeric constants
-            continue;
-        }
-        assemblyCode.push_back("    " + var + " dd 0");
+bool AssemblyCodeGenerator::saveObjectFile(const string &filename, ostream &log)
+{
+    vector<uint8_t> image = objectImage();
+
+    // The whole object goes out in one write
+    ofstream outFile(filename, ios::binary);
+    if (!outFile.is_open())
+    {
+        cerr << "Error: Unable to open file for writing!" << endl;
+        return false;
     }
+    outFile.write(reinterpret_cast<const char *>(image.data()), static_cast<streamsize>(image.size()));
+    outFile.close();
+    log << "Generated object file is saved to file: " << filename << endl;
+    return true;
 }
 
-void AssemblyCodeGenerator::extractVariablesFromInstruction(const string& instr) {
-    // Split instruction into tokens
-    istringstream iss(instr);
-    string token;
-    while (iss >> token) {
-        // Ignore keywords and operators
-        if (token == "=" || token == "if" || token == "goto" || 
-            token == "agar" || token == "+" || token == "-" || 
-            token == "*" || token == "/" || 
-            token.back() == ':') {
-            continue;
+void AssemblyCodeGenerator::declareVariables(const IntermediateCodeGnerator& icg) {
+    // The operand table already holds each name once, in order of first use
+    dataSlots.clear();
+    for (OperandId id = 0; id < icg.operandKinds.size(); id++) {
+        OperandKind kind = icg.operandKinds[id];
+        if (kind == OperandKind::VARIABLE || (kind == OperandKind::TEMP && allocator.spilled[id])) {
+            dataSlots.push_back(id);
         }
+    }
+}
 
-        // Skip if token is a numeric constant
-        if (!isNumeric(token)) {
-            definedVariables.insert(token);
-        }
+// Register for allocated temporaries, memory for variables and spilled
+// temporaries, immediate for constants
+AsmOperand AssemblyCodeGenerator::operand(const IntermediateCodeGnerator& icg, OperandId id) const {
+    if (allocator.inRegister(id)) {
+        return AsmOperand::registerOperand(allocator.registerOf(id));
     }
+    if (icg.operandKinds[id] == OperandKind::CONSTANT) {
+        int32_t value = 0;
+        if (icg.integerConstant(id, value)) return AsmOperand::immediate(value);
+        return AsmOperand::immediate(0, id);
+    }
+    return AsmOperand::memory(id);
 }
 
-bool AssemblyCodeGenerator::isNumeric(const string& str) {
-    return str.find_first_not_of("0123456789") == string::npos;
+void AssemblyCodeGenerator::emit(AsmOpcode opcode, AsmOperand dst, AsmOperand src, const char *comment) {
+    AsmInstruction instruction;
+    instruction.opcode = opcode;
+    instruction.dst = dst;
+    instruction.src = src;
+    instruction.comment = comment;
+    instructions.push_back(instruction);
 }
 
-void AssemblyCodeGenerator::processAssignment(const string& instr) {
-    size_t eqPos = instr.find(" = ");
-    string lhs = instr.substr(0, eqPos);
-    string rhs = instr.substr(eqPos + 3);
+void AssemblyCodeGenerator::emitBranch(AsmOpcode opcode, Condition condition, OperandId label) {
+    emit(opcode, AsmOperand::label(label));
+    instructions.back().condition = condition;
+}
 
-    if (rhs.find("+") != string::npos)
-        translateBinaryOp(lhs, rhs, "add");
-    else if (rhs.find("-") != string::npos)
-        translateBinaryOp(lhs, rhs, "sub");
-    else if (rhs.find("*") != string::npos)
-        translateBinaryOp(lhs, rhs, "imul");
-    else if (rhs.find("/") != string::npos)
-        translateBinaryOp(lhs, rhs, "idiv");
-    else {
-        // Simple assignment or constant
-        assemblyCode.push_back("    mov dword [" + lhs + "], " + rhs);
+// cmp takes no immediate on the left and at most one memory operand
+void AssemblyCodeGenerator::emitCompare(AsmOperand lhs, AsmOperand rhs) {
+    if (lhs.kind == AsmOperand::IMMEDIATE || (lhs.kind == AsmOperand::MEMORY && rhs.kind == AsmOperand::MEMORY)) {
+        AsmOperand eax = AsmOperand::registerOperand(Register::EAX);
+        emit(AsmOpcode::MOV, eax, lhs);
+        lhs = eax;
     }
+    emit(AsmOpcode::CMP, lhs, rhs);
 }
 
-void AssemblyCodeGenerator::translateBinaryOp(const string& lhs, const string& rhs, const string& op) {
-    size_t opPos = rhs.find_first_of("+-*/");
-    string op1 = rhs.substr(0, opPos - 1);
-    string op2 = rhs.substr(opPos + 2);
+void AssemblyCodeGenerator::translateCopy(const IntermediateCodeGnerator& icg, size_t index) {
+    AsmOperand source = operand(icg, icg.arg1s[index]);
+    AsmOperand target = operand(icg, icg.results[index]);
 
-    assemblyCode.push_back("    mov eax, [" + op1 + "]");
-    
-    if (op == "idiv") {
-        // Division requires special handling
-        assemblyCode.push_back("    mov ebx, [" + op2 + "]");
-        assemblyCode.push_back("    cdq  ; Sign extend for division");
-        assemblyCode.push_back("    idiv ebx");
-    } else {
-        if (op == "imul") {
-            assemblyCode.push_back("    imul eax, [" + op2 + "]");
-        } else {
-            // Addition or subtraction
-            assemblyCode.push_back("    " + op + " eax, [" + op2 + "]");
-        }
+    if (source == target) return;
+    if (source.kind == AsmOperand::MEMORY && target.kind == AsmOperand::MEMORY) {
+        // Memory to memory goes through a register
+        AsmOperand eax = AsmOperand::registerOperand(Register::EAX);
+        emit(AsmOpcode::MOV, eax, source);
+        source = eax;
+    }
+    emit(AsmOpcode::MOV, target, source);
+}
+
+void AssemblyCodeGenerator::translateBinaryOp(const IntermediateCodeGnerator& icg, size_t index) {
+    AsmOperand op1 = operand(icg, icg.arg1s[index]);
+    AsmOperand op2 = operand(icg, icg.arg2s[index]);
+    AsmOperand target = operand(icg, icg.results[index]);
+    AsmOperand eax = AsmOperand::registerOperand(Register::EAX);
+
+    if (icg.opcodes[index] == Opcode::DIV) {
+        // Division requires special handling: the dividend lives in edx:eax
+        AsmOperand ebx = AsmOperand::registerOperand(Register::EBX);
+        emit(AsmOpcode::MOV, eax, op1);
+        emit(AsmOpcode::MOV, ebx, op2);
+        emit(AsmOpcode::CDQ, AsmOperand(), AsmOperand(), "Sign extend for division");
+        emit(AsmOpcode::IDIV, ebx);
+        emit(AsmOpcode::MOV, target, eax);
+        return;
+    }
+
+    Opcode op = icg.opcodes[index];
+    if (op == Opcode::AND || op == Opcode::OR) {
+        translateLogicalOp(icg, index);
+        return;
+    }
+
+    // Compute straight into an allocated target. When the second operand
+    // sits in that same register it would be overwritten first, so either
+    // swap the operands or fall back to eax.
+    bool commutative = op == Opcode::ADD || op == Opcode::MUL;
+    if (op2 == target && commutative) swap(op1, op2);
+    bool direct = target.kind == AsmOperand::REGISTER && op2 != target;
+    AsmOperand work = direct ? target : eax;
+
+    if (work != op1) {
+        emit(AsmOpcode::MOV, work, op1);
+    }
+
+    switch (op) {
+        case Opcode::MUL: emit(AsmOpcode::IMUL, work, op2); break;
+        case Opcode::SUB: emit(AsmOpcode::SUB, work, op2); break;
+        default:          emit(AsmOpcode::ADD, work, op2); break;
     }
 
-    assemblyCode.push_back("    mov dword [" + lhs + "], eax");
+    if (!direct) {
+        emit(AsmOpcode::MOV, target, eax);
+    }
+}
+
+void AssemblyCodeGenerator::emitTruth(Register reg, AsmOperand value) {
+    // reg = value != 0, as 0 or 1
+    AsmOperand full = AsmOperand::registerOperand(reg);
+    emit(AsmOpcode::MOV, full, value);
+    emit(AsmOpcode::TEST, full, full);
+    emit(AsmOpcode::SETCC, AsmOperand::byteRegister(reg));
+    instructions.back().condition = Condition::NE;
+    emit(AsmOpcode::MOVZX, full, AsmOperand::byteRegister(reg));
 }
 
-void AssemblyCodeGenerator::processConditional(const string& instr) {
-    // Support for both 'if' and 'agar' keywords
-    size_t condStart = (instr.find("if ") != string::npos) ? instr.find("if ") : instr.find("agar ");
-    size_t gotoPos = instr.find("goto");
-    string condition = instr.substr(condStart + 3, gotoPos - condStart - 3);
-    string label = instr.substr(gotoPos + 5);
+void AssemblyCodeGenerator::translateLogicalOp(const IntermediateCodeGnerator& icg, size_t index) {
+    // && and || give 0 or 1 for any operands, like the interpreter and the
+    // constant folder: a bitwise and of 2 and 1 would be 0. The operands go
+    // through the scratch registers eax and edx.
+    AsmOperand op1 = operand(icg, icg.arg1s[index]);
+    AsmOperand op2 = operand(icg, icg.arg2s[index]);
+    AsmOperand target = operand(icg, icg.results[index]);
+    AsmOperand eax = AsmOperand::registerOperand(Register::EAX);
+    AsmOperand al = AsmOperand::byteRegister(Register::EAX);
+
+    if (icg.opcodes[index] == Opcode::AND) {
+        emitTruth(Register::EAX, op1);
+        emitTruth(Register::EDX, op2);
+        emit(AsmOpcode::AND, eax, AsmOperand::registerOperand(Register::EDX));
+        if (target != eax) emit(AsmOpcode::MOV, target, eax);
+        return;
+    }
 
-    if (condition.find_first_of("<>=") == string::npos) {
-        // Boolean condition
-        assemblyCode.push_back("    cmp dword [" + condition + "], 1");
-        assemblyCode.push_back("    je " + label);
+    // a || b is (a | b) != 0
+    emit(AsmOpcode::MOV, eax, op1);
+    emit(AsmOpcode::OR, eax, op2);
+    emit(AsmOpcode::SETCC, al);
+    instructions.back().condition = Condition::NE;
+    if (target.kind == AsmOperand::REGISTER) {
+        emit(AsmOpcode::MOVZX, target, al);
+    } else {
+        emit(AsmOpcode::MOVZX, eax, al);
+        emit(AsmOpcode::MOV, target, eax);
     }
-    else {
-        // Relational condition
-        size_t opPos = condition.find_first_of("<>=");
-        string op1 = condition.substr(0, opPos - 1);
-        string op2 = condition.substr(opPos + 2);
-        string compOp = condition.substr(opPos, 1);
+}
 
-        assemblyCode.push_back("    mov eax, [" + op1 + "]");
-        assemblyCode.push_back("    cmp eax, [" + op2 + "]");
+void AssemblyCodeGenerator::translateComparison(const IntermediateCodeGnerator& icg, size_t index) {
+    // Relational results are stored as 0 or 1. setcc needs a byte register,
+    // which most of the allocatable registers lack, so the flag always goes
+    // through al.
+    emitCompare(operand(icg, icg.arg1s[index]), operand(icg, icg.arg2s[index]));
+    emit(AsmOpcode::SETCC, AsmOperand::byteRegister(Register::EAX));
+    instructions.back().condition = conditionOf(icg.opcodes[index]);
 
-        if (compOp == ">")
-            assemblyCode.push_back("    jg " + label);
-        else if (compOp == "<")
-            assemblyCode.push_back("    jl " + label);
-        else if (compOp == "=")
-            assemblyCode.push_back("    je " + label);
+    AsmOperand target = operand(icg, icg.results[index]);
+    if (target.kind == AsmOperand::REGISTER) {
+        emit(AsmOpcode::MOVZX, target, AsmOperand::byteRegister(Register::EAX));
+    } else {
+        AsmOperand eax = AsmOperand::registerOperand(Register::EAX);
+        emit(AsmOpcode::MOVZX, eax, AsmOperand::byteRegister(Register::EAX));
+        emit(AsmOpcode::MOV, target, eax);
     }
 }
 
-void AssemblyCodeGenerator::processLabel(const string& instr) {
-    // Remove whitespace and ensure proper label format
-    string trimmedLabel = regex_replace(instr, regex("^\\s+|\\s+$"), "");
-    assemblyCode.push_back("\n" + trimmedLabel);
+void AssemblyCodeGenerator::translateFusedBranch(const IntermediateCodeGnerator& icg, size_t compare, size_t jump) {
+    Condition condition = conditionOf(icg.opcodes[compare]);
+    if (icg.opcodes[jump] == Opcode::IF_NOT_GOTO) condition = invert(condition);
+
+    emitCompare(operand(icg, icg.arg1s[compare]), operand(icg, icg.arg2s[compare]));
+    emitBranch(AsmOpcode::JCC, condition, icg.results[jump]);
 }
 
-void AssemblyCodeGenerator::processGoto(const string& instr) {
-    size_t gotoPos = instr.find("goto");
-    string label = instr.substr(gotoPos + 5);
-    assemblyCode.push_back("    jmp " + label);
+void AssemblyCodeGenerator::translateConditional(const IntermediateCodeGnerator& icg, size_t index) {
+    // Support for both 'if' and 'agar' keywords; the condition is a 0/1 value
+    AsmOperand condition = operand(icg, icg.arg1s[index]);
+    if (condition.kind == AsmOperand::REGISTER) {
+        emit(AsmOpcode::TEST, condition, condition);
+    } else {
+        emitCompare(condition, AsmOperand::immediate(0));
+    }
+    Condition jump = icg.opcodes[index] == Opcode::IF_NOT_GOTO ? Condition::E : Condition::NE;
+    emitBranch(AsmOpcode::JCC, jump, icg.results[index]);
 }
 
-void AssemblyCodeGenerator::addProgramExit() {
-    // Add standard exit syscall
-    assemblyCode.push_back("\n    ; Exit program");
-    assemblyCode.push_back("    mov eax, SYS_EXIT");
-    assemblyCode.push_back("    xor ebx, ebx  ; Exit code 0");
-    assemblyCode.push_back("    int 0x80");
-}
\ No newline at end of file
+void AssemblyCodeGenerator::addProgramExit(AsmOperand status) {
+    // exit(status): Linux system call 60 through syscall on x86-64, 1
+    // through int 0x80 on x86. A callable function returns it instead.
+    if (callable) {
+        emit(AsmOpcode::MOV, AsmOperand::registerOperand(Register::EAX), status, "return status");
+        for (size_t i = size(CALLEE_SAVED); i-- > 0;) {
+            emit(AsmOpcode::POP, AsmOperand::registerOperand(CALLEE_SAVED[i]));
+        }
+        emit(AsmOpcode::RET);
+    } else if (target == Target::X86_64) {
+        emit(AsmOpcode::MOV, AsmOperand::registerOperand(Register::EDI), status, "exit status");
+        emit(AsmOpcode::MOV, AsmOperand::registerOperand(Register::EAX), AsmOperand::immediate(60), "exit");
+        emit(AsmOpcode::SYSCALL);
+    } else {
+        emit(AsmOpcode::MOV, AsmOperand::registerOperand(Register::EBX), status, "exit status");
+        emit(AsmOpcode::MOV, AsmOperand::registerOperand(Register::EAX), AsmOperand::immediate(1), "exit");
+        emit(AsmOpcode::INT, AsmOperand::immediate(0x80));
+    }
+}
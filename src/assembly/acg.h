@@ -1,43 +1,98 @@
-
 #ifndef ASSEMBLY_CODE_GENERATOR_H
 #define ASSEMBLY_CODE_GENERATOR_H
-#include<unordered_set>
-#include <regex>
 #include<string>
+#include<vector>
 #include<iostream>
+#include "../intermediate/icg.h"
+#include "./regAlloc.h"
+#include "./x86.h"
 
 using namespace std;
 
 class AssemblyCodeGenerator {
     public:
-        vector<string> assemblyCode;
-        unordered_set<string> definedVariables;
+        explicit AssemblyCodeGenerator(Target target = Target::X86_64, bool callable = false)
+            : target(target), callable(callable) {}
+
+        Target target;
+
+        // x86-64 only: generate a System V function `run` that returns the
+        // program's status in eax, instead of a _start that exits
+        bool callable;
+
+        // Variables and spilled temporaries that get a dword in .data
+        vector<OperandId> dataSlots;
+
+        vector<AsmInstruction> instructions;
 
-        void generateAssembly(const vector<string>& tacInstructions);
+        void generateAssembly(const IntermediateCodeGnerator& icg);
+
+        // Code for part of a program, without the entry and exit around it
+        // or its .data slots. At -O0 no temporary outlives the top-level
+        // statement that made it, so statements can be generated one at a
+        // time and put back together with assembleFragments(); the result
+        // is what generateAssembly() gives for the whole program.
+        void generateFragment(const IntermediateCodeGnerator& icg);
+
+        // The program whose intermediate code is `icg`, from its fragments'
+        // instructions concatenated in `body` with operand ids of `icg`.
+        // `spilled` flags the temporaries the fragments put in memory.
+        void assembleFragments(const IntermediateCodeGnerator& icg, const vector<bool> &spilled,
+                               const vector<AsmInstruction> &body);
+
+        // NASM text of one instruction, as written to the .asm file
+        string instructionText(const AsmInstruction &instruction) const;
 
         void printAssembly() const;
 
-        void saveInstructionsToFile(const string &filename);
+        // The .asm file's contents
+        void writeAssembly(ostream &out) const;
+
+        // The relocatable ELF64 object saveObjectFile writes; x86-64 only.
+        // Throws runtime_error for what has no machine encoding
+        vector<uint8_t> objectImage() const;
+
+        bool saveInstructionsToFile(const string &filename, ostream &log = cout);
+
+        // objectImage(), in one write
+        bool saveObjectFile(const string &filename, ostream &log = cout);
 
     private:
-        void collectVariables(const vector<string>& instructions);
+        RegisterAllocator allocator;
+
+        // Spelling of every operand id, kept for printing after the
+        // intermediate code is gone
+        vector<string> operandNames;
+
+        void declareVariables(const IntermediateCodeGnerator& icg);
+
+        void translateInstructions(const IntermediateCodeGnerator& icg);
+
+        void addProgramEntry();
+
+        AsmOperand operand(const IntermediateCodeGnerator& icg, OperandId id) const;
+
+        void emit(AsmOpcode opcode, AsmOperand dst = AsmOperand(), AsmOperand src = AsmOperand(), const char *comment = nullptr);
+
+        void emitBranch(AsmOpcode opcode, Condition condition, OperandId label);
 
-        void extractVariablesFromInstruction(const string& instr);
+        void emitCompare(AsmOperand lhs, AsmOperand rhs);
 
-        bool isNumeric(const string& str);
+        void translateCopy(const IntermediateCodeGnerator& icg, size_t index);
 
-        void processAssignment(const string& instr);
+        void translateBinaryOp(const IntermediateCodeGnerator& icg, size_t index);
 
-        void translateBinaryOp(const string& lhs, const string& rhs, const string& op);
+        void translateLogicalOp(const IntermediateCodeGnerator& icg, size_t index);
 
-        void processConditional(const string& instr);
+        void emitTruth(Register reg, AsmOperand value);
 
-        void processLabel(const string& instr);
+        void translateComparison(const IntermediateCodeGnerator& icg, size_t index);
 
-        void processGoto(const string& instr);
+        void translateFusedBranch(const IntermediateCodeGnerator& icg, size_t compare, size_t jump);
 
+        void translateConditional(const IntermediateCodeGnerator& icg, size_t index);
 
-        void addProgramExit();
+        void addProgramExit(AsmOperand status);
     };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,184 @@
+#include "./elf.h"
+#include<algorithm>
+#include<stdexcept>
+using namespace std;
+
+// Constants from the System V ABI and its x86-64 supplement
+static constexpr uint16_t ET_REL = 1;
+static constexpr uint16_t EM_X86_64 = 62;
+static constexpr uint32_t SHT_PROGBITS = 1;
+static constexpr uint32_t SHT_SYMTAB = 2;
+static constexpr uint32_t SHT_STRTAB = 3;
+static constexpr uint32_t SHT_RELA = 4;
+static constexpr uint64_t SHF_WRITE = 0x1;
+static constexpr uint64_t SHF_ALLOC = 0x2;
+static constexpr uint64_t SHF_EXECINSTR = 0x4;
+static constexpr uint64_t SHF_INFO_LINK = 0x40;
+static constexpr uint8_t STB_LOCAL = 0;
+static constexpr uint8_t STB_GLOBAL = 1;
+static constexpr uint8_t STT_OBJECT = 1;
+static constexpr uint8_t STT_FUNC = 2;
+static constexpr uint8_t STT_SECTION = 3;
+static constexpr uint32_t R_X86_64_PC32 = 2;
+
+static constexpr size_t HEADER_SIZE = 64;
+static constexpr size_t SECTION_HEADER_SIZE = 64;
+static constexpr size_t SYMBOL_SIZE = 24;
+static constexpr size_t RELA_SIZE = 24;
+
+// Section indices, in the order the headers are written
+enum : uint16_t { NULL_SECTION, TEXT, DATA, SYMTAB, STRTAB, RELA_TEXT, SHSTRTAB, SECTION_COUNT };
+
+namespace {
+
+// Little-endian output, whatever the host
+struct ByteWriter
+{
+    vector<uint8_t> &out;
+
+    void u8(uint8_t value) { out.push_back(value); }
+    void u16(uint16_t value) { for (int k = 0; k < 2; k++) out.push_back(static_cast<uint8_t>(value >> (8 * k))); }
+    void u32(uint32_t value) { for (int k = 0; k < 4; k++) out.push_back(static_cast<uint8_t>(value >> (8 * k))); }
+    void u64(uint64_t value) { for (int k = 0; k < 8; k++) out.push_back(static_cast<uint8_t>(value >> (8 * k))); }
+    void align(size_t alignment) { while (out.size() % alignment != 0) out.push_back(0); }
+};
+
+// A string table: starts with the empty name, and add() returns offsets
+struct StringTable
+{
+    string bytes = string(1, '\0');
+
+    uint32_t add(const string &name)
+    {
+        uint32_t offset = static_cast<uint32_t>(bytes.size());
+        bytes += name;
+        bytes += '\0';
+        return offset;
+    }
+};
+
+struct Section
+{
+    uint32_t name = 0;
+    uint32_t type = 0;
+    uint64_t flags = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t link = 0;
+    uint32_t info = 0;
+    uint64_t alignment = 0;
+    uint64_t entrySize = 0;
+};
+
+void writeSymbol(ByteWriter &writer, uint32_t name, uint8_t binding, uint8_t type, uint16_t section, uint64_t value, uint64_t size)
+{
+    writer.u32(name);
+    writer.u8(static_cast<uint8_t>((binding << 4) | type));
+    writer.u8(0);   // default visibility
+    writer.u16(section);
+    writer.u64(value);
+    writer.u64(size);
+}
+
+}
+
+vector<uint8_t> ElfObjectWriter::build(const X86Encoder &code, const vector<OperandId> &dataSlots,
+                                       const vector<string> &operandNames, const string &entry) const
+{
+    vector<uint8_t> image;
+    ByteWriter writer{image};
+    Section sections[SECTION_COUNT];
+    StringTable sectionNames;
+    StringTable symbolNames;
+
+    // The header is patched in at the end, once the offsets are known
+    image.resize(HEADER_SIZE);
+
+    writer.align(16);
+    sections[TEXT] = {sectionNames.add(".text"), SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, image.size(), code.bytes.size(), 0, 0, 16, 0};
+    image.insert(image.end(), code.bytes.begin(), code.bytes.end());
+
+    writer.align(4);
+    sections[DATA] = {sectionNames.add(".data"), SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, image.size(), dataSlots.size() * 4, 0, 0, 4, 0};
+    image.resize(image.size() + dataSlots.size() * 4, 0);
+
+    // Symbols: the null one, one per section that holds something, a local
+    // per .data slot, then the entry point as the only global
+    writer.align(8);
+    uint64_t symbolsStart = image.size();
+    writeSymbol(writer, 0, STB_LOCAL, 0, 0, 0, 0);
+    writeSymbol(writer, 0, STB_LOCAL, STT_SECTION, TEXT, 0, 0);
+    writeSymbol(writer, 0, STB_LOCAL, STT_SECTION, DATA, 0, 0);
+    const uint32_t FIRST_SLOT_SYMBOL = 3;
+    vector<uint32_t> slotSymbols(operandNames.size(), 0);
+    for (size_t slot = 0; slot < dataSlots.size(); slot++)
+    {
+        OperandId id = dataSlots[slot];
+        slotSymbols[id] = FIRST_SLOT_SYMBOL + static_cast<uint32_t>(slot);
+        writeSymbol(writer, symbolNames.add(operandNames[id]), STB_LOCAL, STT_OBJECT, DATA, slot * 4, 4);
+    }
+    uint32_t firstGlobal = FIRST_SLOT_SYMBOL + static_cast<uint32_t>(dataSlots.size());
+    writeSymbol(writer, symbolNames.add(entry), STB_GLOBAL, STT_FUNC, TEXT, 0, code.bytes.size());
+    sections[SYMTAB] = {sectionNames.add(".symtab"), SHT_SYMTAB, 0, symbolsStart, image.size() - symbolsStart,
+                        STRTAB, firstGlobal, 8, SYMBOL_SIZE};
+
+    sections[STRTAB] = {sectionNames.add(".strtab"), SHT_STRTAB, 0, image.size(), symbolNames.bytes.size(), 0, 0, 1, 0};
+    image.insert(image.end(), symbolNames.bytes.begin(), symbolNames.bytes.end());
+
+    writer.align(8);
+    uint64_t relocationsStart = image.size();
+    for (const Relocation &relocation : code.relocations)
+    {
+        if (relocation.symbol >= slotSymbols.size() || slotSymbols[relocation.symbol] == 0)
+        {
+            throw runtime_error("machine code refers to an operand without a .data slot");
+        }
+        writer.u64(relocation.offset);
+        writer.u64((static_cast<uint64_t>(slotSymbols[relocation.symbol]) << 32) | R_X86_64_PC32);
+        writer.u64(static_cast<uint64_t>(static_cast<int64_t>(relocation.addend)));
+    }
+    sections[RELA_TEXT] = {sectionNames.add(".rela.text"), SHT_RELA, SHF_INFO_LINK, relocationsStart,
+                           image.size() - relocationsStart, SYMTAB, TEXT, 8, RELA_SIZE};
+
+    // Named last so that its own name is in it
+    uint32_t shstrtabName = sectionNames.add(".shstrtab");
+    sections[SHSTRTAB] = {shstrtabName, SHT_STRTAB, 0, image.size(), sectionNames.bytes.size(), 0, 0, 1, 0};
+    image.insert(image.end(), sectionNames.bytes.begin(), sectionNames.bytes.end());
+
+    writer.align(8);
+    uint64_t sectionHeadersStart = image.size();
+    for (const Section &section : sections)
+    {
+        writer.u32(section.name);
+        writer.u32(section.type);
+        writer.u64(section.flags);
+        writer.u64(0);  // address, none until linked
+        writer.u64(section.offset);
+        writer.u64(section.size);
+        writer.u32(section.link);
+        writer.u32(section.info);
+        writer.u64(section.alignment);
+        writer.u64(section.entrySize);
+    }
+
+    vector<uint8_t> header;
+    ByteWriter headerWriter{header};
+    const uint8_t IDENT[16] = {0x7F, 'E', 'L', 'F', 2 /* 64-bit */, 1 /* little-endian */, 1 /* version */, 0 /* System V */};
+    header.insert(header.end(), IDENT, IDENT + 16);
+    headerWriter.u16(ET_REL);
+    headerWriter.u16(EM_X86_64);
+    headerWriter.u32(1);
+    headerWriter.u64(0);    // entry
+    headerWriter.u64(0);    // program headers
+    headerWriter.u64(sectionHeadersStart);
+    headerWriter.u32(0);    // flags
+    headerWriter.u16(HEADER_SIZE);
+    headerWriter.u16(0);    // program header size and count
+    headerWriter.u16(0);
+    headerWriter.u16(SECTION_HEADER_SIZE);
+    headerWriter.u16(SECTION_COUNT);
+    headerWriter.u16(SHSTRTAB);
+    copy(header.begin(), header.end(), image.begin());
+
+    return image;
+}
@@ -0,0 +1,23 @@
+#ifndef ELF_H
+#define ELF_H
+#include<cstdint>
+#include<string>
+#include<vector>
+#include "./encoder.h"
+using namespace std;
+
+// Builds a relocatable ELF64 x86-64 object from encoded machine code, the
+// same object NASM would make of the assembly file.
+//
+// Sections are .text, .data (a zeroed dword per slot), .symtab, .strtab,
+// .rela.text and .shstrtab. Every .data slot gets a local symbol under its
+// operand's name, and the encoder's relocations become R_X86_64_PC32
+// entries against those symbols. The entry point is the only global.
+class ElfObjectWriter
+{
+public:
+    vector<uint8_t> build(const X86Encoder &code, const vector<OperandId> &dataSlots,
+                          const vector<string> &operandNames, const string &entry) const;
+};
+
+#endif
@@ -0,0 +1,283 @@
+#include "./encoder.h"
+#include<stdexcept>
+using namespace std;
+
+static constexpr uint32_t NO_OFFSET = 0xFFFFFFFFu;
+
+static uint8_t number(const AsmOperand &operand)
+{
+    return static_cast<uint8_t>(operand.reg);
+}
+
+static bool fitsInByte(const AsmOperand &operand)
+{
+    return operand.value >= -128 && operand.value <= 127;
+}
+
+void X86Encoder::byte(uint8_t value)
+{
+    bytes.push_back(value);
+}
+
+void X86Encoder::dword(uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) bytes.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+// REX prefix, only when the reg field or a register rm needs r8 to r15
+void X86Encoder::rex(uint8_t reg, const AsmOperand &rm)
+{
+    bool extendReg = reg >= 8;
+    bool extendRm = (rm.kind == AsmOperand::REGISTER || rm.kind == AsmOperand::BYTE_REGISTER) && number(rm) >= 8;
+    if (extendReg || extendRm) byte(0x40 | (extendReg << 2) | extendRm);
+}
+
+// ModRM byte, plus a RIP-relative displacement for memory. `trailing` is
+// the number of immediate bytes that follow, which the displacement has
+// to skip since RIP points past them.
+void X86Encoder::modrm(uint8_t reg, const AsmOperand &rm, int trailing)
+{
+    switch (rm.kind)
+    {
+        case AsmOperand::REGISTER:
+        case AsmOperand::BYTE_REGISTER:
+            byte(0xC0 | ((reg & 7) << 3) | (number(rm) & 7));
+            break;
+        case AsmOperand::MEMORY:
+            byte(((reg & 7) << 3) | 5);
+            relocations.push_back({static_cast<uint32_t>(bytes.size()), rm.id, -4 - trailing});
+            dword(0);
+            break;
+        default:
+            throw runtime_error("operand has no ModRM encoding");
+    }
+}
+
+void X86Encoder::immediate32(const AsmOperand &operand)
+{
+    if (operand.id != NO_OPERAND) throw runtime_error("a constant that is not an integer has no machine encoding");
+    dword(static_cast<uint32_t>(operand.value));
+}
+
+void X86Encoder::labelReference(const AsmOperand &label)
+{
+    labelUses.push_back({static_cast<uint32_t>(bytes.size()), label.id});
+    dword(0);
+}
+
+void X86Encoder::encodeMov(const AsmInstruction &instruction)
+{
+    const AsmOperand &dst = instruction.dst;
+    const AsmOperand &src = instruction.src;
+    if (dst.kind == AsmOperand::REGISTER && src.kind == AsmOperand::IMMEDIATE)
+    {
+        rex(0, dst);
+        byte(0xB8 + (number(dst) & 7));
+        immediate32(src);
+    }
+    else if (dst.kind == AsmOperand::MEMORY && src.kind == AsmOperand::IMMEDIATE)
+    {
+        byte(0xC7);
+        modrm(0, dst, 4);
+        immediate32(src);
+    }
+    else if (src.kind == AsmOperand::REGISTER)
+    {
+        rex(number(src), dst);
+        byte(0x89);
+        modrm(number(src), dst, 0);
+    }
+    else if (dst.kind == AsmOperand::REGISTER && src.kind == AsmOperand::MEMORY)
+    {
+        rex(number(dst), src);
+        byte(0x8B);
+        modrm(number(dst), src, 0);
+    }
+    else
+    {
+        throw runtime_error("mov has no encoding for these operands");
+    }
+}
+
+// add, or, and, sub, xor and cmp share their encodings, told apart by the
+// extension in the ModRM reg field
+void X86Encoder::encodeAlu(uint8_t extension, const AsmInstruction &instruction)
+{
+    const AsmOperand &dst = instruction.dst;
+    const AsmOperand &src = instruction.src;
+    if (src.kind == AsmOperand::IMMEDIATE)
+    {
+        rex(0, dst);
+        if (src.id == NO_OPERAND && fitsInByte(src))
+        {
+            byte(0x83);
+            modrm(extension, dst, 1);
+            byte(static_cast<uint8_t>(src.value));
+        }
+        else
+        {
+            byte(0x81);
+            modrm(extension, dst, 4);
+            immediate32(src);
+        }
+    }
+    else if (src.kind == AsmOperand::REGISTER)
+    {
+        rex(number(src), dst);
+        byte(extension * 8 + 1);
+        modrm(number(src), dst, 0);
+    }
+    else if (dst.kind == AsmOperand::REGISTER && src.kind == AsmOperand::MEMORY)
+    {
+        rex(number(dst), src);
+        byte(extension * 8 + 3);
+        modrm(number(dst), src, 0);
+    }
+    else
+    {
+        throw runtime_error("arithmetic has no encoding for these operands");
+    }
+}
+
+void X86Encoder::encodeInstruction(const AsmInstruction &instruction)
+{
+    const AsmOperand &dst = instruction.dst;
+    const AsmOperand &src = instruction.src;
+    uint8_t cc = static_cast<uint8_t>(instruction.condition);
+
+    switch (instruction.opcode)
+    {
+        case AsmOpcode::MOV: encodeMov(instruction); break;
+        case AsmOpcode::ADD: encodeAlu(0, instruction); break;
+        case AsmOpcode::OR:  encodeAlu(1, instruction); break;
+        case AsmOpcode::AND: encodeAlu(4, instruction); break;
+        case AsmOpcode::SUB: encodeAlu(5, instruction); break;
+        case AsmOpcode::XOR: encodeAlu(6, instruction); break;
+        case AsmOpcode::CMP: encodeAlu(7, instruction); break;
+
+        case AsmOpcode::MOVZX:
+            rex(number(dst), src);
+            byte(0x0F);
+            byte(0xB6);
+            modrm(number(dst), src, 0);
+            break;
+
+        case AsmOpcode::TEST:
+            if (src.kind != AsmOperand::REGISTER) throw runtime_error("test has no encoding for these operands");
+            rex(number(src), dst);
+            byte(0x85);
+            modrm(number(src), dst, 0);
+            break;
+
+        case AsmOpcode::IMUL:
+            if (dst.kind != AsmOperand::REGISTER) throw runtime_error("imul needs a register destination");
+            if (src.kind == AsmOperand::IMMEDIATE)
+            {
+                rex(number(dst), dst);
+                if (src.id == NO_OPERAND && fitsInByte(src))
+                {
+                    byte(0x6B);
+                    modrm(number(dst), dst, 1);
+                    byte(static_cast<uint8_t>(src.value));
+                }
+                else
+                {
+                    byte(0x69);
+                    modrm(number(dst), dst, 4);
+                    immediate32(src);
+                }
+            }
+            else
+            {
+                rex(number(dst), src);
+                byte(0x0F);
+                byte(0xAF);
+                modrm(number(dst), src, 0);
+            }
+            break;
+
+        case AsmOpcode::SHL:
+            rex(0, dst);
+            byte(0xC1);
+            modrm(4, dst, 1);
+            byte(static_cast<uint8_t>(src.value));
+            break;
+
+        case AsmOpcode::SETCC:
+            rex(0, dst);
+            byte(0x0F);
+            byte(0x90 + cc);
+            modrm(0, dst, 0);
+            break;
+
+        case AsmOpcode::CDQ:
+            byte(0x99);
+            break;
+
+        case AsmOpcode::IDIV:
+            rex(0, dst);
+            byte(0xF7);
+            modrm(7, dst, 0);
+            break;
+
+        case AsmOpcode::JMP:
+            byte(0xE9);
+            labelReference(dst);
+            break;
+
+        case AsmOpcode::JCC:
+            byte(0x0F);
+            byte(0x80 + cc);
+            labelReference(dst);
+            break;
+
+        case AsmOpcode::LABEL:
+            if (dst.id >= labelOffsets.size()) labelOffsets.resize(dst.id + 1, NO_OFFSET);
+            labelOffsets[dst.id] = static_cast<uint32_t>(bytes.size());
+            break;
+
+        case AsmOpcode::INT:
+            byte(0xCD);
+            byte(static_cast<uint8_t>(dst.value));
+            break;
+
+        case AsmOpcode::SYSCALL:
+            byte(0x0F);
+            byte(0x05);
+            break;
+
+        case AsmOpcode::PUSH:
+        case AsmOpcode::POP:
+            if (number(dst) >= 8) byte(0x41);
+            byte((instruction.opcode == AsmOpcode::PUSH ? 0x50 : 0x58) + (number(dst) & 7));
+            break;
+
+        case AsmOpcode::RET:
+            byte(0xC3);
+            break;
+    }
+}
+
+void X86Encoder::encode(const vector<AsmInstruction> &code)
+{
+    bytes.clear();
+    relocations.clear();
+    labelUses.clear();
+    labelOffsets.clear();
+
+    for (const AsmInstruction &instruction : code)
+    {
+        encodeInstruction(instruction);
+    }
+
+    // rel32 counts from the end of the field
+    for (const LabelUse &use : labelUses)
+    {
+        if (use.label >= labelOffsets.size() || labelOffsets[use.label] == NO_OFFSET)
+        {
+            throw runtime_error("jump to a label that is never placed");
+        }
+        uint32_t displacement = labelOffsets[use.label] - (use.offset + 4);
+        for (int k = 0; k < 4; k++) bytes[use.offset + k] = static_cast<uint8_t>(displacement >> (8 * k));
+    }
+}
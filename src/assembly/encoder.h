@@ -0,0 +1,57 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+#include<cstdint>
+#include<vector>
+#include "./x86.h"
+using namespace std;
+
+// A 32-bit field at `offset` in the code that must hold
+// address(symbol) + addend - address(field), i.e. R_X86_64_PC32
+struct Relocation
+{
+    uint32_t offset;
+    OperandId symbol;   // variable or temporary with a .data slot
+    int32_t addend;
+};
+
+// Encodes x86-64 machine code for the generator's instructions, without
+// going through assembly text.
+//
+// Memory operands are RIP-relative, so the code runs wherever it is
+// placed. Jumps to labels are resolved here, always in their rel32 forms.
+// References to .data slots are left as relocations for whoever places
+// the data: the JIT patches them and the object writer emits them.
+//
+// Throws runtime_error for what has no encoding, which is an immediate
+// that is not an integer (e.g. a string literal) or a jump to a missing
+// label.
+class X86Encoder
+{
+public:
+    vector<uint8_t> bytes;
+    vector<Relocation> relocations;
+
+    void encode(const vector<AsmInstruction> &code);
+
+private:
+    struct LabelUse
+    {
+        uint32_t offset;
+        OperandId label;
+    };
+    vector<LabelUse> labelUses;
+    vector<uint32_t> labelOffsets;  // by OperandId
+
+    void byte(uint8_t value);
+    void dword(uint32_t value);
+    void rex(uint8_t reg, const AsmOperand &rm);
+    void modrm(uint8_t reg, const AsmOperand &rm, int trailing);
+    void immediate32(const AsmOperand &operand);
+    void labelReference(const AsmOperand &label);
+
+    void encodeMov(const AsmInstruction &instruction);
+    void encodeAlu(uint8_t extension, const AsmInstruction &instruction);
+    void encodeInstruction(const AsmInstruction &instruction);
+};
+
+#endif
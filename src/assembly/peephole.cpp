@@ -0,0 +1,149 @@
+#include "./peephole.h"
+using namespace std;
+
+static bool isExactImmediate(const AsmOperand &operand)
+{
+    return operand.kind == AsmOperand::IMMEDIATE && operand.id == NO_OPERAND;
+}
+
+// Exponent of a power of two, or -1
+static int powerOfTwo(int32_t value)
+{
+    if (value <= 0 || (value & (value - 1)) != 0) return -1;
+    int exponent = 0;
+    while ((1 << exponent) != value) exponent++;
+    return exponent;
+}
+
+bool PeepholeOptimizer::flagsReadAfter(const vector<AsmInstruction> &code, size_t index)
+{
+    // The generator never keeps flags live across a label or jump, so the
+    // scan can stop at the end of the straight-line run
+    for (size_t i = index + 1; i < code.size(); i++)
+    {
+        switch (code[i].opcode)
+        {
+            case AsmOpcode::SETCC:
+            case AsmOpcode::JCC:
+                return true;
+            case AsmOpcode::MOV:
+            case AsmOpcode::MOVZX:
+            case AsmOpcode::CDQ:
+                continue;
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+bool PeepholeOptimizer::dropJumpsTo(vector<AsmInstruction> &code, const AsmOperand &label)
+{
+    bool dropped = false;
+    for (;;)
+    {
+        size_t k = code.size();
+        while (k > 0 && code[k - 1].opcode == AsmOpcode::LABEL) k--;
+        if (k == 0) break;
+
+        const AsmInstruction &jump = code[k - 1];
+        if ((jump.opcode != AsmOpcode::JMP && jump.opcode != AsmOpcode::JCC) || jump.dst != label) break;
+        code.erase(code.begin() + (k - 1));
+        rewrites++;
+        dropped = true;
+    }
+    return dropped;
+}
+
+bool PeepholeOptimizer::rewriteLast(vector<AsmInstruction> &code)
+{
+    if (code.size() < 2) return false;
+    AsmInstruction &first = code[code.size() - 2];
+    AsmInstruction &second = code.back();
+    if (first.opcode != AsmOpcode::MOV) return false;
+
+    // mov a, b / mov b, a: the second move changes nothing
+    if (second.opcode == AsmOpcode::MOV && second.dst == first.src && second.src == first.dst)
+    {
+        code.pop_back();
+        rewrites++;
+        return true;
+    }
+
+    // mov x, a / mov x, b: the first value is never read. xor r, r and
+    // movzx overwrite their destination in the same way.
+    bool overwrites = (second.opcode == AsmOpcode::MOV && second.src != first.dst) ||
+                      (second.opcode == AsmOpcode::XOR && second.src == second.dst) ||
+                      (second.opcode == AsmOpcode::MOVZX && second.src.reg != first.dst.reg);
+    if (overwrites && second.dst == first.dst)
+    {
+        code.erase(code.end() - 2);
+        rewrites++;
+        return true;
+    }
+    return false;
+}
+
+size_t PeepholeOptimizer::run(vector<AsmInstruction> &code)
+{
+    rewrites = 0;
+    bool changed = true;
+    while (changed)
+    {
+        size_t before = rewrites;
+        vector<AsmInstruction> out;
+        out.reserve(code.size());
+
+        for (size_t i = 0; i < code.size(); i++)
+        {
+            AsmInstruction instruction = code[i];
+
+            if (instruction.opcode == AsmOpcode::LABEL)
+            {
+                dropJumpsTo(out, instruction.dst);
+                out.push_back(instruction);
+                continue;
+            }
+
+            if (instruction.opcode == AsmOpcode::MOV && instruction.dst == instruction.src)
+            {
+                rewrites++;
+                continue;
+            }
+
+            if (instruction.opcode == AsmOpcode::IMUL && instruction.dst.kind == AsmOperand::REGISTER &&
+                isExactImmediate(instruction.src))
+            {
+                if (instruction.src.value == 1)
+                {
+                    rewrites++;
+                    continue;
+                }
+                int exponent = powerOfTwo(instruction.src.value);
+                if (exponent > 0)
+                {
+                    instruction.opcode = AsmOpcode::SHL;
+                    instruction.src = AsmOperand::immediate(exponent);
+                    rewrites++;
+                }
+            }
+
+            if (instruction.opcode == AsmOpcode::MOV && instruction.dst.kind == AsmOperand::REGISTER &&
+                isExactImmediate(instruction.src) && instruction.src.value == 0 && !flagsReadAfter(code, i))
+            {
+                instruction.opcode = AsmOpcode::XOR;
+                instruction.src = instruction.dst;
+                rewrites++;
+            }
+
+            out.push_back(instruction);
+            while (rewriteLast(out))
+            {
+            }
+        }
+
+        code.swap(out);
+        changed = rewrites != before;
+    }
+    return rewrites;
+}
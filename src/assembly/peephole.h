@@ -0,0 +1,33 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+#include<cstddef>
+#include<vector>
+#include "./x86.h"
+using namespace std;
+
+// Rewrites short windows of adjacent machine instructions:
+//
+//   mov a, b / mov b, a      drops the second move
+//   mov r, x / mov r, y      drops the first move (also before xor r, r)
+//   mov [x], a / mov [x], b  drops the first store
+//   mov r, r                 dropped
+//   imul r, 2^k              shl r, k (and imul r, 1 is dropped)
+//   mov r, 0                 xor r, r when the flags are not read
+//   jmp L / jcc L before L:  dropped
+//
+// The rules are applied until none matches.
+class PeepholeOptimizer
+{
+public:
+    // Returns the number of rewrites made
+    size_t run(vector<AsmInstruction> &code);
+
+private:
+    size_t rewrites = 0;
+
+    bool rewriteLast(vector<AsmInstruction> &code);
+    bool dropJumpsTo(vector<AsmInstruction> &code, const AsmOperand &label);
+    static bool flagsReadAfter(const vector<AsmInstruction> &code, size_t index);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "./regAlloc.h"
+#include "../optimizer/cfg.h"
+#include "../optimizer/liveness.h"
+#include "../optimizer/ssa.h"
+#include<algorithm>
+using namespace std;
+
+void RegisterAllocator::allocate(const IntermediateCodeGnerator &icg, const vector<Register> &pool, const vector<bool> &ignored)
+{
+    size_t operandCount = icg.operandKinds.size();
+    registers.assign(operandCount, NO_REGISTER);
+    spilled.assign(operandCount, false);
+
+    ControlFlowGraph cfg;
+    cfg.build(icg);
+    Liveness liveness;
+    liveness.compute(icg, cfg);
+
+    // Live range of every temporary as [start, end] instruction indices
+    const size_t NONE = SIZE_MAX;
+    vector<size_t> start(operandCount, NONE);
+    vector<size_t> end(operandCount, 0);
+    auto extend = [&](OperandId id, size_t at) {
+        if (id == NO_OPERAND || icg.operandKinds[id] != OperandKind::TEMP || ignored[id]) return;
+        if (start[id] == NONE || at < start[id]) start[id] = at;
+        if (at > end[id]) end[id] = at;
+    };
+
+    for (uint32_t b = 0; b < cfg.blocks.size(); b++)
+    {
+        const BasicBlock &block = cfg.blocks[b];
+        if (block.begin == block.end) continue;
+        for (OperandId id = 0; id < operandCount; id++)
+        {
+            if (icg.operandKinds[id] != OperandKind::TEMP || ignored[id]) continue;
+            if (Liveness::contains(liveness.liveIn[b], id)) extend(id, block.begin);
+            if (Liveness::contains(liveness.liveOut[b], id)) extend(id, block.end - 1);
+        }
+        for (size_t i = block.begin; i < block.end; i++)
+        {
+            extend(icg.arg1s[i], i);
+            extend(icg.arg2s[i], i);
+            if (definesResult(icg.opcodes[i])) extend(icg.results[i], i);
+        }
+    }
+
+    vector<OperandId> intervals;
+    for (OperandId id = 0; id < operandCount; id++)
+    {
+        if (start[id] != NONE) intervals.push_back(id);
+    }
+    sort(intervals.begin(), intervals.end(), [&](OperandId a, OperandId b) {
+        return start[a] != start[b] ? start[a] < start[b] : a < b;
+    });
+
+    // Ranges currently holding a register, ordered by end
+    vector<OperandId> active;
+    vector<size_t> slotOf(operandCount, 0);       // index into pool
+    vector<bool> freeRegisters(pool.size(), true);
+    auto byEnd = [&](OperandId a, OperandId b) { return end[a] < end[b]; };
+
+    for (OperandId current : intervals)
+    {
+        // A range that starts by being written without being read can take
+        // the register of an operand read for the last time by that same
+        // instruction; the code generator reads operands before writing.
+        size_t at = start[current];
+        bool writtenFirst = definesResult(icg.opcodes[at]) && icg.results[at] == current &&
+                            icg.arg1s[at] != current && icg.arg2s[at] != current;
+        size_t freeBefore = writtenFirst ? at + 1 : at;
+
+        // Release ranges that ended before this one starts
+        while (!active.empty() && end[active.front()] < freeBefore)
+        {
+            freeRegisters[slotOf[active.front()]] = true;
+            active.erase(active.begin());
+        }
+
+        size_t slot = pool.size();
+        for (size_t r = 0; r < pool.size(); r++)
+        {
+            if (freeRegisters[r])
+            {
+                slot = r;
+                break;
+            }
+        }
+
+        if (slot == pool.size())
+        {
+            // Spill whichever range ends last
+            OperandId last = active.back();
+            if (end[last] <= end[current])
+            {
+                spilled[current] = true;
+                continue;
+            }
+            slot = slotOf[last];
+            registers[last] = NO_REGISTER;
+            spilled[last] = true;
+            active.pop_back();
+        }
+
+        slotOf[current] = slot;
+        registers[current] = static_cast<int8_t>(pool[slot]);
+        freeRegisters[slot] = false;
+        active.insert(upper_bound(active.begin(), active.end(), current, byEnd), current);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef REGISTER_ALLOCATOR_H
+#define REGISTER_ALLOCATOR_H
+#include<cstdint>
+#include<string>
+#include<vector>
+#include "../intermediate/icg.h"
+#include "./x86.h"
+using namespace std;
+
+// Linear scan register allocation (Poletto and Sarkar) for temporaries.
+//
+// Each temporary's live range is the span of instruction indices from its
+// first definition or live-in point to its last use or live-out point.
+// Ranges are handed registers in order of their start; when none is free,
+// the range that ends last is spilled to memory. Variables always stay in
+// memory, in their .data slot; temporaries no instruction mentions any more
+// get neither.
+//
+// The caller passes the registers it may hand out; eax, ebx and edx are
+// kept out of that pool as scratch, since division and setcc need them.
+class RegisterAllocator
+{
+public:
+    static constexpr int8_t NO_REGISTER = -1;
+
+    // Register number of each operand by OperandId, or NO_REGISTER
+    vector<int8_t> registers;
+
+    // Temporaries that are live somewhere but did not get a register
+    vector<bool> spilled;
+
+    // Temporaries flagged in `ignored` are never materialised by the
+    // caller and get neither a register nor a slot
+    void allocate(const IntermediateCodeGnerator &icg, const vector<Register> &pool, const vector<bool> &ignored);
+
+    Register registerOf(OperandId id) const
+    {
+        return static_cast<Register>(registers[id]);
+    }
+
+    bool inRegister(OperandId id) const
+    {
+        return id < registers.size() && registers[id] != NO_REGISTER;
+    }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "./x86.h"
+using namespace std;
+
+static const char *REGISTER_NAMES[] = {
+    "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+    "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+
+static const char *REGISTER_NAMES_64[] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+static const char *BYTE_REGISTER_NAMES[] = {"al", "cl", "dl", "bl"};
+
+const char *registerName(Register reg)
+{
+    return REGISTER_NAMES[static_cast<uint8_t>(reg)];
+}
+
+const char *registerName64(Register reg)
+{
+    return REGISTER_NAMES_64[static_cast<uint8_t>(reg)];
+}
+
+const char *byteRegisterName(Register reg)
+{
+    return BYTE_REGISTER_NAMES[static_cast<uint8_t>(reg)];
+}
+
+const char *conditionName(Condition cc)
+{
+    switch (cc)
+    {
+        case Condition::E:  return "e";
+        case Condition::NE: return "ne";
+        case Condition::L:  return "l";
+        case Condition::GE: return "ge";
+        case Condition::LE: return "le";
+        default:            return "g";
+    }
+}
+
+AsmOperand AsmOperand::registerOperand(Register reg)
+{
+    AsmOperand operand;
+    operand.kind = REGISTER;
+    operand.reg = reg;
+    return operand;
+}
+
+AsmOperand AsmOperand::byteRegister(Register reg)
+{
+    AsmOperand operand;
+    operand.kind = BYTE_REGISTER;
+    operand.reg = reg;
+    return operand;
+}
+
+AsmOperand AsmOperand::immediate(int32_t value, OperandId id)
+{
+    AsmOperand operand;
+    operand.kind = IMMEDIATE;
+    operand.value = value;
+    operand.id = id;
+    return operand;
+}
+
+AsmOperand AsmOperand::memory(OperandId id)
+{
+    AsmOperand operand;
+    operand.kind = MEMORY;
+    operand.id = id;
+    return operand;
+}
+
+AsmOperand AsmOperand::label(OperandId id)
+{
+    AsmOperand operand;
+    operand.kind = LABEL;
+    operand.id = id;
+    return operand;
+}
+
+bool AsmOperand::operator==(const AsmOperand &other) const
+{
+    if (kind != other.kind) return false;
+    switch (kind)
+    {
+        case REGISTER:
+        case BYTE_REGISTER:
+            return reg == other.reg;
+        case IMMEDIATE:
+            return value == other.value && id == other.id;
+        case MEMORY:
+        case LABEL:
+            return id == other.id;
+        default:
+            return true;
+    }
+}
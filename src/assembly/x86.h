@@ -0,0 +1,115 @@
+#ifndef X86_H
+#define X86_H
+#include<cstdint>
+#include<string>
+#include "../intermediate/icg.h"
+using namespace std;
+
+// Machine instructions as the assembly generator produces them. They are
+// kept as small records rather than text so that later passes can inspect
+// and rewrite them; NASM text is only produced when the code is saved.
+
+enum class Target : uint8_t
+{
+    X86,            // 32-bit, exits through int 0x80
+    X86_64          // 64-bit, exits through syscall
+};
+
+// Numbered as in the instruction encoding. All arithmetic is 32-bit, so
+// only the 32-bit names are used; R8D and up exist on x86-64 only.
+enum class Register : uint8_t
+{
+    EAX, ECX, EDX, EBX, ESP, EBP, ESI, EDI,
+    R8D, R9D, R10D, R11D, R12D, R13D, R14D, R15D
+};
+
+// Condition codes, numbered as in the jcc and setcc encodings, so that
+// flipping the lowest bit negates a condition
+enum class Condition : uint8_t
+{
+    E  = 0x4,
+    NE = 0x5,
+    L  = 0xC,
+    GE = 0xD,
+    LE = 0xE,
+    G  = 0xF
+};
+
+inline Condition invert(Condition cc)
+{
+    return static_cast<Condition>(static_cast<uint8_t>(cc) ^ 1);
+}
+
+const char *registerName(Register reg);
+
+// rax, rcx, ... r15, for push and pop
+const char *registerName64(Register reg);
+
+// al, cl, dl or bl; the generator only takes the low byte of eax to ebx
+const char *byteRegisterName(Register reg);
+
+const char *conditionName(Condition cc);
+
+struct AsmOperand
+{
+    enum Kind : uint8_t
+    {
+        NONE,
+        REGISTER,
+        BYTE_REGISTER,  // low byte of reg, e.g. al
+        IMMEDIATE,      // value, or constant `id` when that is not an integer
+        MEMORY,         // dword in the .data slot of variable or temporary `id`
+        LABEL           // label `id`
+    };
+
+    Kind kind = NONE;
+    Register reg = Register::EAX;
+    int32_t value = 0;
+    OperandId id = NO_OPERAND;
+
+    static AsmOperand registerOperand(Register reg);
+    static AsmOperand byteRegister(Register reg);
+    static AsmOperand immediate(int32_t value, OperandId id = NO_OPERAND);
+    static AsmOperand memory(OperandId id);
+    static AsmOperand label(OperandId id);
+
+    bool operator==(const AsmOperand &other) const;
+    bool operator!=(const AsmOperand &other) const { return !(*this == other); }
+};
+
+enum class AsmOpcode : uint8_t
+{
+    MOV,            // dst = src
+    MOVZX,          // dst = zero extended byte src
+    ADD,            // dst += src
+    SUB,
+    IMUL,
+    AND,
+    OR,
+    CMP,            // flags from dst - src
+    TEST,           // flags from dst & src
+    XOR,            // dst ^= src
+    SHL,            // dst <<= src
+    SETCC,          // byte dst = condition
+    CDQ,            // edx:eax = sign extended eax
+    IDIV,           // eax, edx = edx:eax / dst, edx:eax % dst
+    JMP,            // jump to label dst
+    JCC,            // jump to label dst if condition
+    LABEL,          // dst:
+    INT,            // software interrupt dst
+    SYSCALL,
+    PUSH,           // push the 64-bit register dst
+    POP,
+    RET
+};
+
+struct AsmInstruction
+{
+    AsmOpcode opcode;
+    Condition condition = Condition::E;     // SETCC and JCC only
+    AsmOperand dst;
+    AsmOperand src;
+    const char *comment = nullptr;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "./arena.h"
+
+using namespace std;
+
+Arena::Arena(size_t chunkSize) : chunkSize(chunkSize), cursor(nullptr), limit(nullptr), used(0) {}
+
+void *Arena::allocate(size_t size, size_t align)
+{
+    uintptr_t at = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+    if (cursor == nullptr || at + size > reinterpret_cast<uintptr_t>(limit))
+    {
+        // Oversized requests get a chunk of their own
+        size_t bytes = size + align > chunkSize ? size + align : chunkSize;
+        chunks.emplace_back(new char[bytes]);
+        cursor = chunks.back().get();
+        limit = cursor + bytes;
+        at = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    cursor = reinterpret_cast<char *>(at + size);
+    used += size;
+    return reinterpret_cast<void *>(at);
+}
+
+void Arena::reset()
+{
+    if (chunks.size() > 1) chunks.resize(1);
+    cursor = chunks.empty() ? nullptr : chunks.front().get();
+    limit = chunks.empty() ? nullptr : cursor + chunkSize;
+    used = 0;
+}
@@ -0,0 +1,71 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Contiguous, arena-owned array. The arena never runs destructors, so
+// lists only hold trivially destructible things (node pointers, PODs).
+template <typename T>
+struct NodeList
+{
+    T *items;
+    uint32_t count;
+
+    T *begin() const { return items; }
+    T *end() const { return items + count; }
+    bool empty() const { return count == 0; }
+    T &operator[](size_t i) const { return items[i]; }
+};
+
+// Bump allocator for everything built during one compilation. Allocation
+// is a pointer increment; nothing is freed individually. reset() releases
+// all of it at once and keeps the first chunk around for the next run.
+class Arena
+{
+    public:
+        explicit Arena(size_t chunkSize = 64 * 1024);
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        void *allocate(size_t size, size_t align);
+        void reset();
+        size_t bytesUsed() const { return used; }
+
+        // Value-initialised (zeroed) object living in the arena
+        template <typename T>
+        T *make()
+        {
+            static_assert(is_trivially_destructible<T>::value, "arena objects are never destroyed");
+            return new (allocate(sizeof(T), alignof(T))) T();
+        }
+
+        template <typename T>
+        NodeList<T> makeList(const vector<T> &items)
+        {
+            static_assert(is_trivially_destructible<T>::value, "arena objects are never destroyed");
+            NodeList<T> list{nullptr, static_cast<uint32_t>(items.size())};
+            if (!items.empty())
+            {
+                list.items = static_cast<T *>(allocate(sizeof(T) * items.size(), alignof(T)));
+                for (size_t i = 0; i < items.size(); i++) new (&list.items[i]) T(items[i]);
+            }
+            return list;
+        }
+
+    private:
+        size_t chunkSize;
+        vector<unique_ptr<char[]>> chunks;
+        char *cursor;
+        char *limit;
+        size_t used;
+};
+
+#endif
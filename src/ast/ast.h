@@ -0,0 +1,196 @@
+#ifndef AST_H
+#define AST_H
+
+#include <cstdint>
+#include <string_view>
+#include "./arena.h"
+#include "../lexer/lexer.h"
+
+using namespace std;
+
+// Syntax tree produced by the Parser. Every node is allocated from the
+// compilation's Arena and released with it, so nodes only hold trivially
+// destructible members: other nodes, NodeLists and string_views. The views
+// point into the SourceBuffer or the StringPool, both of which outlive
+// the tree.
+//
+// Each node kind is its own struct deriving from Expr or Stmt; the `kind`
+// tag says which one to static_cast to.
+
+enum class ExprKind : uint8_t
+{
+    NUMBER,         // integer literal
+    FLOAT,          // floating point literal
+    BOOL,           // true / false
+    IDENTIFIER,
+    BINARY
+};
+
+struct Expr
+{
+    ExprKind kind;
+    int lineNumber;
+};
+
+// NUMBER, FLOAT and BOOL literals, spelled as in the source
+struct LiteralExpr : Expr
+{
+    string_view text;
+};
+
+struct IdentifierExpr : Expr
+{
+    string_view name;
+    uint32_t symbol;
+};
+
+struct BinaryExpr : Expr
+{
+    TokenType op;
+    Expr *lhs;
+    Expr *rhs;
+};
+
+enum class StmtKind : uint8_t
+{
+    DECLARATION,
+    ASSIGNMENT,
+    FOR_STEP,
+    IF,
+    AGAR,
+    WHILE,
+    DO_WHILE,
+    FOR,
+    SWITCH,
+    BLOCK,
+    RETURN,
+    BREAK,
+    PRINT,
+    INPUT,
+    VOID_FUNCTION
+};
+
+struct Stmt
+{
+    StmtKind kind;
+    int lineNumber;
+};
+
+// How the right-hand side of a declaration or assignment was written. A
+// bare string or boolean literal is type checked against the variable;
+// anything else is an expression.
+enum class ValueForm : uint8_t
+{
+    NONE,
+    EXPRESSION,
+    STRING,
+    BOOL
+};
+
+// `int x;`, `int x = expr;`
+struct DeclarationStmt : Stmt
+{
+    TokenType varType;
+    string_view name;
+    uint32_t symbol;
+    ValueForm form;
+    Expr *value;            // EXPRESSION
+    string_view literal;    // STRING, BOOL
+};
+
+// `x = expr;`
+struct AssignmentStmt : Stmt
+{
+    string_view name;
+    uint32_t symbol;
+    ValueForm form;
+    Expr *value;
+    string_view literal;
+};
+
+// The update clause of a for loop: `i++`, `i--` or `i = expr`
+struct ForStepStmt : Stmt
+{
+    string_view name;
+    uint32_t symbol;
+    TokenType op;           // T_PLUS, T_MINUS or T_ASSIGN
+    Expr *value;            // T_ASSIGN only
+};
+
+// `if (...) ... else ...` and `agar (...) ... magar ...`
+struct IfStmt : Stmt
+{
+    Expr *condition;
+    Stmt *thenBranch;
+    Stmt *elseBranch;       // may be null
+};
+
+struct WhileStmt : Stmt
+{
+    Expr *condition;
+    Stmt *body;
+};
+
+struct DoWhileStmt : Stmt
+{
+    Stmt *body;
+    Expr *condition;
+};
+
+struct ForStmt : Stmt
+{
+    DeclarationStmt *init;
+    Expr *condition;
+    ForStepStmt *step;
+    Stmt *body;
+};
+
+struct SwitchCase
+{
+    Expr *label;            // null for `default:`
+    NodeList<Stmt *> body;
+};
+
+struct SwitchStmt : Stmt
+{
+    Expr *subject;
+    NodeList<SwitchCase> cases;
+};
+
+struct BlockStmt : Stmt
+{
+    NodeList<Stmt *> statements;
+};
+
+struct ReturnStmt : Stmt
+{
+    Expr *value;
+};
+
+// `cout << "text";`
+struct PrintStmt : Stmt
+{
+    string_view text;
+};
+
+// `cin >> x;`
+struct InputStmt : Stmt
+{
+    string_view name;
+    uint32_t symbol;
+};
+
+// `void name() { ... }`
+struct VoidFunctionStmt : Stmt
+{
+    string_view name;
+    uint32_t symbol;
+    BlockStmt *body;
+};
+
+struct Program
+{
+    NodeList<Stmt *> statements;
+};
+
+#endif
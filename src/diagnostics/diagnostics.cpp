@@ -0,0 +1,38 @@
+#include "./diagnostics.h"
+#include<algorithm>
+#include<sstream>
+using namespace std;
+
+void Diagnostics::error(int lineNumber, string message)
+{
+    errorCount++;
+    if (reported.size() < MAX_ERRORS)
+    {
+        reported.push_back(Diagnostic{lineNumber, move(message)});
+    }
+}
+
+void Diagnostics::print(ostream &out) const
+{
+    // Lexer and parser errors arrive in line order already, semantic ones
+    // come after them from a second pass
+    vector<Diagnostic> sorted = reported;
+    stable_sort(sorted.begin(), sorted.end(),
+                [](const Diagnostic &a, const Diagnostic &b) { return a.lineNumber < b.lineNumber; });
+    for (const Diagnostic &diagnostic : sorted)
+    {
+        out << diagnostic.message << " at line " << diagnostic.lineNumber << endl;
+    }
+    if (errorCount > reported.size())
+    {
+        out << "... and " << errorCount - reported.size() << " more" << endl;
+    }
+    out << errorCount << (errorCount == 1 ? " error" : " errors") << " found" << endl;
+}
+
+string Diagnostics::summary() const
+{
+    ostringstream out;
+    print(out);
+    return out.str();
+}
@@ -0,0 +1,41 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+#include<cstddef>
+#include<iostream>
+#include<string>
+#include<vector>
+using namespace std;
+
+struct Diagnostic
+{
+    int lineNumber;
+    string message;     // e.g. "Syntax error: expected ';' but found '}'"
+};
+
+// Errors found while compiling one program. The lexer, parser and
+// lowering report here and carry on, so one run finds every error it can
+// and the caller decides what to do with them; nothing stops the process.
+class Diagnostics
+{
+public:
+    // Past this many errors the rest are only counted
+    static constexpr size_t MAX_ERRORS = 100;
+
+    void error(int lineNumber, string message);
+
+    bool hasErrors() const { return errorCount > 0; }
+    size_t count() const { return errorCount; }
+    const vector<Diagnostic> &errors() const { return reported; }
+
+    // All errors in line order, one per line, then a count
+    void print(ostream &out) const;
+
+    // Same as print, as one string
+    string summary() const;
+
+private:
+    vector<Diagnostic> reported;
+    size_t errorCount = 0;
+};
+
+#endif
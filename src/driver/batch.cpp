@@ -0,0 +1,156 @@
+#include "./batch.h"
+#include "./threadPool.h"
+#include "../lexer/sourceBuffer.h"
+#include<chrono>
+#include<filesystem>
+#include<fstream>
+#include<sstream>
+#include<stdexcept>
+#include<unordered_map>
+using namespace std;
+
+namespace {
+
+struct BatchResult
+{
+    bool succeeded = false;
+    string message;
+};
+
+// Runs one input through the whole pipeline; nothing here is shared with
+// the other inputs
+BatchResult compileOne(const CompileOptions &options, const string &input, const string &outputBase,
+                       CompileCache *cache)
+{
+    BatchResult result;
+    ostringstream log;
+    try
+    {
+        // Each worker keeps its arena and string pool from one input to
+        // the next
+        thread_local CompileWorkspace workspace;
+        if (cache)
+        {
+            Diagnostics diagnostics;
+            string outputPath = outputBase + (options.emitObject ? ".o" : ".asm");
+            result.succeeded = compileThroughCache(*cache, options, input, outputBase + ".icg.obj", outputPath,
+                                                   workspace, diagnostics, log);
+            if (!result.succeeded) result.message = diagnostics.summary();
+            return result;
+        }
+
+        SourceBuffer source;
+        if (!source.open(input.c_str()))
+        {
+            throw runtime_error("Error opening file: " + input);
+        }
+
+        IntermediateCodeGnerator icg;
+        Diagnostics diagnostics;
+        if (!compileSource(options, source.view(), workspace, icg, diagnostics, log))
+        {
+            result.message = diagnostics.summary();
+            return result;
+        }
+        if (!icg.saveInstructionsToFile(outputBase + ".icg.obj", log))
+        {
+            throw runtime_error("cannot write " + outputBase + ".icg.obj");
+        }
+
+        AssemblyCodeGenerator acg(options.target);
+        generateCode(options, icg, acg, log);
+        bool saved = options.emitObject ? acg.saveObjectFile(outputBase + ".o", log)
+                                        : acg.saveInstructionsToFile(outputBase + ".asm", log);
+        if (!saved) throw runtime_error("cannot write the output of " + input);
+        result.succeeded = true;
+    }
+    catch (const exception &error)
+    {
+        result.message = error.what();
+    }
+    return result;
+}
+
+}
+
+vector<string> readManifest(const string &filename)
+{
+    ifstream manifest(filename);
+    if (!manifest.is_open())
+    {
+        throw runtime_error("Error opening manifest: " + filename);
+    }
+    filesystem::path base = filesystem::path(filename).parent_path();
+    vector<string> inputs;
+    string line;
+    while (getline(manifest, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        filesystem::path input(line);
+        inputs.push_back(input.is_relative() ? (base / input).string() : line);
+    }
+    return inputs;
+}
+
+size_t compileBatch(const CompileOptions &options, const vector<string> &inputs,
+                    const string &outputDirectory, size_t threads, CompileCache *cache)
+{
+    // Outputs are named after the input, so two inputs with the same name
+    // in different directories would overwrite each other
+    vector<string> outputBases;
+    unordered_map<string, size_t> owners;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        string name = filesystem::path(inputs[i]).stem().string();
+        auto inserted = owners.emplace(name, i);
+        if (!inserted.second)
+        {
+            throw runtime_error("Inputs " + inputs[inserted.first->second] + " and " + inputs[i] +
+                                " would both write " + name);
+        }
+        outputBases.push_back((filesystem::path(outputDirectory) / name).string());
+    }
+    filesystem::create_directories(outputDirectory);
+
+    CompileOptions batchOptions = options;
+    batchOptions.listings = false;
+    vector<BatchResult> results(inputs.size());
+
+    auto started = chrono::steady_clock::now();
+    WorkStealingPool pool(threads);
+    pool.forEach(inputs.size(), [&](size_t i) {
+        results[i] = compileOne(batchOptions, inputs[i], outputBases[i], cache);
+    });
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started);
+
+    size_t failed = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        if (results[i].succeeded)
+        {
+            cout << inputs[i] << ": ok\n";
+        }
+        else
+        {
+            // Diagnostics come as several lines, listed under the input
+            string message = results[i].message;
+            if (!message.empty() && message.back() == '\n') message.pop_back();
+            if (message.find('\n') == string::npos)
+            {
+                cout << inputs[i] << ": " << message << '\n';
+            }
+            else
+            {
+                istringstream lines(message);
+                string line;
+                cout << inputs[i] << ":\n";
+                while (getline(lines, line)) cout << "    " << line << '\n';
+            }
+            failed++;
+        }
+    }
+    cout << "Compiled " << inputs.size() - failed << " of " << inputs.size() << " files in "
+         << elapsed.count() << " ms on " << pool.size() << " threads" << endl;
+    return failed;
+}
@@ -0,0 +1,26 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include<string>
+#include<vector>
+#include "./compiler.h"
+#include "./cache.h"
+using namespace std;
+
+// Compiles many files at once for --batch, on a work-stealing thread pool.
+//
+// Each input gets its own outputs in `outputDirectory`, named after the
+// file: <name>.icg.obj, and <name>.asm or <name>.o. Listings are not
+// printed; instead there is one line per input, in input order, with
+// its errors if it had any. With a `cache`, inputs already in it are
+// copied out instead of compiled.
+//
+// Returns the number of inputs that failed.
+size_t compileBatch(const CompileOptions &options, const vector<string> &inputs,
+                    const string &outputDirectory, size_t threads, CompileCache *cache = nullptr);
+
+// Reads the inputs listed in a manifest, one path per line, relative to
+// the manifest's directory. Blank lines and lines starting with '#' are
+// skipped. Throws runtime_error if the manifest cannot be read.
+vector<string> readManifest(const string &filename);
+
+#endif
@@ -0,0 +1,217 @@
+#include "./cache.h"
+#include "./fingerprint.h"
+#include "../lexer/sourceBuffer.h"
+#include<algorithm>
+#include<chrono>
+#include<filesystem>
+#include<fstream>
+#include<random>
+#include<sstream>
+#include<stdexcept>
+#include<vector>
+using namespace std;
+
+namespace {
+
+// Part of every key, so entries laid out differently are never read
+constexpr char FORMAT_VERSION[] = "mini-compiler cache 1";
+
+// Temporary files older than this were left by a writer that died
+constexpr auto STALE_TEMPORARY = chrono::hours(1);
+
+bool readWholeFile(const string &path, string &contents)
+{
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+    ostringstream bytes;
+    bytes << in.rdbuf();
+    contents = bytes.str();
+    return !in.bad();
+}
+
+void writeWholeFile(const string &path, const string &contents)
+{
+    ofstream out(path, ios::binary);
+    out.write(contents.data(), static_cast<streamsize>(contents.size()));
+    out.close();
+    if (!out)
+    {
+        throw runtime_error("Error writing file: " + path);
+    }
+}
+
+bool isTemporary(const filesystem::path &path)
+{
+    return path.filename().string().find(".tmp") != string::npos;
+}
+
+}
+
+CompileCache::CompileCache(string directory, uintmax_t sizeLimit)
+        : directory(move(directory)), sizeLimit(sizeLimit)
+{
+}
+
+string CompileCache::key(const CompileOptions &options, string_view source)
+{
+    // The lexer engine is left out: both produce the same tokens. The
+    // listings only go to the log, never into the outputs
+    Fnv128 hash;
+    hash.add(string_view(FORMAT_VERSION, sizeof FORMAT_VERSION));
+    hash.add(compilerIdentity());
+    hash.add(options.optimizationLevel);
+    hash.add(static_cast<int64_t>(options.target));
+    hash.add(options.emitObject ? 1 : 0);
+    hash.add(static_cast<int64_t>(source.size()));
+    hash.add(source);
+    return hash.hex();
+}
+
+string CompileCache::entryPath(const string &key) const
+{
+    return (filesystem::path(directory) / key.substr(0, 2) / key.substr(2)).string();
+}
+
+bool CompileCache::lookup(const string &key, CompiledOutputs &outputs) const
+{
+    string path = entryPath(key);
+    string entry;
+    if (!readWholeFile(path, entry)) return false;
+
+    // "<icg bytes> <output bytes>\n" and then both outputs
+    size_t newline = entry.find('\n');
+    if (newline == string::npos) return false;
+    istringstream header(entry.substr(0, newline));
+    size_t intermediateSize;
+    size_t outputSize;
+    if (!(header >> intermediateSize >> outputSize)) return false;
+    size_t body = newline + 1;
+    if (entry.size() - body != intermediateSize + outputSize) return false;
+
+    outputs.intermediate.assign(entry, body, intermediateSize);
+    outputs.output.assign(entry, body + intermediateSize, outputSize);
+
+    // Recently used entries are the last to be evicted
+    error_code ignored;
+    filesystem::last_write_time(path, filesystem::file_time_type::clock::now(), ignored);
+    return true;
+}
+
+bool CompileCache::store(const string &key, const CompiledOutputs &outputs)
+{
+    string path = entryPath(key);
+    error_code error;
+    filesystem::create_directories(filesystem::path(path).parent_path(), error);
+    if (error) return false;
+
+    // Written beside the entry under a name no other writer uses, then
+    // renamed over it in one step
+    thread_local mt19937_64 random(random_device{}());
+    string temporary = path + ".tmp" + to_string(random());
+    string entry = to_string(outputs.intermediate.size()) + " " + to_string(outputs.output.size()) + "\n" +
+                   outputs.intermediate + outputs.output;
+    try
+    {
+        writeWholeFile(temporary, entry);
+    }
+    catch (const runtime_error &)
+    {
+        filesystem::remove(temporary, error);
+        return false;
+    }
+    filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        filesystem::remove(temporary, error);
+        return false;
+    }
+
+    lock_guard<mutex> guard(sizeLock);
+    if (!scanned)
+    {
+        evict();
+    }
+    else
+    {
+        knownSize += entry.size();
+        if (knownSize > sizeLimit) evict();
+    }
+    return true;
+}
+
+void CompileCache::evict()
+{
+    struct Entry
+    {
+        filesystem::path path;
+        filesystem::file_time_type lastUse;
+        uintmax_t size;
+    };
+
+    // Files vanish while this runs when other processes evict too, so
+    // every error just skips the file
+    vector<Entry> entries;
+    uintmax_t total = 0;
+    auto now = filesystem::file_time_type::clock::now();
+    error_code error;
+    for (filesystem::recursive_directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+    {
+        error_code fileError;
+        if (!it->is_regular_file(fileError) || fileError) continue;
+        Entry entry{it->path(), it->last_write_time(fileError), it->file_size(fileError)};
+        if (fileError) continue;
+        if (isTemporary(entry.path))
+        {
+            // Someone else's write in progress, unless it is very old
+            if (now - entry.lastUse > STALE_TEMPORARY) filesystem::remove(entry.path, fileError);
+            continue;
+        }
+        total += entry.size;
+        entries.push_back(move(entry));
+    }
+
+    if (total > sizeLimit)
+    {
+        sort(entries.begin(), entries.end(),
+             [](const Entry &a, const Entry &b) { return a.lastUse < b.lastUse; });
+        uintmax_t target = sizeLimit / 4 * 3;
+        for (const Entry &entry : entries)
+        {
+            if (total <= target) break;
+            error_code removeError;
+            if (filesystem::remove(entry.path, removeError)) total -= entry.size;
+        }
+    }
+    knownSize = total;
+    scanned = true;
+}
+
+bool compileThroughCache(CompileCache &cache, const CompileOptions &options, const string &filename,
+                         const string &intermediatePath, const string &outputPath,
+                         CompileWorkspace &workspace, Diagnostics &diagnostics, ostream &log)
+{
+    SourceBuffer source;
+    if (!source.open(filename))
+    {
+        throw runtime_error("Error opening file: " + filename);
+    }
+    string key = CompileCache::key(options, source.view());
+
+    CompiledOutputs outputs;
+    if (cache.lookup(key, outputs))
+    {
+        log << "Cache hit: " << key << endl;
+    }
+    else
+    {
+        IntermediateCodeGnerator icg;
+        if (!compileSource(options, source.view(), workspace, icg, diagnostics, log)) return false;
+        AssemblyCodeGenerator acg(options.target);
+        generateCode(options, icg, acg, log);
+        outputs = renderOutputs(options, icg, acg);
+        log << (cache.store(key, outputs) ? "Cache miss, stored: " : "Cache miss, not stored: ") << key << endl;
+    }
+
+    saveOutputs(options, outputs, intermediatePath, outputPath, log);
+    return true;
+}
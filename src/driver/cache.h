@@ -0,0 +1,65 @@
+#ifndef CACHE_H
+#define CACHE_H
+#include<cstdint>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include "./compiler.h"
+using namespace std;
+
+// On-disk cache of compiled outputs for --cache, addressed by a hash of
+// the source bytes, the options that change the outputs and the compiler
+// executable. A hit copies
+// icg.obj and the assembly (or object) out of the cache without lexing,
+// parsing or generating anything.
+//
+// Each entry is one file, <directory>/<first two hex digits>/<the rest>,
+// holding both outputs. Entries are written to a temporary file and
+// renamed into place, so any number of processes can share a directory
+// and a reader sees a whole entry or none. A hit refreshes the entry's
+// modification time; once the directory grows past its size limit the
+// least recently used entries are deleted until it is back to three
+// quarters of the limit.
+class CompileCache
+{
+public:
+    static constexpr uintmax_t DEFAULT_SIZE_LIMIT = 64 * 1024 * 1024;
+
+    explicit CompileCache(string directory, uintmax_t sizeLimit = DEFAULT_SIZE_LIMIT);
+
+    // 32 hex digits. Covers the compiler binary too, so entries never
+    // outlive a rebuild of the compiler
+    static string key(const CompileOptions &options, string_view source);
+
+    // false on a miss, including an entry that is unreadable or truncated
+    bool lookup(const string &key, CompiledOutputs &outputs) const;
+
+    // false if the entry could not be written; the cache is only an
+    // optimization, so callers carry on either way
+    bool store(const string &key, const CompiledOutputs &outputs);
+
+private:
+    string directory;
+    uintmax_t sizeLimit;
+
+    // Bytes in the directory as of the last scan plus what this process
+    // stored since; other processes' entries are only seen by the next
+    // scan, so the limit is kept approximately
+    mutex sizeLock;
+    uintmax_t knownSize = 0;
+    bool scanned = false;
+
+    string entryPath(const string &key) const;
+    void evict();
+};
+
+// Compiles `filename` to `intermediatePath` and `outputPath` through the
+// cache: on a hit the cached outputs are written, on a miss the file is
+// compiled as usual and the outputs are also stored. Returns false with
+// `diagnostics` filled in when the program has errors, which are not
+// cached. Throws runtime_error when a file cannot be read or written.
+bool compileThroughCache(CompileCache &cache, const CompileOptions &options, const string &filename,
+                         const string &intermediatePath, const string &outputPath,
+                         CompileWorkspace &workspace, Diagnostics &diagnostics, ostream &log);
+
+#endif
@@ -0,0 +1,148 @@
+#include "./compiler.h"
+#include "./fingerprint.h"
+#include "../lexer/sourceBuffer.h"
+#include "../parser/parser.h"
+#include "../intermediate/lowering.h"
+#include "../assembly/peephole.h"
+#include<fstream>
+#include<sstream>
+#include<stdexcept>
+using namespace std;
+
+bool applyCompileOption(CompileOptions &options, const string &arg)
+{
+    if (arg == "--lexer=dfa") options.engine = LexerEngine::DFA;
+    else if (arg == "--lexer=if-chain") options.engine = LexerEngine::IF_CHAIN;
+    else if (arg == "--target=x86-64") options.target = Target::X86_64;
+    else if (arg == "--target=x86") options.target = Target::X86;
+    else if (arg == "--emit=asm") options.emitObject = false;
+    else if (arg == "--emit=obj") options.emitObject = true;
+    else if (arg == "-O0" || arg == "-O1" || arg == "-O2") options.optimizationLevel = arg[2] - '0';
+    else return false;
+    return true;
+}
+
+bool compileToIntermediate(const CompileOptions &options, const char *filename,
+                           IntermediateCodeGnerator &icg, Diagnostics &diagnostics, ostream &log)
+{
+    // Map the file; the lexer scans it in place without copying
+    SourceBuffer source;
+    if (!source.open(filename))
+    {
+        throw runtime_error(string("Error opening file: ") + filename);
+    }
+    CompileWorkspace workspace;
+    return compileSource(options, source.view(), workspace, icg, diagnostics, log);
+}
+
+bool compileSource(const CompileOptions &options, string_view source, CompileWorkspace &workspace,
+                   IntermediateCodeGnerator &icg, Diagnostics &diagnostics, ostream &log)
+{
+    StringPool &pool = workspace.pool;
+    Arena &arena = workspace.arena;
+    pool.clear();
+    arena.reset();
+
+    // The token listing streams through its own lexer so that the parser,
+    // which pulls tokens on demand, never needs the whole token vector. Its
+    // errors are dropped, since the parser's lexer finds the same ones
+    if (options.listings)
+    {
+        Diagnostics listingDiagnostics;
+        Lexer tokenListing(source, pool, listingDiagnostics, options.engine);
+        tokenListing.printTokenizer(log);
+    }
+
+    // The parser builds the syntax tree in the arena, which is released in
+    // one go by the next compilation
+    Lexer lexer(source, pool, diagnostics, options.engine);
+    Parser parser(lexer, arena, diagnostics);
+    Program *program = parser.parseProgram();
+
+    // Statements with syntax errors are missing from the tree, so checking
+    // it would only report errors that follow from those
+    if (diagnostics.hasErrors()) return false;
+
+    SymbolTable symTable(pool);
+    AstLowering lowering(symTable, icg, diagnostics);
+    lowering.lowerProgram(program);
+    if (options.listings) symTable.printSymbolTable(log);
+    if (diagnostics.hasErrors()) return false;
+
+    Optimizer optimizer(options.optimizationLevel);
+    optimizer.run(icg);
+    return true;
+}
+
+void generateCode(const CompileOptions &options, const IntermediateCodeGnerator &icg,
+                  AssemblyCodeGenerator &acg, ostream &log)
+{
+    acg.generateAssembly(icg);
+    if (options.optimizationLevel > 0)
+    {
+        PeepholeOptimizer peephole;
+        size_t rewrites = peephole.run(acg.instructions);
+        log << "Peephole optimizer made " << rewrites << " rewrites" << endl;
+    }
+}
+
+CompiledOutputs renderOutputs(const CompileOptions &options, const IntermediateCodeGnerator &icg,
+                              const AssemblyCodeGenerator &acg)
+{
+    CompiledOutputs outputs;
+    ostringstream intermediate;
+    icg.writeInstructions(intermediate);
+    outputs.intermediate = intermediate.str();
+    if (options.emitObject)
+    {
+        vector<uint8_t> image = acg.objectImage();
+        outputs.output.assign(image.begin(), image.end());
+    }
+    else
+    {
+        ostringstream assembly;
+        acg.writeAssembly(assembly);
+        outputs.output = assembly.str();
+    }
+    return outputs;
+}
+
+static void writeOutputFile(const string &path, const string &contents)
+{
+    ofstream out(path, ios::binary);
+    out.write(contents.data(), static_cast<streamsize>(contents.size()));
+    out.close();
+    if (!out)
+    {
+        throw runtime_error("Error writing file: " + path);
+    }
+}
+
+void saveOutputs(const CompileOptions &options, const CompiledOutputs &outputs,
+                 const string &intermediatePath, const string &outputPath, ostream &log)
+{
+    writeOutputFile(intermediatePath, outputs.intermediate);
+    log << "Generated Intermediate Code is saved to file: " << intermediatePath << endl;
+    writeOutputFile(outputPath, outputs.output);
+    log << (options.emitObject ? "Generated object file is saved to file: "
+                               : "Generated Assembly Code is saved to file: ") << outputPath << endl;
+}
+
+const string &compilerIdentity()
+{
+    static const string identity = [] {
+#if defined(__linux__)
+        ifstream in("/proc/self/exe", ios::binary);
+        ostringstream executable;
+        executable << in.rdbuf();
+        if (in.is_open() && !in.bad())
+        {
+            Fnv128 hash;
+            hash.add(executable.str());
+            return hash.hex();
+        }
+#endif
+        return string(__DATE__ " " __TIME__);
+    }();
+    return identity;
+}
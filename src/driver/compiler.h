@@ -0,0 +1,80 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+#include<iostream>
+#include<string_view>
+#include "../ast/arena.h"
+#include "../lexer/lexer.h"
+#include "../lexer/stringPool.h"
+#include "../optimizer/optimizer.h"
+#include "../intermediate/icg.h"
+#include "../assembly/acg.h"
+#include "../diagnostics/diagnostics.h"
+using namespace std;
+
+struct CompileOptions
+{
+    LexerEngine engine = LexerEngine::IF_CHAIN;
+    int optimizationLevel = Optimizer::DEFAULT_LEVEL;
+    Target target = Target::X86_64;
+    bool emitObject = false;
+
+    // Print the token listing and the symbol table while compiling
+    bool listings = true;
+};
+
+// Applies one command-line option that selects how to compile (lexer,
+// -O level, target, output kind); false if `arg` is not one of those
+bool applyCompileOption(CompileOptions &options, const string &arg);
+
+// Memory a compilation allocates into: the syntax tree's arena and the
+// identifier pool. Both are emptied at the start of each compilation but
+// keep what they allocated, so a long-running caller that passes the same
+// workspace every time stops allocating once it is warm. One workspace
+// per thread.
+struct CompileWorkspace
+{
+    Arena arena;
+    StringPool pool;
+};
+
+// The steps of one compilation. Everything they touch is created per call
+// or passed in, and anything printed goes to `log`, so compilations on
+// separate threads do not interfere.
+
+// Lexes, parses, lowers and optimizes a source file into `icg`. Errors in
+// the program go to `diagnostics`, and then the result is false and `icg`
+// is incomplete. Throws runtime_error when the file cannot be read.
+bool compileToIntermediate(const CompileOptions &options, const char *filename,
+                           IntermediateCodeGnerator &icg, Diagnostics &diagnostics, ostream &log);
+
+// The same for source text already in memory
+bool compileSource(const CompileOptions &options, string_view source, CompileWorkspace &workspace,
+                   IntermediateCodeGnerator &icg, Diagnostics &diagnostics, ostream &log);
+
+// Selects instructions for `icg` into `acg`, with the peephole pass from
+// -O1 on
+void generateCode(const CompileOptions &options, const IntermediateCodeGnerator &icg,
+                  AssemblyCodeGenerator &acg, ostream &log);
+
+// The bytes of the two output files: icg.obj, and the assembly text or,
+// with --emit=obj, the ELF object
+struct CompiledOutputs
+{
+    string intermediate;
+    string output;
+};
+
+CompiledOutputs renderOutputs(const CompileOptions &options, const IntermediateCodeGnerator &icg,
+                              const AssemblyCodeGenerator &acg);
+
+// Writes both outputs; throws runtime_error when a file cannot be written
+void saveOutputs(const CompileOptions &options, const CompiledOutputs &outputs,
+                 const string &intermediatePath, const string &outputPath, ostream &log);
+
+// A hash of the compiler's own executable, for what is kept between runs
+// (cache entries, incremental state), so a rebuilt compiler never reuses
+// what an older one generated. Where the executable cannot be read, the
+// time compiler.cpp was compiled stands in.
+const string &compilerIdentity();
+
+#endif
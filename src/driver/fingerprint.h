@@ -0,0 +1,62 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+#include<cstdint>
+#include<string>
+#include<string_view>
+using namespace std;
+
+// FNV-1a with 128-bit state, kept as two 64-bit halves, for naming
+// contents: cache entries and the units of an incremental build. It only
+// has to tell different inputs apart, and 128 bits make an accidental
+// collision out of the question.
+class Fnv128
+{
+public:
+    void add(string_view bytes)
+    {
+        for (char c : bytes)
+        {
+            low ^= static_cast<unsigned char>(c);
+            multiplyByPrime();
+        }
+    }
+
+    // A number, terminated so that it cannot run into what follows
+    void add(int64_t value)
+    {
+        string text = to_string(value);
+        add(text);
+        add(string_view("\0", 1));
+    }
+
+    string hex() const
+    {
+        static const char digits[] = "0123456789abcdef";
+        string text(32, '0');
+        for (int i = 0; i < 16; i++)
+        {
+            text[15 - i] = digits[(high >> (4 * i)) & 0xf];
+            text[31 - i] = digits[(low >> (4 * i)) & 0xf];
+        }
+        return text;
+    }
+
+private:
+    uint64_t high = 0x6c62272e07bb0142ULL;
+    uint64_t low = 0x62b821756295c58dULL;
+
+    // The prime is 2^88 + 0x13b, so the product is the state times 0x13b
+    // plus the state shifted left by 88, modulo 2^128
+    void multiplyByPrime()
+    {
+        uint64_t lowLow = (low & 0xffffffffULL) * 0x13b;
+        uint64_t lowHigh = (low >> 32) * 0x13b;
+        uint64_t newLow = lowLow + (lowHigh << 32);
+        uint64_t carry = (lowHigh >> 32) + (newLow < lowLow ? 1 : 0);
+        high = high * 0x13b + carry + (low << 24);
+        low = newLow;
+    }
+};
+
+
+#endif
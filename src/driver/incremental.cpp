@@ -0,0 +1,729 @@
+#include "./incremental.h"
+#include "./fingerprint.h"
+#include "../lexer/sourceBuffer.h"
+#include "../parser/parser.h"
+#include "../intermediate/lowering.h"
+#include<cctype>
+#include<filesystem>
+#include<fstream>
+#include<memory>
+#include<random>
+#include<sstream>
+#include<stdexcept>
+#include<unordered_map>
+#include<unordered_set>
+#include<utility>
+#include<vector>
+using namespace std;
+
+namespace {
+
+constexpr char STATE_VERSION[] = "mini-compiler incremental 2";
+
+// The state's first line: a state left by another build of the compiler
+// is not read, since its units and outputs may be what that one generated
+string stateHeader()
+{
+    return string(STATE_VERSION) + " " + compilerIdentity() + "\n";
+}
+
+// Binding of a name that is not a top-level variable
+constexpr int UNDECLARED = -1;
+
+struct Unit
+{
+    // Source bytes from the unit's first token (from the start of the file
+    // for the first unit) up to the next unit's first token
+    size_t length = 0;
+    string fingerprint;
+
+    // What each name in the unit was bound to at the top level when it was
+    // lowered, as a VarType or UNDECLARED, and the variable it declares
+    vector<pair<string, int>> imports;
+    vector<pair<string, int>> exports;
+
+    // Unoptimized intermediate code with operand ids of its own. Its
+    // temporaries and labels are numbered from `base`
+    IntermediateCodeGnerator code;
+    int base = 0;
+
+    // Machine instructions for `code` at -O0, and the temporaries they
+    // keep in memory
+    bool hasAssembly = false;
+    Target assemblyTarget = Target::X86_64;
+    vector<AsmInstruction> assembly;
+    vector<OperandId> spilled;
+
+    // Syntax tree of a unit that is lowered in this build
+    const Stmt *statement = nullptr;
+};
+
+struct State
+{
+    size_t sourceLength = 0;
+    string sourceFingerprint;
+    string outputKey;
+    CompiledOutputs outputs;
+    vector<Unit> units;
+
+    // Text of the instruction comments read back from the state file. The
+    // generator's own comments are string literals; these have to live as
+    // long as any unit that points at them
+    unordered_set<string> comments;
+};
+
+string fingerprint(string_view text)
+{
+    Fnv128 hash;
+    hash.add(text);
+    return hash.hex();
+}
+
+// The options the outputs depend on; the units do not depend on any
+string outputKey(const CompileOptions &options)
+{
+    return "O" + to_string(options.optimizationLevel) + "-" + to_string(static_cast<int>(options.target)) +
+           (options.emitObject ? "-obj" : "-asm");
+}
+
+// Temporaries (t<n>) and labels (L<n>, t<n><suffix>) are numbered from one
+// counter; renumbers a name given out from `from` as if from `to`
+string renumber(const string &name, int from, int to)
+{
+    size_t digits = 1;
+    while (digits < name.size() && isdigit(static_cast<unsigned char>(name[digits]))) digits++;
+    int number = stoi(name.substr(1, digits - 1));
+    return name[0] + to_string(number - from + to) + name.substr(digits);
+}
+
+// State file: counts and numbers separated by whitespace, and every
+// string as its length, a space and its bytes, since names of constants
+// can hold any character. It is read from memory, so that every length
+// can be checked against what is left of it.
+
+void writeText(ostream &out, string_view text)
+{
+    out << text.size() << ' ' << text << '\n';
+}
+
+bool readText(istringstream &in, string &text)
+{
+    size_t size;
+    if (!(in >> size) || in.get() != ' ') return false;
+    streamsize left = in.rdbuf()->in_avail();
+    if (left < 0 || size > static_cast<size_t>(left)) return false;
+    text.resize(size);
+    in.read(text.data(), static_cast<streamsize>(size));
+    return in.gcount() == static_cast<streamsize>(size) && in.get() == '\n';
+}
+
+void writeBindings(ostream &out, const vector<pair<string, int>> &bindings)
+{
+    out << bindings.size() << '\n';
+    for (const auto &binding : bindings)
+    {
+        writeText(out, binding.first);
+        out << binding.second << '\n';
+    }
+}
+
+// Exports are always variables, so only imports may be UNDECLARED
+bool readBindings(istringstream &in, vector<pair<string, int>> &bindings, bool imports)
+{
+    size_t count;
+    if (!(in >> count)) return false;
+    for (size_t i = 0; i < count; i++)
+    {
+        string name;
+        int type;
+        if (!readText(in, name) || !(in >> type) || type < (imports ? UNDECLARED : 0) ||
+            type > static_cast<int>(VarType::BOOL))
+        {
+            return false;
+        }
+        bindings.emplace_back(move(name), type);
+    }
+    return true;
+}
+
+void writeOperand(ostream &out, const AsmOperand &operand)
+{
+    out << ' ' << static_cast<int>(operand.kind) << ' ' << static_cast<int>(operand.reg) << ' '
+        << operand.value << ' ' << operand.id;
+}
+
+bool readOperand(istringstream &in, AsmOperand &operand)
+{
+    int kind;
+    int reg;
+    if (!(in >> kind >> reg >> operand.value >> operand.id)) return false;
+    if (kind < AsmOperand::NONE || kind > AsmOperand::LABEL || reg < 0 || reg > static_cast<int>(Register::R15D))
+    {
+        return false;
+    }
+    operand.kind = static_cast<AsmOperand::Kind>(kind);
+    operand.reg = static_cast<Register>(reg);
+    return true;
+}
+
+// Temporaries and labels have to be renumbered, so their names have to be
+// a letter and a number
+bool isNumbered(const string &name)
+{
+    size_t digits = 1;
+    while (digits < name.size() && isdigit(static_cast<unsigned char>(name[digits]))) digits++;
+    return digits > 1 && digits <= 10;
+}
+
+void saveState(const string &path, const State &state)
+{
+    ostringstream out;
+    out << state.sourceLength << ' ' << state.sourceFingerprint << ' ' << state.outputKey << '\n';
+    writeText(out, state.outputs.intermediate);
+    writeText(out, state.outputs.output);
+    out << state.units.size() << '\n';
+    for (const Unit &unit : state.units)
+    {
+        const IntermediateCodeGnerator &code = unit.code;
+        out << unit.length << ' ' << unit.fingerprint << ' ' << unit.base << ' ' << code.tempCount << '\n';
+        writeBindings(out, unit.imports);
+        writeBindings(out, unit.exports);
+
+        out << code.operandKinds.size() << '\n';
+        for (OperandId id = 0; id < code.operandKinds.size(); id++)
+        {
+            out << static_cast<int>(code.operandKinds[id]) << ' ';
+            writeText(out, code.operandNames[id]);
+        }
+        out << code.size() << '\n';
+        for (size_t i = 0; i < code.size(); i++)
+        {
+            out << static_cast<int>(code.opcodes[i]) << ' ' << code.arg1s[i] << ' ' << code.arg2s[i] << ' '
+                << code.results[i] << '\n';
+        }
+
+        out << unit.hasAssembly << ' ' << static_cast<int>(unit.assemblyTarget) << ' ' << unit.assembly.size() << '\n';
+        for (const AsmInstruction &instruction : unit.assembly)
+        {
+            out << static_cast<int>(instruction.opcode) << ' ' << static_cast<int>(instruction.condition);
+            writeOperand(out, instruction.dst);
+            writeOperand(out, instruction.src);
+            out << ' ';
+            writeText(out, instruction.comment != nullptr ? instruction.comment : "");
+        }
+        out << unit.spilled.size();
+        for (OperandId id : unit.spilled) out << ' ' << id;
+        out << '\n';
+    }
+
+    // Written beside the state under a name no other build uses and renamed
+    // over it, so that an interrupted build leaves the previous state whole
+    // and two builds sharing one state leave one or the other
+    mt19937_64 random(random_device{}());
+    string temporary = path + ".tmp" + to_string(random());
+    // A fingerprint of the rest turns any damage into "no state"
+    string body = out.str();
+    ofstream file(temporary, ios::binary);
+    file << stateHeader() << fingerprint(body) << '\n' << body;
+    file.close();
+    error_code error;
+    if (!file)
+    {
+        filesystem::remove(temporary, error);
+        throw runtime_error("Error writing file: " + temporary);
+    }
+    filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        filesystem::remove(temporary, error);
+        throw runtime_error("Error writing file: " + path);
+    }
+}
+
+// false when there is no state, or one this compiler cannot read
+bool loadState(const string &path, State &state)
+{
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    ostringstream contents;
+    contents << file.rdbuf();
+    if (file.bad()) return false;
+
+    string text = contents.str();
+    string header = stateHeader();
+    size_t body = header.size() + 33;
+    if (text.compare(0, header.size(), header) != 0 || text.size() < body || text[body - 1] != '\n' ||
+        fingerprint(string_view(text).substr(body)) != text.substr(header.size(), 32))
+    {
+        return false;
+    }
+    istringstream in(text.substr(body));
+
+    size_t unitCount;
+    if (!(in >> state.sourceLength >> state.sourceFingerprint >> state.outputKey) ||
+        !readText(in, state.outputs.intermediate) || !readText(in, state.outputs.output) || !(in >> unitCount))
+    {
+        return false;
+    }
+    for (size_t u = 0; u < unitCount; u++)
+    {
+        Unit unit;
+        int tempCount;
+        if (!(in >> unit.length >> unit.fingerprint >> unit.base >> tempCount) ||
+            !readBindings(in, unit.imports, true) || !readBindings(in, unit.exports, false))
+        {
+            return false;
+        }
+
+        size_t operandCount;
+        if (!(in >> operandCount)) return false;
+        for (size_t i = 0; i < operandCount; i++)
+        {
+            int kind;
+            string name;
+            if (!(in >> kind) || kind < 0 || kind > static_cast<int>(OperandKind::LABEL) || in.get() != ' ' ||
+                !readText(in, name))
+            {
+                return false;
+            }
+            OperandKind operandKind = static_cast<OperandKind>(kind);
+            if ((operandKind == OperandKind::TEMP || operandKind == OperandKind::LABEL) && !isNumbered(name))
+            {
+                return false;
+            }
+            unit.code.operand(operandKind, name);
+        }
+        auto valid = [&](OperandId id) { return id == NO_OPERAND || id < operandCount; };
+
+        size_t instructionCount;
+        if (!(in >> instructionCount)) return false;
+        for (size_t i = 0; i < instructionCount; i++)
+        {
+            int opcode;
+            OperandId arg1, arg2, result;
+            if (!(in >> opcode >> arg1 >> arg2 >> result) || opcode < 0 || opcode > static_cast<int>(Opcode::RETURN) ||
+                !valid(arg1) || !valid(arg2) || !valid(result))
+            {
+                return false;
+            }
+            unit.code.addInstruction(static_cast<Opcode>(opcode), result, arg1, arg2);
+        }
+        unit.code.tempCount = tempCount;
+
+        int target;
+        size_t assemblyCount;
+        if (!(in >> unit.hasAssembly >> target >> assemblyCount)) return false;
+        unit.assemblyTarget = target == static_cast<int>(Target::X86) ? Target::X86 : Target::X86_64;
+        for (size_t i = 0; i < assemblyCount; i++)
+        {
+            AsmInstruction instruction;
+            int opcode;
+            int condition;
+            string comment;
+            if (!(in >> opcode >> condition) || opcode < 0 || opcode > static_cast<int>(AsmOpcode::RET) ||
+                !readOperand(in, instruction.dst) || !readOperand(in, instruction.src) || in.get() != ' ' ||
+                !readText(in, comment) || !valid(instruction.dst.id) || !valid(instruction.src.id))
+            {
+                return false;
+            }
+            instruction.opcode = static_cast<AsmOpcode>(opcode);
+            instruction.condition = static_cast<Condition>(condition);
+            instruction.comment = comment.empty() ? nullptr : state.comments.insert(comment).first->c_str();
+            unit.assembly.push_back(instruction);
+        }
+
+        size_t spilledCount;
+        if (!(in >> spilledCount)) return false;
+        for (size_t i = 0; i < spilledCount; i++)
+        {
+            OperandId id;
+            if (!(in >> id) || id >= operandCount) return false;
+            unit.spilled.push_back(id);
+        }
+        state.units.push_back(move(unit));
+    }
+    return true;
+}
+
+// One compile: keeps what it can of the previous units and lexes, parses
+// and lowers the rest
+class IncrementalBuild
+{
+public:
+    IncrementalBuild(const CompileOptions &options, string_view source, CompileWorkspace &workspace,
+                     Diagnostics &diagnostics)
+            : options(options), source(source), workspace(workspace), diagnostics(diagnostics)
+    {
+    }
+
+    // Without previous units this compiles the whole file. False when the
+    // program has errors, or when the changed text could not be compiled
+    // on its own
+    bool run(vector<Unit> previous)
+    {
+        workspace.pool.clear();
+        workspace.arena.reset();
+        return splitUnits(previous) && lowerUnits();
+    }
+
+    // Machine instructions from the units' own, generated for those that
+    // have none yet; only valid at -O0
+    void assembleUnits(AssemblyCodeGenerator &acg)
+    {
+        vector<bool> spilled(program.operandKinds.size(), false);
+        vector<AsmInstruction> body;
+        for (size_t u = 0; u < units.size(); u++)
+        {
+            Unit &unit = units[u];
+            const vector<OperandId> &operandMap = operandMaps[u];
+            if (!unit.hasAssembly || unit.assemblyTarget != options.target)
+            {
+                AssemblyCodeGenerator fragment(options.target);
+                fragment.generateFragment(unit.code);
+                unit.assembly = move(fragment.instructions);
+                unit.spilled.clear();
+                for (OperandId id : fragment.dataSlots)
+                {
+                    if (unit.code.operandKinds[id] == OperandKind::TEMP) unit.spilled.push_back(id);
+                }
+                unit.hasAssembly = true;
+                unit.assemblyTarget = options.target;
+            }
+
+            auto relocate = [&](AsmOperand &operand) {
+                if (operand.id != NO_OPERAND) operand.id = operandMap[operand.id];
+            };
+            for (AsmInstruction instruction : unit.assembly)
+            {
+                relocate(instruction.dst);
+                relocate(instruction.src);
+                body.push_back(instruction);
+            }
+            for (OperandId id : unit.spilled) spilled[operandMap[id]] = true;
+        }
+        acg.assembleFragments(program, spilled, body);
+    }
+
+    vector<Unit> units;
+
+    // The units' code one after the other, as lowering the whole file
+    // would have produced it
+    IntermediateCodeGnerator program;
+
+    size_t lowered = 0;
+
+private:
+    const CompileOptions &options;
+    string_view source;
+    CompileWorkspace &workspace;
+    Diagnostics &diagnostics;
+
+    // Per unit, the program's operand for each of the unit's operands
+    vector<vector<OperandId>> operandMaps;
+
+    bool splitUnits(vector<Unit> &previous)
+    {
+        // Units that still match, from the front. The last unit runs to the
+        // end of the file, where a comment need not be closed, so it only
+        // matches if the file still ends there
+        size_t frontCount = 0;
+        size_t frontEnd = 0;
+        while (frontCount < previous.size())
+        {
+            const Unit &unit = previous[frontCount];
+            bool last = frontCount + 1 == previous.size();
+            if (unit.length > source.size() - frontEnd || (last && frontEnd + unit.length != source.size()) ||
+                fingerprint(source.substr(frontEnd, unit.length)) != unit.fingerprint)
+            {
+                break;
+            }
+            frontEnd += unit.length;
+            frontCount++;
+        }
+
+        // and from the back
+        size_t backStart = previous.size();
+        size_t regionEnd = source.size();
+        while (backStart > frontCount)
+        {
+            const Unit &unit = previous[backStart - 1];
+            if (unit.length > regionEnd - frontEnd ||
+                fingerprint(source.substr(regionEnd - unit.length, unit.length)) != unit.fingerprint)
+            {
+                break;
+            }
+            regionEnd -= unit.length;
+            backStart--;
+        }
+
+        // Text in between without a statement, such as what is left of a
+        // deleted one, is given to a neighbouring unit
+        vector<pair<size_t, const Stmt *>> statements;
+        string_view region;
+        while (true)
+        {
+            region = source.substr(frontEnd, regionEnd - frontEnd);
+            statements.clear();
+            if (!parseRegion(region, statements)) return false;
+            if (!statements.empty() || region.empty()) break;
+            if (frontCount > 0)
+            {
+                frontCount--;
+                frontEnd -= previous[frontCount].length;
+            }
+            else if (backStart < previous.size())
+            {
+                regionEnd += previous[backStart].length;
+                backStart++;
+            }
+            else
+            {
+                break;
+            }
+        }
+        if (!statements.empty() && backStart < previous.size() &&
+            !endsCleanly(frontEnd + statements.back().first, regionEnd))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < frontCount; i++) units.push_back(move(previous[i]));
+        for (size_t k = 0; k < statements.size(); k++)
+        {
+            size_t begin = k == 0 ? 0 : statements[k].first;
+            size_t end = k + 1 < statements.size() ? statements[k + 1].first : region.size();
+            Unit unit;
+            unit.length = end - begin;
+            unit.fingerprint = fingerprint(region.substr(begin, unit.length));
+            unit.statement = statements[k].second;
+            units.push_back(move(unit));
+        }
+        for (size_t i = backStart; i < previous.size(); i++) units.push_back(move(previous[i]));
+        return true;
+    }
+
+    // Top-level statements of `region`, each with the offset of its first
+    // token; false on a syntax error
+    bool parseRegion(string_view region, vector<pair<size_t, const Stmt *>> &statements)
+    {
+        Lexer lexer(region, workspace.pool, diagnostics, options.engine);
+        Parser parser(lexer, workspace.arena, diagnostics);
+        while (lexer.peek().type != T_EOF)
+        {
+            size_t start = lexer.peek().offset;
+            if (const Stmt *statement = parser.parseTopLevelStatement())
+            {
+                statements.emplace_back(start, statement);
+            }
+        }
+        return !diagnostics.hasErrors();
+    }
+
+    // Whether the statement at `start`, the last changed one, ends where
+    // the kept unit at `end` begins when lexed with the rest of the file
+    // too. A comment or string it leaves open would swallow that unit.
+    bool endsCleanly(size_t start, size_t end)
+    {
+        Diagnostics ignored;
+        Lexer bounded(source.substr(start, end - start), workspace.pool, ignored, options.engine);
+        Lexer open(source.substr(start), workspace.pool, ignored, options.engine);
+        while (bounded.peek().type != T_EOF)
+        {
+            Token expected = bounded.next();
+            Token found = open.next();
+            if (expected.type != found.type || expected.offset != found.offset || expected.length != found.length)
+            {
+                return false;
+            }
+        }
+        return open.peek().offset == end - start;
+    }
+
+    // A kept unit whose code is out of date, parsed from its text again
+    const Stmt *reparse(string_view text)
+    {
+        Lexer lexer(text, workspace.pool, diagnostics, options.engine);
+        Parser parser(lexer, workspace.arena, diagnostics);
+        const Stmt *statement = parser.parseTopLevelStatement();
+        if (diagnostics.hasErrors() || lexer.peek().type != T_EOF) return nullptr;
+        return statement;
+    }
+
+    bool lowerUnits()
+    {
+        SymbolTable symTable(workspace.pool);
+        unordered_map<string, int> topLevel;
+        operandMaps.assign(units.size(), {});
+        size_t start = 0;
+        for (size_t u = 0; u < units.size(); u++)
+        {
+            Unit &unit = units[u];
+            string_view text = source.substr(start, unit.length);
+            if (unit.statement == nullptr && !importsMatch(unit, topLevel))
+            {
+                unit.statement = reparse(text);
+                if (unit.statement == nullptr) return false;
+            }
+
+            if (unit.statement != nullptr)
+            {
+                lowerUnit(unit, text, symTable, topLevel);
+                lowered++;
+            }
+            else
+            {
+                for (const auto &binding : unit.exports)
+                {
+                    symTable.declareVariable(workspace.pool.intern(binding.first), static_cast<VarType>(binding.second));
+                }
+            }
+            for (const auto &binding : unit.exports) topLevel[binding.first] = binding.second;
+
+            appendUnit(unit, operandMaps[u]);
+            start += unit.length;
+        }
+        return !diagnostics.hasErrors();
+    }
+
+    static bool importsMatch(const Unit &unit, const unordered_map<string, int> &topLevel)
+    {
+        for (const auto &binding : unit.imports)
+        {
+            auto found = topLevel.find(binding.first);
+            int current = found == topLevel.end() ? UNDECLARED : found->second;
+            if (current != binding.second) return false;
+        }
+        return true;
+    }
+
+    void lowerUnit(Unit &unit, string_view text, SymbolTable &symTable, const unordered_map<string, int> &topLevel)
+    {
+        unit.base = program.tempCount;
+        unit.code = IntermediateCodeGnerator();
+        unit.code.tempCount = unit.base;
+        unit.hasAssembly = false;
+        unit.assembly.clear();
+        unit.spilled.clear();
+
+        // The code depends on the top-level variables the unit names: their
+        // types are checked, and a declaration that shadows one is renamed
+        unit.imports.clear();
+        Diagnostics ignored;
+        Lexer lexer(text, workspace.pool, ignored, options.engine);
+        unordered_set<string_view> seen;
+        for (Token token = lexer.next(); token.type != T_EOF; token = lexer.next())
+        {
+            if (token.type != T_ID) continue;
+            string_view name = lexer.tokenValue(token);
+            if (!seen.insert(name).second) continue;
+            auto found = topLevel.find(string(name));
+            unit.imports.emplace_back(string(name), found == topLevel.end() ? UNDECLARED : found->second);
+        }
+
+        AstLowering lowering(symTable, unit.code, diagnostics);
+        lowering.lowerStatement(unit.statement);
+
+        unit.exports.clear();
+        if (unit.statement->kind == StmtKind::DECLARATION)
+        {
+            const DeclarationStmt *declaration = static_cast<const DeclarationStmt *>(unit.statement);
+            SymbolHandle handle = symTable.lookup(declaration->symbol);
+            if (handle != NO_HANDLE)
+            {
+                unit.exports.emplace_back(string(declaration->name), static_cast<int>(symTable.entry(handle).type));
+            }
+        }
+
+        // The tree goes away with the arena
+        unit.statement = nullptr;
+    }
+
+    void appendUnit(const Unit &unit, vector<OperandId> &operandMap)
+    {
+        const IntermediateCodeGnerator &code = unit.code;
+        int base = program.tempCount;
+        operandMap.clear();
+        for (OperandId id = 0; id < code.operandKinds.size(); id++)
+        {
+            OperandKind kind = code.operandKinds[id];
+            bool numbered = kind == OperandKind::TEMP || kind == OperandKind::LABEL;
+            const string &name = code.operandNames[id];
+            operandMap.push_back(program.operand(kind, numbered && base != unit.base ? renumber(name, unit.base, base) : name));
+        }
+
+        auto mapped = [&](OperandId id) { return id == NO_OPERAND ? NO_OPERAND : operandMap[id]; };
+        for (size_t i = 0; i < code.size(); i++)
+        {
+            program.addInstruction(code.opcodes[i], mapped(code.results[i]), mapped(code.arg1s[i]), mapped(code.arg2s[i]));
+        }
+        program.tempCount = base + (code.tempCount - unit.base);
+    }
+};
+
+}
+
+bool compileIncrementally(const CompileOptions &options, const string &filename, const string &statePath,
+                          const string &intermediatePath, const string &outputPath,
+                          CompileWorkspace &workspace, Diagnostics &diagnostics, ostream &log)
+{
+    SourceBuffer buffer;
+    if (!buffer.open(filename))
+    {
+        throw runtime_error("Error opening file: " + filename);
+    }
+    string_view source = buffer.view();
+    string sourceFingerprint = fingerprint(source);
+    string key = outputKey(options);
+
+    State previous;
+    bool hasPrevious = loadState(statePath, previous);
+    if (hasPrevious && previous.sourceLength == source.size() && previous.sourceFingerprint == sourceFingerprint &&
+        previous.outputKey == key)
+    {
+        log << "Incremental build: no changes" << endl;
+        saveOutputs(options, previous.outputs, intermediatePath, outputPath, log);
+        return true;
+    }
+
+    // The changed units on their own first; errors found on the way are
+    // reported by the compile of the whole file that follows
+    Diagnostics scratch;
+    unique_ptr<IncrementalBuild> build;
+    if (hasPrevious)
+    {
+        build = make_unique<IncrementalBuild>(options, source, workspace, scratch);
+        if (!build->run(move(previous.units))) build.reset();
+    }
+    bool incremental = build != nullptr;
+    if (!incremental)
+    {
+        build = make_unique<IncrementalBuild>(options, source, workspace, diagnostics);
+        if (!build->run({})) return false;
+    }
+
+    AssemblyCodeGenerator acg(options.target);
+    if (options.optimizationLevel == 0)
+    {
+        build->assembleUnits(acg);
+    }
+    else
+    {
+        Optimizer optimizer(options.optimizationLevel);
+        optimizer.run(build->program);
+        generateCode(options, build->program, acg, log);
+    }
+
+    State next;
+    next.sourceLength = source.size();
+    next.sourceFingerprint = sourceFingerprint;
+    next.outputKey = key;
+    next.outputs = renderOutputs(options, build->program, acg);
+    size_t unitCount = build->units.size();
+    log << "Incremental build: " << (incremental ? "" : "whole file, ") << build->lowered << " of " << unitCount
+        << " units compiled, " << unitCount - build->lowered << " reused" << endl;
+
+    saveOutputs(options, next.outputs, intermediatePath, outputPath, log);
+    next.units = move(build->units);
+    saveState(statePath, next);
+    return true;
+}
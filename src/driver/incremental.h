@@ -0,0 +1,39 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+#include<string>
+#include "./compiler.h"
+using namespace std;
+
+// Incremental recompilation for --incremental. The program is split into
+// its top-level statements (declarations, other statements and void
+// functions), called units, and a state file keeps each unit's
+// fingerprint, its unoptimized intermediate code and, at -O0, its
+// machine instructions.
+//
+// The next compile matches the source against the saved fingerprints
+// from the front and from the back. Units that still match are kept, and
+// only the text between them is lexed and parsed again. A kept unit is
+// lowered again only if a top-level variable it names was declared,
+// removed or retyped before it; when units ahead of it grew or shrank,
+// its temporaries and labels are just renumbered.
+//
+// At -O0 the assembly is put together from the units' instructions, so
+// the work done is proportional to the size of the edit. From -O1 on the
+// optimizer and the code generator work across units (constant
+// propagation, register allocation), so they run on the whole program
+// each time. An unchanged file reuses the saved outputs at any level.
+//
+// When the changed text cannot be compiled on its own, e.g. it has a
+// syntax error or opens a comment that runs into a kept unit, the whole
+// file is compiled unit by unit instead. Either way the outputs are the
+// ones a full compile writes; the listings are not printed. A state
+// written by another build of the compiler is ignored, like a missing one.
+//
+// Returns false with `diagnostics` filled in when the program has errors,
+// and then the state is left as it was. Throws runtime_error when a file
+// cannot be read or written.
+bool compileIncrementally(const CompileOptions &options, const string &filename, const string &statePath,
+                          const string &intermediatePath, const string &outputPath,
+                          CompileWorkspace &workspace, Diagnostics &diagnostics, ostream &log);
+
+#endif
@@ -0,0 +1,350 @@
+#include "./server.h"
+#include "./threadPool.h"
+#include<algorithm>
+#include<condition_variable>
+#include<deque>
+#include<memory>
+#include<mutex>
+#include<sstream>
+#include<thread>
+#include<vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define COMPILE_SERVER_POSIX 1
+#endif
+
+using namespace std;
+
+#ifdef COMPILE_SERVER_POSIX
+namespace {
+
+// Buffered reads of lines and counted blocks from a file descriptor
+class FdReader
+{
+public:
+    explicit FdReader(int fd) : fd(fd) {}
+
+    // false at the end of the input
+    bool readLine(string &line)
+    {
+        line.clear();
+        while (true)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                if (buffer[i] == '\n')
+                {
+                    line.append(buffer + begin, i - begin);
+                    begin = i + 1;
+                    return true;
+                }
+            }
+            line.append(buffer + begin, end - begin);
+            begin = end;
+            if (!fill()) return false;
+        }
+    }
+
+    bool readExact(size_t count, string &out)
+    {
+        out.clear();
+        out.reserve(count);
+        while (out.size() < count)
+        {
+            if (begin == end && !fill()) return false;
+            size_t take = min(count - out.size(), end - begin);
+            out.append(buffer + begin, take);
+            begin += take;
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    char buffer[64 * 1024];
+    size_t begin = 0;
+    size_t end = 0;
+
+    bool fill()
+    {
+        while (true)
+        {
+            ssize_t got = read(fd, buffer, sizeof buffer);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            begin = 0;
+            end = static_cast<size_t>(got);
+            return true;
+        }
+    }
+};
+
+bool writeAll(int fd, const string &data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        ssize_t wrote = write(fd, data.data() + done, data.size() - done);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0) return false;
+        done += static_cast<size_t>(wrote);
+    }
+    return true;
+}
+
+string errorResponse(const string &message)
+{
+    return "error " + to_string(message.size()) + "\n" + message;
+}
+
+bool parseLength(const string &text, size_t &length)
+{
+    if (text.empty() || text.size() > 18) return false;
+    length = 0;
+    for (char c : text)
+    {
+        if (c < '0' || c > '9') return false;
+        length = length * 10 + static_cast<size_t>(c - '0');
+    }
+    return true;
+}
+
+// Accepted clients waiting for a serving thread; -1 tells one to stop
+class ClientQueue
+{
+public:
+    void push(int client)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            clients.push_back(client);
+        }
+        ready.notify_one();
+    }
+
+    int pop()
+    {
+        unique_lock<mutex> guard(lock);
+        ready.wait(guard, [&] { return !clients.empty(); });
+        int client = clients.front();
+        clients.pop_front();
+        return client;
+    }
+
+private:
+    mutex lock;
+    condition_variable ready;
+    deque<int> clients;
+};
+
+// A read or write that waits longer than `seconds` fails, as at the end of
+// the input, so a silent client cannot keep its serving thread forever
+bool setTimeouts(int fd, long seconds)
+{
+    timeval timeout{};
+    timeout.tv_sec = seconds;
+    return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout) == 0 &&
+           setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout) == 0;
+}
+
+string compileRequest(const CompileOptions &options, const string &source, CompileWorkspace &workspace)
+{
+    try
+    {
+        // Nothing is listed, and the progress messages are dropped
+        ostringstream log;
+        IntermediateCodeGnerator icg;
+        Diagnostics diagnostics;
+        if (!compileSource(options, source, workspace, icg, diagnostics, log))
+        {
+            return errorResponse(diagnostics.summary());
+        }
+        AssemblyCodeGenerator acg(options.target);
+        generateCode(options, icg, acg, log);
+        CompiledOutputs outputs = renderOutputs(options, icg, acg);
+        return "ok " + to_string(outputs.intermediate.size()) + " " + to_string(outputs.output.size()) + "\n" +
+               outputs.intermediate + outputs.output;
+    }
+    catch (const exception &error)
+    {
+        return errorResponse(error.what());
+    }
+}
+
+}
+#endif
+
+CompileServer::CompileServer(const CompileOptions &defaults, size_t threads)
+        : defaults(defaults), threads(threads)
+{
+    this->defaults.listings = false;
+}
+
+void CompileServer::serveConnection(int inFd, int outFd, CompileWorkspace &workspace) const
+{
+#ifdef COMPILE_SERVER_POSIX
+    FdReader reader(inFd);
+    string header;
+    string source;
+    while (reader.readLine(header))
+    {
+        // Whatever goes wrong with one request, e.g. running out of memory,
+        // ends this conversation only, not the server
+        try
+        {
+            istringstream words(header);
+            string command;
+            vector<string> args;
+            words >> command;
+            for (string word; words >> word;) args.push_back(word);
+
+            if (command.empty()) continue;
+            if (command == "quit") return;
+
+            // Without a length the source cannot be skipped, so the
+            // conversation cannot go on
+            size_t length;
+            if (command != "compile" || args.empty() || !parseLength(args.back(), length))
+            {
+                writeAll(outFd, errorResponse("bad request: " + header + "\n"));
+                return;
+            }
+            if (length > MAX_REQUEST_SIZE)
+            {
+                writeAll(outFd, errorResponse("request too large: " + to_string(length) + " bytes, the limit is " +
+                                              to_string(MAX_REQUEST_SIZE) + "\n"));
+                return;
+            }
+            args.pop_back();
+            if (!reader.readExact(length, source)) return;
+
+            CompileOptions options = defaults;
+            string response;
+            for (const string &arg : args)
+            {
+                if (!applyCompileOption(options, arg))
+                {
+                    response = errorResponse("unknown option: " + arg + "\n");
+                    break;
+                }
+            }
+            if (response.empty()) response = compileRequest(options, source, workspace);
+            if (!writeAll(outFd, response)) return;
+        }
+        catch (const exception &error)
+        {
+            writeAll(outFd, errorResponse(string(error.what()) + "\n"));
+            return;
+        }
+    }
+#else
+    (void)inFd;
+    (void)outFd;
+    (void)workspace;
+#endif
+}
+
+int CompileServer::serveStandardStreams()
+{
+#ifdef COMPILE_SERVER_POSIX
+    // A client that goes away shows up as a failed write, not a signal
+    signal(SIGPIPE, SIG_IGN);
+    CompileWorkspace workspace;
+    serveConnection(STDIN_FILENO, STDOUT_FILENO, workspace);
+    return 0;
+#else
+    cerr << "--serve needs a POSIX host" << endl;
+    return 1;
+#endif
+}
+
+int CompileServer::serveSocket(const string &path)
+{
+#ifdef COMPILE_SERVER_POSIX
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof address.sun_path)
+    {
+        cerr << "Socket path is too long: " << path << endl;
+        return 1;
+    }
+    path.copy(address.sun_path, path.size());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        cerr << "Cannot create a socket" << endl;
+        return 1;
+    }
+    // Only a socket left by an earlier server is replaced, never a file
+    // given by mistake
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            cerr << "Not a socket, refusing to replace it: " << path << endl;
+            close(listener);
+            return 1;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof address) != 0 || listen(listener, 64) != 0)
+    {
+        cerr << "Cannot listen on " << path << endl;
+        close(listener);
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    vector<unique_ptr<CompileWorkspace>> workspaces;
+    for (size_t i = 0; i < pool.size(); i++) workspaces.push_back(make_unique<CompileWorkspace>());
+    cout << "Serving on " << path << " with " << pool.size() << " threads" << endl;
+
+    // This thread only accepts; the pool's threads serve the clients it
+    // queues, one at a time each, in one batch that lasts as long as the
+    // server
+    ClientQueue queue;
+    thread serving([&] {
+        pool.forEach(pool.size(), [&](size_t i) {
+            for (int client = queue.pop(); client >= 0; client = queue.pop())
+            {
+                serveConnection(client, client, *workspaces[i]);
+                close(client);
+            }
+        });
+    });
+    while (true)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        if (!setTimeouts(client, CLIENT_TIMEOUT_SECONDS))
+        {
+            close(client);
+            continue;
+        }
+        queue.push(client);
+    }
+    for (size_t i = 0; i < pool.size(); i++) queue.push(-1);
+    serving.join();
+    close(listener);
+    return 1;
+#else
+    (void)path;
+    cerr << "--serve needs a POSIX host" << endl;
+    return 1;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include<string>
+#include "./compiler.h"
+using namespace std;
+
+// Long-running compiler for --serve. It answers compile requests from
+// stdin, or from clients of a Unix domain socket, without starting a
+// process per compile.
+//
+// Every request is a header line and then the source:
+//
+//     compile [options] <source bytes>\n<source>
+//
+// where the options are the ones main takes (-O2, --target=x86, ...) and
+// apply to this request only, on top of the server's own. The answer is
+//
+//     ok <icg bytes> <output bytes>\n<icg.obj text><assembly text or ELF object>
+//     error <bytes>\n<diagnostics>
+//
+// A `quit` line, or the end of the input, ends the conversation. So does a
+// request that cannot be read: one with a malformed header or a source
+// over MAX_REQUEST_SIZE gets an error answer and then the connection is
+// closed, since the rest of the stream cannot be found.
+//
+// Each serving thread keeps a CompileWorkspace across requests, so after
+// the first few compiles the arena and the string pool are already
+// allocated. On a socket, one thread accepts the clients and hands them
+// to a pool of threads, each serving one client at a time. A client that
+// sends or takes nothing for CLIENT_TIMEOUT_SECONDS is disconnected, so
+// idle connections cannot hold every thread.
+class CompileServer
+{
+public:
+    static constexpr size_t MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+    static constexpr long CLIENT_TIMEOUT_SECONDS = 30;
+
+    CompileServer(const CompileOptions &defaults, size_t threads);
+
+    // Serves stdin and stdout until `quit` or end of input
+    int serveStandardStreams();
+
+    // Listens on `path`, replacing a stale socket file, and serves until
+    // the process is stopped. Refuses to start if `path` exists and is not
+    // a socket
+    int serveSocket(const string &path);
+
+private:
+    CompileOptions defaults;
+    size_t threads;
+
+    void serveConnection(int inFd, int outFd, CompileWorkspace &workspace) const;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "./threadPool.h"
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(size_t threads)
+{
+    if (threads == 0) threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; i++) queues.push_back(make_unique<WorkQueue>());
+    for (size_t i = 0; i < threads; i++) workers.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        lock_guard<mutex> guard(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread &worker : workers) worker.join();
+}
+
+void WorkStealingPool::forEach(size_t count, const function<void(size_t)> &body)
+{
+    if (count == 0) return;
+
+    // Deal the indices out round-robin; stealing evens out the rest
+    unique_lock<mutex> state(stateLock);
+    for (size_t i = 0; i < count; i++)
+    {
+        WorkQueue &queue = *queues[i % queues.size()];
+        lock_guard<mutex> guard(queue.lock);
+        queue.indices.push_back(i);
+    }
+    task = &body;
+    remaining = count;
+    generation++;
+    wake.notify_all();
+
+    // Waiting for the workers to leave too means none of them still holds
+    // `body` when the next batch starts
+    finished.wait(state, [&] { return remaining == 0 && active == 0; });
+    task = nullptr;
+}
+
+bool WorkStealingPool::take(size_t self, size_t &index)
+{
+    {
+        WorkQueue &own = *queues[self];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.indices.empty())
+        {
+            index = own.indices.back();
+            own.indices.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); k++)
+    {
+        WorkQueue &victim = *queues[(self + k) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.indices.empty())
+        {
+            index = victim.indices.front();
+            victim.indices.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(size_t self)
+{
+    size_t seen = 0;
+    while (true)
+    {
+        const function<void(size_t)> *current;
+        {
+            unique_lock<mutex> state(stateLock);
+            wake.wait(state, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            current = task;
+            if (current == nullptr) continue;   // woke after the batch ended
+            active++;
+        }
+
+        size_t index;
+        while (take(self, index))
+        {
+            (*current)(index);
+            remaining--;
+        }
+
+        lock_guard<mutex> state(stateLock);
+        active--;
+        if (remaining == 0 && active == 0) finished.notify_all();
+    }
+}
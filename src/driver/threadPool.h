@@ -0,0 +1,60 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+using namespace std;
+
+// A fixed set of worker threads that run batches of indexed tasks.
+//
+// Each worker has its own deque of task indices. It pops from the back of
+// its own and, once that is empty, steals from the front of the others, so
+// a worker that drew the long tasks does not hold up the rest and the
+// workers do not contend on one shared queue. The threads stay up between
+// batches.
+class WorkStealingPool
+{
+public:
+    // 0 means one thread per hardware thread
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Runs task(i) for every i in [0, count) and returns once all are done.
+    // The task must not throw.
+    void forEach(size_t count, const function<void(size_t)> &task);
+
+private:
+    struct WorkQueue
+    {
+        mutex lock;
+        deque<size_t> indices;
+    };
+
+    vector<thread> workers;
+    vector<unique_ptr<WorkQueue>> queues;
+
+    mutex stateLock;
+    condition_variable wake;
+    condition_variable finished;
+    const function<void(size_t)> *task = nullptr;
+    size_t generation = 0;
+    bool stopping = false;
+    size_t active = 0;              // workers inside the current batch
+    atomic<size_t> remaining{0};    // tasks not finished yet
+
+    bool take(size_t self, size_t &index);
+    void work(size_t self);
+};
+
+#endif
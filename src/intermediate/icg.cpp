@@ -1,46 +1,207 @@
-
 #include "icg.h"
 #include<iostream>
 using namespace std;
 #include <fstream>
 
-string IntermediateCodeGnerator:: newTemp()
+static const char *binaryOperatorText(Opcode op)
+{
+    switch (op)
+    {
+        case Opcode::ADD: return " + ";
+        case Opcode::SUB: return " - ";
+        case Opcode::MUL: return " * ";
+        case Opcode::DIV: return " / ";
+        case Opcode::LT:  return " < ";
+        case Opcode::GT:  return " > ";
+        case Opcode::LE:  return " <= ";
+        case Opcode::GE:  return " >= ";
+        case Opcode::EQ:  return " == ";
+        case Opcode::NE:  return " != ";
+        case Opcode::AND: return " && ";
+        case Opcode::OR:  return " || ";
+        default:          return nullptr;
+    }
+}
+
+OperandId IntermediateCodeGnerator::addOperand(OperandKind kind, string_view name)
+{
+    operandKinds.push_back(kind);
+    operandNames.emplace_back(name);
+    return static_cast<OperandId>(operandKinds.size() - 1);
+}
+
+OperandId IntermediateCodeGnerator::internOperand(OperandKind kind, string_view name)
+{
+    string key;
+    key.reserve(name.size() + 1);
+    key.push_back(static_cast<char>(kind));
+    key.append(name);
+
+    auto found = operandIds.find(key);
+    if (found != operandIds.end())
+    {
+        return found->second;
+    }
+    OperandId id = addOperand(kind, name);
+    operandIds.emplace(move(key), id);
+    return id;
+}
+
+OperandId IntermediateCodeGnerator:: newTemp()
+{
+    return addOperand(OperandKind::TEMP, "t" + to_string(tempCount++));
+}
+
+OperandId IntermediateCodeGnerator::newLabel()
+{
+    return label("L" + to_string(tempCount++));
+}
+
+OperandId IntermediateCodeGnerator::newLabel(const string &suffix)
+{
+    return label("t" + to_string(tempCount++) + suffix);
+}
+
+OperandId IntermediateCodeGnerator::newVariable(const string &suffix)
+{
+    return variable("t" + to_string(tempCount++) + suffix);
+}
+
+OperandId IntermediateCodeGnerator::variable(string_view name)
+{
+    return internOperand(OperandKind::VARIABLE, name);
+}
+
+OperandId IntermediateCodeGnerator::constant(string_view text)
+{
+    return internOperand(OperandKind::CONSTANT, text);
+}
+
+OperandId IntermediateCodeGnerator::label(string_view name)
 {
-    return "t" + to_string(tempCount++);
+    return internOperand(OperandKind::LABEL, name);
 }
 
-void IntermediateCodeGnerator:: addInstruction(const string &instr)
+OperandId IntermediateCodeGnerator::operand(OperandKind kind, string_view name)
 {
-    instructions.push_back(instr);
+    if (kind == OperandKind::TEMP) return addOperand(kind, name);
+    return internOperand(kind, name);
+}
+
+void IntermediateCodeGnerator:: addInstruction(Opcode op, OperandId result, OperandId arg1, OperandId arg2)
+{
+    opcodes.push_back(op);
+    results.push_back(result);
+    arg1s.push_back(arg1);
+    arg2s.push_back(arg2);
+}
+
+void IntermediateCodeGnerator::eraseInstructions(const vector<bool> &erased)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < size(); i++)
+    {
+        if (erased[i]) continue;
+        opcodes[kept] = opcodes[i];
+        results[kept] = results[i];
+        arg1s[kept] = arg1s[i];
+        arg2s[kept] = arg2s[i];
+        kept++;
+    }
+    opcodes.resize(kept);
+    results.resize(kept);
+    arg1s.resize(kept);
+    arg2s.resize(kept);
+}
+
+void IntermediateCodeGnerator::insertInstruction(size_t index, Opcode op, OperandId result, OperandId arg1, OperandId arg2)
+{
+    opcodes.insert(opcodes.begin() + index, op);
+    results.insert(results.begin() + index, result);
+    arg1s.insert(arg1s.begin() + index, arg1);
+    arg2s.insert(arg2s.begin() + index, arg2);
+}
+
+bool IntermediateCodeGnerator::integerConstant(OperandId id, int32_t &value) const
+{
+    if (id == NO_OPERAND || operandKinds[id] != OperandKind::CONSTANT) return false;
+
+    const string &text = operandNames[id];
+    if (text == "true" || text == "false")
+    {
+        value = text == "true";
+        return true;
+    }
+    size_t sign = text[0] == '-' ? 1 : 0;
+    if (text.size() == sign || text.size() - sign > 10 ||
+        text.find_first_not_of("0123456789", sign) != string::npos)
+    {
+        return false;
+    }
+    long long wide = stoll(text);
+    if (wide < INT32_MIN || wide > INT32_MAX) return false;
+    value = static_cast<int32_t>(wide);
+    return true;
+}
+
+string IntermediateCodeGnerator::instructionText(size_t index) const
+{
+    Opcode op = opcodes[index];
+    switch (op)
+    {
+        case Opcode::COPY:
+            return operandName(results[index]) + " = " + operandName(arg1s[index]);
+        case Opcode::LABEL:
+            return operandName(results[index]) + ":";
+        case Opcode::GOTO:
+            return "goto " + operandName(results[index]);
+        case Opcode::IF_GOTO:
+            return "if " + operandName(arg1s[index]) + " goto " + operandName(results[index]);
+        case Opcode::AGAR_GOTO:
+            return "agar " + operandName(arg1s[index]) + " goto " + operandName(results[index]);
+        case Opcode::IF_NOT_GOTO:
+            return "if !" + operandName(arg1s[index]) + " goto " + operandName(results[index]);
+        case Opcode::RETURN:
+            return "return " + operandName(arg1s[index]);
+        default:
+            return operandName(results[index]) + " = " + operandName(arg1s[index]) +
+                   binaryOperatorText(op) + operandName(arg2s[index]);
+    }
 }
 
 void IntermediateCodeGnerator::printInstructions()
 {
     // file open
-    for (const auto &instr : instructions)
+    for (size_t i = 0; i < size(); i++)
     {
         // write in file
-        cout << instr << endl;
+        cout << instructionText(i) << endl;
     }
 }
 
-void IntermediateCodeGnerator::saveInstructionsToFile(const string &filename)
+void IntermediateCodeGnerator::writeInstructions(ostream &out) const
+{
+    for (size_t i = 0; i < size(); i++)
+    {
+        out << instructionText(i) << '\n';
+    }
+}
+
+bool IntermediateCodeGnerator::saveInstructionsToFile(const string &filename, ostream &log)
 {
     // Open a .obj file in text mode
     ofstream outFile(filename);
     if (!outFile.is_open())
     {
         cerr << "Error: Unable to open file for writing!" << endl;
-        return;
+        return false;
     }
 
     // Write each instruction to the file
-    for (const auto &instr : instructions)
-    {
-        outFile << instr << endl;
-    }
+    writeInstructions(outFile);
 
     // Close the file
     outFile.close();
-    cout << "Generated Intermediate Code is saved to file: " << filename << endl;
-}
\ No newline at end of file
+    log << "Generated Intermediate Code is saved to file: " << filename << endl;
+    return true;
+}
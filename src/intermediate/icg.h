@@ -1,22 +1,120 @@
 #ifndef INTERMEDIATE_CODE_GENERATOR_H
 #define INTERMEDIATE_CODE_GENERATOR_H
+#include<cstdint>
+#include<iostream>
 #include<string>
+#include<string_view>
+#include<unordered_map>
 #include<vector>
 using namespace std;
 
+// Three address code is kept as quadruples (op, arg1, arg2, result). The
+// fields live in parallel arrays indexed by instruction number, and the
+// operands are ids into the operand table below, so the backend reads the
+// code without building or parsing any strings. The text form
+// ("t3 = a + b") is only produced when the code is dumped.
+
+enum class Opcode : uint8_t
+{
+    COPY,           // result = arg1
+    ADD,            // result = arg1 + arg2
+    SUB,
+    MUL,
+    DIV,
+    LT,             // result = arg1 < arg2
+    GT,
+    LE,
+    GE,
+    EQ,
+    NE,
+    AND,            // result = arg1 && arg2
+    OR,
+    LABEL,          // result:
+    GOTO,           // goto result
+    IF_GOTO,        // if arg1 goto result
+    AGAR_GOTO,      // agar arg1 goto result
+    IF_NOT_GOTO,    // if !arg1 goto result
+    RETURN          // return arg1
+};
+
+enum class OperandKind : uint8_t
+{
+    VARIABLE,
+    TEMP,
+    CONSTANT,       // numeric, boolean or string literal, spelled as in the source
+    LABEL
+};
+
+typedef uint32_t OperandId;
+static constexpr OperandId NO_OPERAND = 0xFFFFFFFFu;
+
 class IntermediateCodeGnerator
 {
 public:
-    vector<string> instructions;
+    // Instructions
+    vector<Opcode> opcodes;
+    vector<OperandId> arg1s;
+    vector<OperandId> arg2s;
+    vector<OperandId> results;
+
+    // Operands
+    vector<OperandKind> operandKinds;
+    vector<string> operandNames;
+
     int tempCount = 0;
 
-    string newTemp();
+    OperandId newTemp();
+
+    // "L<n>", numbered from the same counter as the temporaries
+    OperandId newLabel();
+
+    // "t<n><suffix>", e.g. t4_switch_end
+    OperandId newLabel(const string &suffix);
 
-    void addInstruction(const string &instr);
+    // "t<n><suffix>", a variable introduced by the optimizer, e.g. t7_iv
+    OperandId newVariable(const string &suffix);
+
+    OperandId variable(string_view name);
+    OperandId constant(string_view text);
+    OperandId label(string_view name);
+
+    // The operand variable(), constant() or label() gives for `name`, or a
+    // new temporary called `name`; for copying code between generators
+    OperandId operand(OperandKind kind, string_view name);
+
+    void addInstruction(Opcode op, OperandId result, OperandId arg1 = NO_OPERAND, OperandId arg2 = NO_OPERAND);
+
+    size_t size() const { return opcodes.size(); }
+
+    // Removes the instructions flagged in `erased`, keeping the order of the rest
+    void eraseInstructions(const vector<bool> &erased);
+
+    // Inserts an instruction before the one at `index`
+    void insertInstruction(size_t index, Opcode op, OperandId result, OperandId arg1 = NO_OPERAND, OperandId arg2 = NO_OPERAND);
+
+    const string &operandName(OperandId id) const { return operandNames[id]; }
+
+    // Value of a constant that is an integer fitting in 32 bits, or a
+    // boolean (1 or 0); false for every other operand
+    bool integerConstant(OperandId id, int32_t &value) const;
+
+    // Text form of one instruction, as written to the .obj dump
+    string instructionText(size_t index) const;
 
     void printInstructions();
 
-    void saveInstructionsToFile(const string &filename);
+    // The .obj dump, one instruction per line
+    void writeInstructions(ostream &out) const;
+
+    bool saveInstructionsToFile(const string &filename, ostream &log = cout);
+
+private:
+    // Variables, constants and labels are shared by name; the key is the
+    // kind followed by the name so that a variable cannot alias a label
+    unordered_map<string, OperandId> operandIds;
+
+    OperandId addOperand(OperandKind kind, string_view name);
+    OperandId internOperand(OperandKind kind, string_view name);
 };
 
-#endif
\ No newline at end of file
+#endif
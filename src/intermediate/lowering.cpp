@@ -0,0 +1,477 @@
+#include "./lowering.h"
+#include<charconv>
+#include<iostream>
+#include<stdexcept>
+using namespace std;
+
+static VarType varTypeOf(TokenType type)
+{
+    switch (type)
+    {
+        case T_FLOAT:  return VarType::FLOAT;
+        case T_DOUBLE: return VarType::DOUBLE;
+        case T_STRING: return VarType::STRING;
+        case T_CHAR:   return VarType::CHAR;
+        case T_BOOL:   return VarType::BOOL;
+        default:       return VarType::INT;
+    }
+}
+
+static Opcode binaryOpcode(TokenType op)
+{
+    switch (op)
+    {
+        case T_PLUS:        return Opcode::ADD;
+        case T_MINUS:       return Opcode::SUB;
+        case T_MUL:         return Opcode::MUL;
+        case T_DIV:         return Opcode::DIV;
+        case T_GT:          return Opcode::GT;
+        case T_LT:          return Opcode::LT;
+        case T_EQ:          return Opcode::EQ;
+        case T_NE:          return Opcode::NE;
+        case T_LE:          return Opcode::LE;
+        case T_GE:          return Opcode::GE;
+        case T_LOGICAL_AND: return Opcode::AND;
+        default:            return Opcode::OR;
+    }
+}
+
+AstLowering::AstLowering(SymbolTable &symTable, IntermediateCodeGnerator &icg, Diagnostics &diagnostics)
+        : symTable(symTable), icg(icg), diagnostics(diagnostics) {}
+
+SymbolHandle AstLowering::declare(uint32_t symbol, TokenType varType, int lineNumber)
+{
+    SymbolHandle handle;
+    try
+    {
+        handle = symTable.declareVariable(symbol, varTypeOf(varType));
+    }
+    catch (const runtime_error &error)
+    {
+        // A redeclaration in the same scope; carry on with the first one
+        diagnostics.error(lineNumber, error.what());
+        return symTable.lookup(symbol);
+    }
+
+    if (variableOperands.size() <= handle)
+    {
+        variableOperands.resize(handle + 1, NO_OPERAND);
+    }
+    variableOperands[handle] = icg.variable(irName(handle));
+    return handle;
+}
+
+string AstLowering::irName(SymbolHandle handle) const
+{
+    // A declaration that shadows an outer one needs an IR variable of its
+    // own; it is named after its scope depth, e.g. x.2
+    const SymbolTableEntry &entry = symTable.entry(handle);
+    string name(symTable.name(handle));
+    if (entry.shadowed != NO_HANDLE)
+    {
+        name += "." + to_string(entry.depth);
+    }
+    return name;
+}
+
+OperandId AstLowering::operandOf(SymbolHandle handle)
+{
+    // A variable declared through another AstLowering has no operand here
+    // until its first use
+    if (variableOperands.size() <= handle)
+    {
+        variableOperands.resize(handle + 1, NO_OPERAND);
+    }
+    if (variableOperands[handle] == NO_OPERAND)
+    {
+        variableOperands[handle] = icg.variable(irName(handle));
+    }
+    return variableOperands[handle];
+}
+
+OperandId AstLowering::variableOperand(uint32_t symbol, string_view name)
+{
+    SymbolHandle handle = symTable.lookup(symbol);
+    if (handle == NO_HANDLE)
+    {
+        // Reads of undeclared names are not diagnosed yet
+        return icg.variable(name);
+    }
+    return operandOf(handle);
+}
+
+void AstLowering::lowerProgram(const Program *program)
+{
+    lowerStatements(program->statements);
+}
+
+void AstLowering::lowerStatements(const NodeList<Stmt *> &statements)
+{
+    for (const Stmt *stmt : statements)
+    {
+        lowerStatement(stmt);
+    }
+}
+
+void AstLowering::lowerStatement(const Stmt *stmt)
+{
+    switch (stmt->kind)
+    {
+        case StmtKind::DECLARATION:
+            lowerDeclaration(static_cast<const DeclarationStmt *>(stmt));
+            break;
+        case StmtKind::ASSIGNMENT:
+            lowerAssignment(static_cast<const AssignmentStmt *>(stmt));
+            break;
+        case StmtKind::FOR_STEP:
+            lowerForStep(static_cast<const ForStepStmt *>(stmt));
+            break;
+        case StmtKind::IF:
+        case StmtKind::AGAR:
+            lowerIf(static_cast<const IfStmt *>(stmt));
+            break;
+        case StmtKind::WHILE:
+            lowerWhile(static_cast<const WhileStmt *>(stmt));
+            break;
+        case StmtKind::DO_WHILE:
+            lowerDoWhile(static_cast<const DoWhileStmt *>(stmt));
+            break;
+        case StmtKind::FOR:
+            lowerFor(static_cast<const ForStmt *>(stmt));
+            break;
+        case StmtKind::SWITCH:
+            lowerSwitch(static_cast<const SwitchStmt *>(stmt));
+            break;
+        case StmtKind::BLOCK:
+            symTable.enterScope();
+            lowerStatements(static_cast<const BlockStmt *>(stmt)->statements);
+            symTable.exitScope();
+            break;
+        case StmtKind::RETURN:
+            icg.addInstruction(Opcode::RETURN, NO_OPERAND,
+                               lowerExpression(static_cast<const ReturnStmt *>(stmt)->value));
+            break;
+        case StmtKind::VOID_FUNCTION:
+            // Function bodies are emitted inline, in a scope of their own
+            symTable.enterScope();
+            lowerStatements(static_cast<const VoidFunctionStmt *>(stmt)->body->statements);
+            symTable.exitScope();
+            break;
+        case StmtKind::BREAK:
+        case StmtKind::PRINT:
+        case StmtKind::INPUT:
+            // Parsed and checked, but they generate no code yet
+            break;
+    }
+}
+
+void AstLowering::lowerDeclaration(const DeclarationStmt *stmt)
+{
+    // Declare the variable in the current scope
+    SymbolHandle handle = declare(stmt->symbol, stmt->varType, stmt->lineNumber);
+    SymbolTableEntry &entry = symTable.entry(handle);
+    VarType varType = entry.type;
+    OperandId var = operandOf(handle);
+
+    if (stmt->form == ValueForm::STRING)
+    {
+        string strValue(stmt->literal);
+
+        // Validate type compatibility
+        if (varType != VarType::STRING) {
+            diagnostics.error(stmt->lineNumber, string("Type mismatch: Cannot assign string to ") + varTypeName(varType));
+            return;
+        }
+
+        entry.setText(symTable.internText(strValue));
+        icg.addInstruction(Opcode::COPY, var, icg.constant(strValue));
+    }
+    else if (stmt->form == ValueForm::BOOL)
+    {
+        string boolValue(stmt->literal);
+
+        // Validate type compatibility
+        if (varType != VarType::BOOL) {
+            diagnostics.error(stmt->lineNumber, string("Type mismatch: Cannot assign boolean to ") + varTypeName(varType));
+            return;
+        }
+
+        entry.setBool(boolValue == "true");
+        icg.addInstruction(Opcode::COPY, var, icg.constant(boolValue));
+    }
+    else if (stmt->form == ValueForm::EXPRESSION)
+    {
+        OperandId value = lowerExpression(stmt->value);
+        const string &expr = icg.operandName(value);
+
+        // Set value based on type. Only a constant has a value to record; a
+        // computed initializer is remembered as text, like in assignments
+        if (icg.operandKinds[value] != OperandKind::CONSTANT) {
+            entry.setText(symTable.internText(expr));
+        }
+        else if (varType == VarType::INT || varType == VarType::FLOAT || varType == VarType::DOUBLE) {
+            // A literal that does not fit the type is an error of its own;
+            // one that is not a number at all records no value
+            int intValue = 0;
+            float floatValue = 0;
+            double doubleValue = 0;
+            const char *first = expr.data();
+            const char *last = expr.data() + expr.size();
+            from_chars_result parsed =
+                varType == VarType::INT ? from_chars(first, last, intValue)
+                : varType == VarType::FLOAT ? from_chars(first, last, floatValue)
+                : from_chars(first, last, doubleValue);
+            if (parsed.ec == errc::result_out_of_range) {
+                diagnostics.error(stmt->lineNumber, "Semantic error: Constant " + expr + " out of range for " + varTypeName(varType));
+                return;
+            }
+            if (parsed.ec == errc()) {
+                if (varType == VarType::INT) entry.setInt(intValue);
+                else if (varType == VarType::FLOAT) entry.setFloat(floatValue);
+                else entry.setDouble(doubleValue);
+            }
+        }
+
+        icg.addInstruction(Opcode::COPY, var, value);
+    }
+}
+
+void AstLowering::lowerAssignment(const AssignmentStmt *stmt)
+{
+    // Verify variable is declared
+    SymbolHandle handle = symTable.lookup(stmt->symbol);
+    if (handle == NO_HANDLE) {
+        diagnostics.error(stmt->lineNumber, "Semantic error: Variable '" + string(stmt->name) + "' not declared before assignment");
+        return;
+    }
+
+    // Get the variable's type for type checking
+    SymbolTableEntry &entry = symTable.entry(handle);
+    VarType varType = entry.type;
+    OperandId var = operandOf(handle);
+
+    if (stmt->form == ValueForm::BOOL)
+    {
+        string boolValue(stmt->literal);
+
+        // Validate type compatibility
+        if (varType != VarType::BOOL) {
+            diagnostics.error(stmt->lineNumber, string("Type mismatch: Cannot assign boolean to ") + varTypeName(varType));
+            return;
+        }
+
+        entry.setBool(boolValue == "true");
+        icg.addInstruction(Opcode::COPY, var, icg.constant(boolValue));
+    }
+    else if (stmt->form == ValueForm::STRING)
+    {
+        string strValue(stmt->literal);
+
+        // Validate type compatibility
+        if (varType != VarType::STRING) {
+            diagnostics.error(stmt->lineNumber, string("Type mismatch: Cannot assign string to ") + varTypeName(varType));
+            return;
+        }
+
+        entry.setText(symTable.internText(strValue));
+        icg.addInstruction(Opcode::COPY, var, icg.constant(strValue));
+    }
+    else
+    {
+        OperandId value = lowerExpression(stmt->value);
+
+        // Numeric variables remember the expression they were last given
+        if (varType == VarType::INT || varType == VarType::FLOAT || varType == VarType::DOUBLE) {
+            entry.setText(symTable.internText(icg.operandName(value)));
+        }
+
+        icg.addInstruction(Opcode::COPY, var, value);
+    }
+}
+
+void AstLowering::lowerForStep(const ForStepStmt *stmt)
+{
+    OperandId var = variableOperand(stmt->symbol, stmt->name);
+    if (stmt->op == T_PLUS) {
+        icg.addInstruction(Opcode::ADD, var, var, icg.constant("1"));
+    } else if (stmt->op == T_MINUS) {
+        icg.addInstruction(Opcode::SUB, var, var, icg.constant("1"));
+    } else {
+        OperandId value = lowerExpression(stmt->value);
+        icg.addInstruction(Opcode::COPY, var, value);
+    }
+}
+
+void AstLowering::lowerIf(const IfStmt *stmt)
+{
+    Opcode branch = stmt->kind == StmtKind::AGAR ? Opcode::AGAR_GOTO : Opcode::IF_GOTO;
+
+    OperandId cond = lowerExpression(stmt->condition);
+    OperandId temp = icg.newTemp();
+    icg.addInstruction(Opcode::COPY, temp, cond);
+
+    // Every if gets labels of its own, so that nested and consecutive
+    // statements never share a jump target
+    OperandId thenLabel = icg.newLabel();
+    OperandId elseLabel = icg.newLabel();
+
+    icg.addInstruction(branch, thenLabel, temp);
+    icg.addInstruction(Opcode::GOTO, elseLabel);
+    icg.addInstruction(Opcode::LABEL, thenLabel);
+
+    lowerStatement(stmt->thenBranch);
+
+    if (stmt->elseBranch != nullptr)
+    {
+        OperandId endLabel = icg.newLabel();
+        icg.addInstruction(Opcode::GOTO, endLabel);
+        icg.addInstruction(Opcode::LABEL, elseLabel);
+        lowerStatement(stmt->elseBranch);
+        icg.addInstruction(Opcode::LABEL, endLabel);
+    }
+    else
+    {
+        icg.addInstruction(Opcode::LABEL, elseLabel);
+    }
+}
+
+void AstLowering::lowerWhile(const WhileStmt *stmt)
+{
+    OperandId startLabel = icg.newLabel();
+    OperandId endLabel = icg.newLabel();
+
+    icg.addInstruction(Opcode::GOTO, startLabel);
+    icg.addInstruction(Opcode::LABEL, startLabel);
+
+    OperandId condition = lowerExpression(stmt->condition);
+
+    OperandId temp = icg.newTemp();
+    icg.addInstruction(Opcode::COPY, temp, condition);
+
+    // Leave the loop once the condition is false
+    icg.addInstruction(Opcode::IF_NOT_GOTO, endLabel, temp);
+
+    lowerStatement(stmt->body);
+
+    icg.addInstruction(Opcode::GOTO, startLabel);
+    icg.addInstruction(Opcode::LABEL, endLabel);
+}
+
+void AstLowering::lowerDoWhile(const DoWhileStmt *stmt)
+{
+    // Generate start label for the do-while loop
+    OperandId startLabel = icg.newLabel("_do_while_start");
+    icg.addInstruction(Opcode::LABEL, startLabel);
+
+    lowerStatement(stmt->body);
+
+    // Generate label for condition check
+    OperandId conditionLabel = icg.newLabel("_do_while_condition");
+    icg.addInstruction(Opcode::LABEL, conditionLabel);
+
+    OperandId conditionExpr = lowerExpression(stmt->condition);
+
+    // Generate condition check instruction
+    OperandId conditionTemp = icg.newTemp();
+    icg.addInstruction(Opcode::COPY, conditionTemp, conditionExpr);
+
+    // Generate conditional jump back to start of loop
+    OperandId endLabel = icg.newLabel("_do_while_end");
+    icg.addInstruction(Opcode::IF_NOT_GOTO, endLabel, conditionTemp);
+    icg.addInstruction(Opcode::GOTO, startLabel);
+    icg.addInstruction(Opcode::LABEL, endLabel);
+}
+
+void AstLowering::lowerFor(const ForStmt *stmt)
+{
+    OperandId initLabel = icg.newLabel();
+    OperandId startLabel = icg.newLabel();
+    OperandId endLabel = icg.newLabel();
+
+    // The loop variable is local to the loop
+    symTable.enterScope();
+    lowerDeclaration(stmt->init);
+    icg.addInstruction(Opcode::LABEL, initLabel);
+
+    // Test, body, then step, and back to the test
+    OperandId condition = lowerExpression(stmt->condition);
+    icg.addInstruction(Opcode::IF_NOT_GOTO, endLabel, condition);
+
+    icg.addInstruction(Opcode::LABEL, startLabel);
+    lowerStatement(stmt->body);
+    lowerForStep(stmt->step);
+    icg.addInstruction(Opcode::GOTO, initLabel);
+    icg.addInstruction(Opcode::LABEL, endLabel);
+    symTable.exitScope();
+}
+
+void AstLowering::lowerSwitch(const SwitchStmt *stmt)
+{
+    OperandId switchExpr = lowerExpression(stmt->subject);
+
+    // Generate labels for switch statement
+    OperandId endSwitchLabel = icg.newLabel("_switch_end");
+
+    // The cases share the scope of the switch body
+    symTable.enterScope();
+
+    for (const SwitchCase &switchCase : stmt->cases)
+    {
+        if (switchCase.label == nullptr)
+        {
+            // default:
+            lowerStatements(switchCase.body);
+            continue;
+        }
+
+        OperandId caseExpr = lowerExpression(switchCase.label);
+
+        // Generate a unique label for this case
+        icg.newLabel("_case");
+
+        // Add comparison instruction
+        OperandId compareTemp = icg.newTemp();
+        icg.addInstruction(Opcode::EQ, compareTemp, switchExpr, caseExpr);
+
+        // Add conditional jump
+        OperandId nextCaseLabel = icg.newLabel("_next_case");
+        icg.addInstruction(Opcode::IF_NOT_GOTO, nextCaseLabel, compareTemp);
+
+        lowerStatements(switchCase.body);
+
+        // Add unconditional jump to end of switch
+        icg.addInstruction(Opcode::GOTO, endSwitchLabel);
+
+        // Label for next case
+        icg.addInstruction(Opcode::LABEL, nextCaseLabel);
+    }
+
+    symTable.exitScope();
+    icg.addInstruction(Opcode::LABEL, endSwitchLabel);
+}
+
+OperandId AstLowering::lowerExpression(const Expr *expr)
+{
+    switch (expr->kind)
+    {
+        case ExprKind::NUMBER:
+        case ExprKind::FLOAT:
+        case ExprKind::BOOL:
+            return icg.constant(static_cast<const LiteralExpr *>(expr)->text);
+        case ExprKind::IDENTIFIER:
+        {
+            const IdentifierExpr *identifier = static_cast<const IdentifierExpr *>(expr);
+            return variableOperand(identifier->symbol, identifier->name);
+        }
+        case ExprKind::BINARY:
+        {
+            const BinaryExpr *binary = static_cast<const BinaryExpr *>(expr);
+            OperandId lhs = lowerExpression(binary->lhs);
+            OperandId rhs = lowerExpression(binary->rhs);
+            OperandId temp = icg.newTemp();
+            icg.addInstruction(binaryOpcode(binary->op), temp, lhs, rhs);
+            return temp;
+        }
+    }
+    return NO_OPERAND;
+}
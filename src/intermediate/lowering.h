@@ -0,0 +1,55 @@
+#ifndef AST_LOWERING_H
+#define AST_LOWERING_H
+#include<string>
+#include<vector>
+#include "../ast/ast.h"
+#include "../symboltable/symbTable.h"
+#include "./icg.h"
+#include "../diagnostics/diagnostics.h"
+using namespace std;
+
+// Walks the syntax tree built by the Parser, performs the semantic checks
+// against the SymbolTable and emits three address code into the
+// IntermediateCodeGnerator. Temporaries and labels share one counter and
+// are numbered in the order they are needed.
+//
+// Semantic errors go to `diagnostics` and the offending statement emits
+// nothing, so lowering carries on to find the rest.
+class AstLowering
+{
+public:
+    AstLowering(SymbolTable &symTable, IntermediateCodeGnerator &icg, Diagnostics &diagnostics);
+    void lowerProgram(const Program *program);
+
+    // One statement in the current scope. Lowering a program's top-level
+    // statements one at a time, each with its own AstLowering and
+    // IntermediateCodeGnerator but a shared SymbolTable, gives the same
+    // code as lowerProgram()
+    void lowerStatement(const Stmt *stmt);
+
+private:
+    SymbolTable &symTable;
+    IntermediateCodeGnerator &icg;
+    Diagnostics &diagnostics;
+
+    // IR operand of each declared variable, indexed by SymbolHandle
+    vector<OperandId> variableOperands;
+
+    void lowerDeclaration(const DeclarationStmt *stmt);
+    void lowerAssignment(const AssignmentStmt *stmt);
+    void lowerForStep(const ForStepStmt *stmt);
+    void lowerIf(const IfStmt *stmt);
+    void lowerWhile(const WhileStmt *stmt);
+    void lowerDoWhile(const DoWhileStmt *stmt);
+    void lowerFor(const ForStmt *stmt);
+    void lowerSwitch(const SwitchStmt *stmt);
+    void lowerStatements(const NodeList<Stmt *> &statements);
+    OperandId lowerExpression(const Expr *expr);
+
+    SymbolHandle declare(uint32_t symbol, TokenType varType, int lineNumber);
+    OperandId variableOperand(uint32_t symbol, string_view name);
+    OperandId operandOf(SymbolHandle handle);
+    string irName(SymbolHandle handle) const;
+};
+
+#endif
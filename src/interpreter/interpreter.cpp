@@ -0,0 +1,330 @@
+#include "./interpreter.h"
+#include<cstdlib>
+#include<stdexcept>
+using namespace std;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define INTERPRETER_THREADED 1
+#else
+#define INTERPRETER_THREADED 0
+#endif
+
+void Interpreter::load(const IntermediateCodeGnerator &icg)
+{
+    operandKinds = icg.operandKinds;
+    operandNames = icg.operandNames;
+
+    // Constants get their value once, everything else starts at 0
+    initialSlots.assign(icg.operandKinds.size(), Value());
+    for (OperandId id = 0; id < icg.operandKinds.size(); id++)
+    {
+        if (icg.operandKinds[id] != OperandKind::CONSTANT) continue;
+
+        Value &value = initialSlots[id];
+        int32_t integer = 0;
+        const string &spelling = icg.operandName(id);
+        char *end = nullptr;
+        double real = strtod(spelling.c_str(), &end);
+        if (icg.integerConstant(id, integer))
+        {
+            value.kind = Value::INT;
+            value.integer = integer;
+        }
+        else if (!spelling.empty() && *end == '\0')
+        {
+            value.kind = Value::REAL;
+            value.real = real;
+        }
+        else
+        {
+            value.kind = Value::TEXT;
+            value.text = id;
+        }
+    }
+
+    // Labels become the index of the instruction that follows them
+    vector<uint32_t> labelTargets(icg.operandKinds.size(), 0);
+    uint32_t next = 0;
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        if (icg.opcodes[i] == Opcode::LABEL) labelTargets[icg.results[i]] = next;
+        else next++;
+    }
+
+    code.clear();
+    code.reserve(next + 1);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        Opcode opcode = icg.opcodes[i];
+        Instruction instruction{Op::HALT, icg.results[i], icg.arg1s[i], icg.arg2s[i]};
+        switch (opcode)
+        {
+            case Opcode::LABEL:
+                continue;
+            case Opcode::GOTO:
+                instruction.op = Op::JUMP;
+                instruction.result = labelTargets[icg.results[i]];
+                break;
+            case Opcode::IF_GOTO:
+            case Opcode::AGAR_GOTO:
+                instruction.op = Op::JUMP_IF_TRUE;
+                instruction.result = labelTargets[icg.results[i]];
+                break;
+            case Opcode::IF_NOT_GOTO:
+                instruction.op = Op::JUMP_IF_FALSE;
+                instruction.result = labelTargets[icg.results[i]];
+                break;
+            case Opcode::RETURN:
+                instruction.op = Op::RETURN;
+                break;
+            default:
+                // COPY to OR are numbered alike, as checked below
+                instruction.op = static_cast<Op>(static_cast<uint8_t>(opcode) - static_cast<uint8_t>(Opcode::COPY));
+                break;
+        }
+        code.push_back(instruction);
+    }
+    code.push_back({Op::HALT, 0, 0, 0});
+
+#define SAME_OFFSET(name)                                                                           \
+    static_assert(static_cast<uint8_t>(Op::name) ==                                                 \
+                      static_cast<uint8_t>(Opcode::name) - static_cast<uint8_t>(Opcode::COPY),       \
+                  "Op::" #name " must line up with Opcode::" #name)
+    SAME_OFFSET(COPY);
+    SAME_OFFSET(ADD);
+    SAME_OFFSET(SUB);
+    SAME_OFFSET(MUL);
+    SAME_OFFSET(DIV);
+    SAME_OFFSET(LT);
+    SAME_OFFSET(GT);
+    SAME_OFFSET(LE);
+    SAME_OFFSET(GE);
+    SAME_OFFSET(EQ);
+    SAME_OFFSET(NE);
+    SAME_OFFSET(AND);
+    SAME_OFFSET(OR);
+    static_assert(static_cast<uint8_t>(Opcode::OR) + 1 == static_cast<uint8_t>(Opcode::LABEL),
+                  "an Opcode between OR and LABEL needs its own case above");
+#undef SAME_OFFSET
+}
+
+bool Interpreter::truth(const Value &value)
+{
+    switch (value.kind)
+    {
+        case Value::INT:  return value.integer != 0;
+        case Value::REAL: return value.real != 0;
+        default:          return true;
+    }
+}
+
+// Everything but the all-integer fast paths in run()
+Interpreter::Value Interpreter::arithmetic(Op op, const Value &lhs, const Value &rhs) const
+{
+    Value result;
+    if (op == Op::AND || op == Op::OR)
+    {
+        result.integer = op == Op::AND ? (truth(lhs) && truth(rhs)) : (truth(lhs) || truth(rhs));
+        return result;
+    }
+
+    if (lhs.kind == Value::TEXT || rhs.kind == Value::TEXT)
+    {
+        if (lhs.kind == Value::TEXT && rhs.kind == Value::TEXT && (op == Op::EQ || op == Op::NE))
+        {
+            // Equal literals are the same constant
+            result.integer = (lhs.text == rhs.text) == (op == Op::EQ);
+            return result;
+        }
+        throw runtime_error("arithmetic on a string literal");
+    }
+
+    if (lhs.kind == Value::INT && rhs.kind == Value::INT)
+    {
+        // Only division gets here with two integers
+        if (rhs.integer == 0) throw runtime_error("division by zero");
+        // Traps like idiv does in compiled and JIT code
+        if (lhs.integer == INT32_MIN && rhs.integer == -1) throw runtime_error("integer overflow in division");
+        result.integer = lhs.integer / rhs.integer;
+        return result;
+    }
+
+    double x = lhs.kind == Value::INT ? lhs.integer : lhs.real;
+    double y = rhs.kind == Value::INT ? rhs.integer : rhs.real;
+    switch (op)
+    {
+        case Op::LT: result.integer = x < y; return result;
+        case Op::GT: result.integer = x > y; return result;
+        case Op::LE: result.integer = x <= y; return result;
+        case Op::GE: result.integer = x >= y; return result;
+        case Op::EQ: result.integer = x == y; return result;
+        case Op::NE: result.integer = x != y; return result;
+        default: break;
+    }
+
+    result.kind = Value::REAL;
+    switch (op)
+    {
+        case Op::ADD: result.real = x + y; break;
+        case Op::SUB: result.real = x - y; break;
+        case Op::MUL: result.real = x * y; break;
+        default:
+            if (y == 0) throw runtime_error("division by zero");
+            result.real = x / y;
+            break;
+    }
+    return result;
+}
+
+int32_t Interpreter::run()
+{
+    slots = initialSlots;
+    Value *slot = slots.data();
+    const Instruction *start = code.data();
+    const Instruction *pc = start;
+    size_t count = 0;
+    int32_t status = 0;
+
+    // Integer arithmetic wraps like the 32-bit machine instructions
+#define WRAP(expression) static_cast<int32_t>(static_cast<uint32_t>(expression))
+
+#define BINARY(name, integerResult)                                             \
+    HANDLER(name)                                                               \
+    {                                                                           \
+        const Value &lhs = slot[pc->a];                                         \
+        const Value &rhs = slot[pc->b];                                         \
+        if (lhs.kind == Value::INT && rhs.kind == Value::INT)                   \
+        {                                                                       \
+            int32_t x = lhs.integer, y = rhs.integer;                           \
+            Value &result = slot[pc->result];                                   \
+            result.kind = Value::INT;                                           \
+            result.integer = (integerResult);                                   \
+        }                                                                       \
+        else                                                                    \
+        {                                                                       \
+            slot[pc->result] = arithmetic(Op::name, lhs, rhs);                  \
+        }                                                                       \
+        pc++;                                                                   \
+        NEXT();                                                                 \
+    }
+
+#if INTERPRETER_THREADED
+    static const void *const handlers[] = {
+        &&op_COPY, &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_LT, &&op_GT, &&op_LE, &&op_GE,
+        &&op_EQ, &&op_NE, &&op_AND, &&op_OR, &&op_JUMP, &&op_JUMP_IF_TRUE, &&op_JUMP_IF_FALSE,
+        &&op_RETURN, &&op_HALT
+    };
+#define HANDLER(name) op_##name:
+#define NEXT() do { count++; goto *handlers[static_cast<uint8_t>(pc->op)]; } while (0)
+    NEXT();
+#else
+#define HANDLER(name) case Op::name:
+#define NEXT() do { count++; goto dispatch; } while (0)
+dispatch:
+    switch (pc->op)
+    {
+#endif
+
+    HANDLER(COPY)
+    {
+        slot[pc->result] = slot[pc->a];
+        pc++;
+        NEXT();
+    }
+
+    BINARY(ADD, WRAP(uint32_t(x) + uint32_t(y)))
+    BINARY(SUB, WRAP(uint32_t(x) - uint32_t(y)))
+    BINARY(MUL, WRAP(uint32_t(x) * uint32_t(y)))
+
+    HANDLER(DIV)
+    {
+        slot[pc->result] = arithmetic(Op::DIV, slot[pc->a], slot[pc->b]);
+        pc++;
+        NEXT();
+    }
+
+    BINARY(LT, x < y)
+    BINARY(GT, x > y)
+    BINARY(LE, x <= y)
+    BINARY(GE, x >= y)
+    BINARY(EQ, x == y)
+    BINARY(NE, x != y)
+    BINARY(AND, x != 0 && y != 0)
+    BINARY(OR, x != 0 || y != 0)
+
+    HANDLER(JUMP)
+    {
+        pc = start + pc->result;
+        NEXT();
+    }
+
+    HANDLER(JUMP_IF_TRUE)
+    {
+        pc = truth(slot[pc->a]) ? start + pc->result : pc + 1;
+        NEXT();
+    }
+
+    HANDLER(JUMP_IF_FALSE)
+    {
+        pc = truth(slot[pc->a]) ? pc + 1 : start + pc->result;
+        NEXT();
+    }
+
+    HANDLER(RETURN)
+    {
+        const Value &value = slot[pc->a];
+        if (value.kind == Value::REAL)
+        {
+            // Truncated toward zero, which has to land in int32 (NaN never does)
+            if (!(value.real > -2147483649.0 && value.real < 2147483648.0))
+            {
+                throw runtime_error("return value out of range: " + to_string(value.real));
+            }
+            status = static_cast<int32_t>(value.real);
+        }
+        else
+        {
+            status = value.kind == Value::INT ? value.integer : 0;
+        }
+        goto done;
+    }
+
+    HANDLER(HALT)
+    {
+        goto done;
+    }
+
+#if !INTERPRETER_THREADED
+    }
+#endif
+
+#undef NEXT
+#undef HANDLER
+#undef BINARY
+#undef WRAP
+
+done:
+    executed = count;
+    return status;
+}
+
+string Interpreter::text(const Value &value) const
+{
+    switch (value.kind)
+    {
+        case Value::INT:  return to_string(value.integer);
+        case Value::REAL: return to_string(value.real);
+        default:          return operandNames[value.text];
+    }
+}
+
+void Interpreter::printVariables(ostream &out) const
+{
+    for (OperandId id = 0; id < operandKinds.size(); id++)
+    {
+        if (operandKinds[id] == OperandKind::VARIABLE)
+        {
+            out << operandNames[id] << " = " << text(slots[id]) << endl;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+#include<cstdint>
+#include<iostream>
+#include<string>
+#include<vector>
+#include "../intermediate/icg.h"
+using namespace std;
+
+// Runs the TAC in-process, for --run.
+//
+// load() translates the quadruples into a compact bytecode: labels are
+// dropped and every jump holds the index of the instruction it goes to,
+// and each operand is an index into one array of value slots (the
+// OperandId itself), with the constants' slots filled in up front. run()
+// then dispatches through a table of label addresses (computed goto)
+// where the compiler supports it, and through a switch elsewhere.
+//
+// Integers behave as in the generated machine code: 32 bits, wrapping on
+// overflow. Floating point literals compute as doubles, and string
+// literals can only be copied and compared for equality.
+class Interpreter
+{
+public:
+    struct Value
+    {
+        enum Kind : uint8_t { INT, REAL, TEXT } kind = INT;
+        union
+        {
+            int32_t integer;
+            double real;
+            OperandId text;     // constant holding the literal
+        };
+
+        Value() : integer(0) {}
+    };
+
+    void load(const IntermediateCodeGnerator &icg);
+
+    // Runs from the first instruction; returns the value of the `return`
+    // that ended the program, or 0 if it ran off the end. Throws
+    // runtime_error on a division by zero or arithmetic on text.
+    int32_t run();
+
+    // Final value of every variable, in order of first use
+    void printVariables(ostream &out) const;
+
+    size_t executedInstructions() const { return executed; }
+
+private:
+    enum class Op : uint8_t
+    {
+        COPY, ADD, SUB, MUL, DIV, LT, GT, LE, GE, EQ, NE, AND, OR,
+        JUMP,               // goto target
+        JUMP_IF_TRUE,       // if slot a goto target
+        JUMP_IF_FALSE,      // if !slot a goto target
+        RETURN,             // return slot a
+        HALT                // end of the program
+    };
+
+    struct Instruction
+    {
+        Op op;
+        uint32_t result;    // slot, or instruction index for jumps
+        uint32_t a;
+        uint32_t b;
+    };
+
+    vector<Instruction> code;
+    vector<Value> initialSlots;
+    vector<Value> slots;
+    vector<OperandKind> operandKinds;
+    vector<string> operandNames;
+    size_t executed = 0;
+
+    Value arithmetic(Op op, const Value &lhs, const Value &rhs) const;
+    static bool truth(const Value &value);
+    string text(const Value &value) const;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "./jit.h"
+#include<cstring>
+#include<stdexcept>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/mman.h>
+#include <unistd.h>
+#include <csetjmp>
+#include <csignal>
+#include <ucontext.h>
+#define JIT_SUPPORTED 1
+#endif
+
+using namespace std;
+
+static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+JitProgram::~JitProgram()
+{
+#ifdef JIT_SUPPORTED
+    if (memory != nullptr) munmap(memory, mappedSize);
+#endif
+}
+
+void JitProgram::load(const X86Encoder &encoder, const vector<OperandId> &dataSlots)
+{
+#ifdef JIT_SUPPORTED
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    dataOffset = (encoder.bytes.size() + page - 1) / page * page;
+    size_t dataSize = dataSlots.size() * 4;
+    mappedSize = dataOffset + (dataSize + page - 1) / page * page;
+    if (mappedSize == 0) mappedSize = page;
+
+    void *addr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) throw runtime_error("cannot map memory for the JIT");
+    memory = static_cast<uint8_t *>(addr);
+    memcpy(memory, encoder.bytes.data(), encoder.bytes.size());
+
+    slotOffsets.clear();
+    for (size_t slot = 0; slot < dataSlots.size(); slot++)
+    {
+        OperandId id = dataSlots[slot];
+        if (id >= slotOffsets.size()) slotOffsets.resize(id + 1, NO_SLOT);
+        slotOffsets[id] = static_cast<uint32_t>(slot * 4);
+    }
+
+    for (const Relocation &relocation : encoder.relocations)
+    {
+        if (relocation.symbol >= slotOffsets.size() || slotOffsets[relocation.symbol] == NO_SLOT)
+        {
+            throw runtime_error("machine code refers to an operand without a .data slot");
+        }
+        int64_t target = static_cast<int64_t>(dataOffset + slotOffsets[relocation.symbol]);
+        int32_t value = static_cast<int32_t>(target + relocation.addend - relocation.offset);
+        memcpy(memory + relocation.offset, &value, sizeof value);
+    }
+
+    if (dataOffset > 0 && mprotect(memory, dataOffset, PROT_READ | PROT_EXEC) != 0)
+    {
+        throw runtime_error("cannot make the JIT code executable");
+    }
+#else
+    (void)encoder;
+    (void)dataSlots;
+    throw runtime_error("the JIT needs an x86-64 host");
+#endif
+}
+
+#ifdef JIT_SUPPORTED
+// idiv faults on a zero divisor and on INT_MIN / -1; the handler jumps back
+// out of the generated code so that run() can report it like the
+// interpreter does. Both faults raise the same signal, so the divisor,
+// which the code generator always puts in ebx, tells them apart.
+static sigjmp_buf faultReturn;
+static volatile sig_atomic_t faultDivisor;
+
+static void onDivisionFault(int, siginfo_t *, void *context)
+{
+#if defined(__linux__)
+    faultDivisor = static_cast<int32_t>(static_cast<ucontext_t *>(context)->uc_mcontext.gregs[REG_RBX]);
+#elif defined(__APPLE__)
+    faultDivisor = static_cast<int32_t>(static_cast<ucontext_t *>(context)->uc_mcontext->__ss.__rbx);
+#else
+    (void)context;
+    faultDivisor = 0;
+#endif
+    siglongjmp(faultReturn, 1);
+}
+#endif
+
+int32_t JitProgram::run()
+{
+    if (memory == nullptr) throw runtime_error("no code loaded");
+    auto entry = reinterpret_cast<int32_t (*)()>(memory);
+#ifdef JIT_SUPPORTED
+    struct sigaction action = {}, previous;
+    action.sa_sigaction = onDivisionFault;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGFPE, &action, &previous);
+    if (sigsetjmp(faultReturn, 1) != 0)
+    {
+        sigaction(SIGFPE, &previous, nullptr);
+        throw runtime_error(faultDivisor == -1 ? "integer overflow in division" : "division by zero");
+    }
+    int32_t status = entry();
+    sigaction(SIGFPE, &previous, nullptr);
+    return status;
+#else
+    return entry();
+#endif
+}
+
+int32_t JitProgram::slotValue(OperandId id) const
+{
+    int32_t value;
+    memcpy(&value, memory + dataOffset + slotOffsets[id], sizeof value);
+    return value;
+}
@@ -0,0 +1,40 @@
+#ifndef JIT_H
+#define JIT_H
+#include<cstdint>
+#include<vector>
+#include "../assembly/encoder.h"
+using namespace std;
+
+// Runs machine code from X86Encoder in-process, for --jit.
+//
+// The code and a zeroed dword per .data slot are copied into freshly
+// mapped pages, right after one another, so the RIP-relative references
+// to the slots can be patched directly. The code pages are then made
+// executable and read-only, and the data pages stay writable.
+//
+// Needs an x86-64 POSIX host; elsewhere load() throws runtime_error.
+class JitProgram
+{
+public:
+    JitProgram() = default;
+    ~JitProgram();
+
+    JitProgram(const JitProgram &) = delete;
+    JitProgram &operator=(const JitProgram &) = delete;
+
+    // The code must come from a callable AssemblyCodeGenerator
+    void load(const X86Encoder &encoder, const vector<OperandId> &dataSlots);
+
+    int32_t run();
+
+    // Current value in the .data slot of an operand that has one
+    int32_t slotValue(OperandId id) const;
+
+private:
+    uint8_t *memory = nullptr;
+    size_t mappedSize = 0;
+    size_t dataOffset = 0;
+    vector<uint32_t> slotOffsets;   // by OperandId, from the data area
+};
+
+#endif
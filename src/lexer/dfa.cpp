@@ -0,0 +1,82 @@
+#include "./lexer.h"
+#include "./dfa.h"
+#include "./keywords.h"
+#include "./scan.h"
+
+using namespace std;
+
+Token Lexer::scanDfa()
+{
+    const char *data = src.data();
+    size_t end = src.size();
+
+    while (pos < end)
+    {
+        size_t start = pos;
+        uint8_t state = S_START;
+        while (pos < end)
+        {
+            uint8_t next = LEXER_DFA.next[state][LEXER_DFA.charClass[static_cast<unsigned char>(data[pos])]];
+            if (next == DFA_STOP) break;
+            state = next;
+            pos++;
+        }
+
+        switch (LEXER_DFA.action[state])
+        {
+        case A_TOKEN:
+            return makeToken(LEXER_DFA.accept[state], start, pos - start);
+
+        case A_IDENTIFIER:
+        {
+            string_view word = src.substr(start, pos - start);
+            TokenType type = lookupKeyword(word);
+            uint32_t symbol = type == T_ID ? pool.intern(word) : StringPool::NO_SYMBOL;
+            return makeToken(type, start, word.size(), symbol);
+        }
+
+        case A_NEWLINE:
+            lineNumber++;
+            // fall through
+        case A_SPACE:
+            if (pos < end && isspace(data[pos]))
+            {
+                int newlines = 0;
+                pos = scanWhitespace(data, pos, end, newlines);
+                lineNumber += newlines;
+            }
+            break;
+
+        case A_PREPROCESSOR:
+            pos = scanLineEnd(data, pos, end);
+            return makeToken(T_PREPROCESSOR, start, pos - start);
+
+        case A_STRING:
+        {
+            pos = start;
+            uint32_t symbol = StringPool::NO_SYMBOL;
+            string_view strValue = consumeString(symbol);
+            return makeToken(T_STRING, strValue.data() - data, strValue.size(), symbol);
+        }
+
+        case A_LINE_COMMENT:
+            pos = scanLineEnd(data, pos, end);
+            break;
+
+        case A_BLOCK_COMMENT:
+        {
+            int newlines = 0;
+            pos = scanBlockCommentEnd(data, pos, end, newlines);
+            lineNumber += newlines;
+            pos += 2; // Skip closing */
+            break;
+        }
+
+        default:
+            diagnostics.error(lineNumber, string("Lexical error: unexpected character '") + data[start] + "'");
+            pos = start + 1;
+            break;
+        }
+    }
+    return makeEofToken();
+}
@@ -0,0 +1,201 @@
+#ifndef LEXER_DFA_H
+#define LEXER_DFA_H
+
+#include <cstdint>
+#include "./lexer.h"
+
+// Tables for the DFA lexer engine (LexerEngine::DFA), built at compile time.
+//
+// Every input byte is first mapped to a character class, then the pair
+// (state, class) is looked up in the transition table. The engine follows
+// transitions until it reaches DFA_STOP; the state it stopped in decides
+// what was recognised (its action and, for tokens, its token type). This is
+// the longest-match rule, and it reproduces the if-chain engine exactly,
+// including its quirks: "1e" and "1e+" are floats, and a lone '!', '&' or
+// '|' is an error.
+//
+// Runs that carry no tokens (comment bodies, string contents, blank runs)
+// are handed to the bulk kernels in scan.h once their opening byte(s) have
+// been recognised.
+
+enum DfaCharClass : uint8_t
+{
+    C_OTHER, C_SPACE, C_NEWLINE, C_ALPHA, C_E, C_DIGIT, C_DOT,
+    C_EQUAL, C_BANG, C_LESS, C_GREATER, C_AMP, C_PIPE, C_SLASH, C_STAR,
+    C_PLUS, C_MINUS, C_LPAREN, C_RPAREN, C_LBRACE, C_RBRACE, C_SEMICOLON,
+    C_COLON, C_HASH, C_QUOTE,
+    C_COUNT
+};
+
+enum DfaState : uint8_t
+{
+    S_START, S_SPACE, S_NEWLINE, S_HASH, S_QUOTE,
+    S_ID, S_INT, S_FRAC, S_EXP, S_EXP_SIGN, S_EXP_DIGITS,
+    S_ASSIGN, S_EQ, S_BANG, S_NE, S_LT, S_LE, S_SHL, S_GT, S_GE, S_SHR,
+    S_AMP, S_AND, S_PIPE, S_OR, S_SLASH, S_LINE_COMMENT, S_BLOCK_COMMENT,
+    S_PLUS, S_MINUS, S_STAR, S_LPAREN, S_RPAREN, S_LBRACE, S_RBRACE,
+    S_SEMICOLON, S_COLON,
+    S_COUNT,
+    DFA_STOP = 0xFF
+};
+
+enum DfaAction : uint8_t
+{
+    A_ERROR,          // stopped before recognising anything
+    A_TOKEN,          // token of type DfaTables::accept[state]
+    A_IDENTIFIER,     // identifier or keyword
+    A_SPACE,
+    A_NEWLINE,
+    A_PREPROCESSOR,
+    A_STRING,
+    A_LINE_COMMENT,
+    A_BLOCK_COMMENT
+};
+
+struct DfaTables
+{
+    uint8_t charClass[256];
+    uint8_t next[S_COUNT][C_COUNT];
+    DfaAction action[S_COUNT];
+    TokenType accept[S_COUNT];
+};
+
+constexpr void dfaToken(DfaTables &dfa, DfaState state, TokenType type)
+{
+    dfa.action[state] = A_TOKEN;
+    dfa.accept[state] = type;
+}
+
+constexpr DfaTables buildDfaTables()
+{
+    DfaTables dfa{};
+    for (auto &row : dfa.next)
+        for (auto &cell : row) cell = DFA_STOP;
+    for (auto &action : dfa.action) action = A_ERROR;
+    for (auto &type : dfa.accept) type = T_UNKNOWN;
+
+    // Character classes (isspace/isalpha/isdigit in the C locale)
+    for (int c = 0; c < 256; c++) dfa.charClass[c] = C_OTHER;
+    for (int c = 'a'; c <= 'z'; c++) dfa.charClass[c] = C_ALPHA;
+    for (int c = 'A'; c <= 'Z'; c++) dfa.charClass[c] = C_ALPHA;
+    for (int c = '0'; c <= '9'; c++) dfa.charClass[c] = C_DIGIT;
+    for (char c : {' ', '\t', '\r', '\v', '\f'}) dfa.charClass[static_cast<unsigned char>(c)] = C_SPACE;
+    dfa.charClass['\n'] = C_NEWLINE;
+    dfa.charClass['e'] = C_E;
+    dfa.charClass['E'] = C_E;
+    dfa.charClass['.'] = C_DOT;
+    dfa.charClass['='] = C_EQUAL;
+    dfa.charClass['!'] = C_BANG;
+    dfa.charClass['<'] = C_LESS;
+    dfa.charClass['>'] = C_GREATER;
+    dfa.charClass['&'] = C_AMP;
+    dfa.charClass['|'] = C_PIPE;
+    dfa.charClass['/'] = C_SLASH;
+    dfa.charClass['*'] = C_STAR;
+    dfa.charClass['+'] = C_PLUS;
+    dfa.charClass['-'] = C_MINUS;
+    dfa.charClass['('] = C_LPAREN;
+    dfa.charClass[')'] = C_RPAREN;
+    dfa.charClass['{'] = C_LBRACE;
+    dfa.charClass['}'] = C_RBRACE;
+    dfa.charClass[';'] = C_SEMICOLON;
+    dfa.charClass[':'] = C_COLON;
+    dfa.charClass['#'] = C_HASH;
+    dfa.charClass['"'] = C_QUOTE;
+
+    // Whitespace, preprocessor lines and strings stop after their first byte
+    dfa.next[S_START][C_SPACE] = S_SPACE;
+    dfa.next[S_START][C_NEWLINE] = S_NEWLINE;
+    dfa.next[S_START][C_HASH] = S_HASH;
+    dfa.next[S_START][C_QUOTE] = S_QUOTE;
+    dfa.action[S_SPACE] = A_SPACE;
+    dfa.action[S_NEWLINE] = A_NEWLINE;
+    dfa.action[S_HASH] = A_PREPROCESSOR;
+    dfa.action[S_QUOTE] = A_STRING;
+
+    // Identifiers: alpha (alnum)*
+    dfa.next[S_START][C_ALPHA] = S_ID;
+    dfa.next[S_START][C_E] = S_ID;
+    dfa.next[S_ID][C_ALPHA] = S_ID;
+    dfa.next[S_ID][C_E] = S_ID;
+    dfa.next[S_ID][C_DIGIT] = S_ID;
+    dfa.action[S_ID] = A_IDENTIFIER;
+
+    // Numbers: digit (digit)* ('.' digit*)? ([eE] [+-]? digit*)?
+    dfa.next[S_START][C_DIGIT] = S_INT;
+    dfa.next[S_INT][C_DIGIT] = S_INT;
+    dfa.next[S_INT][C_DOT] = S_FRAC;
+    dfa.next[S_INT][C_E] = S_EXP;
+    dfa.next[S_FRAC][C_DIGIT] = S_FRAC;
+    dfa.next[S_FRAC][C_E] = S_EXP;
+    dfa.next[S_EXP][C_PLUS] = S_EXP_SIGN;
+    dfa.next[S_EXP][C_MINUS] = S_EXP_SIGN;
+    dfa.next[S_EXP][C_DIGIT] = S_EXP_DIGITS;
+    dfa.next[S_EXP_SIGN][C_DIGIT] = S_EXP_DIGITS;
+    dfa.next[S_EXP_DIGITS][C_DIGIT] = S_EXP_DIGITS;
+    dfaToken(dfa, S_INT, T_NUM);
+    dfaToken(dfa, S_FRAC, T_FLOAT);
+    dfaToken(dfa, S_EXP, T_FLOAT);
+    dfaToken(dfa, S_EXP_SIGN, T_FLOAT);
+    dfaToken(dfa, S_EXP_DIGITS, T_FLOAT);
+
+    // One and two character operators
+    dfa.next[S_START][C_EQUAL] = S_ASSIGN;
+    dfa.next[S_ASSIGN][C_EQUAL] = S_EQ;
+    dfa.next[S_START][C_BANG] = S_BANG;
+    dfa.next[S_BANG][C_EQUAL] = S_NE;
+    dfa.next[S_START][C_LESS] = S_LT;
+    dfa.next[S_LT][C_LESS] = S_SHL;
+    dfa.next[S_LT][C_EQUAL] = S_LE;
+    dfa.next[S_START][C_GREATER] = S_GT;
+    dfa.next[S_GT][C_GREATER] = S_SHR;
+    dfa.next[S_GT][C_EQUAL] = S_GE;
+    dfa.next[S_START][C_AMP] = S_AMP;
+    dfa.next[S_AMP][C_AMP] = S_AND;
+    dfa.next[S_START][C_PIPE] = S_PIPE;
+    dfa.next[S_PIPE][C_PIPE] = S_OR;
+    dfaToken(dfa, S_ASSIGN, T_ASSIGN);
+    dfaToken(dfa, S_EQ, T_EQ);
+    dfaToken(dfa, S_NE, T_NE);
+    dfaToken(dfa, S_LT, T_LT);
+    dfaToken(dfa, S_SHL, T_STREAM_INSERTION_OPERATOR);
+    dfaToken(dfa, S_LE, T_LE);
+    dfaToken(dfa, S_GT, T_GT);
+    dfaToken(dfa, S_SHR, T_EXTRACTION_OPERATOR);
+    dfaToken(dfa, S_GE, T_GE);
+    dfaToken(dfa, S_AND, T_LOGICAL_AND);
+    dfaToken(dfa, S_OR, T_LOGICAL_OR);
+
+    // '/' is division unless it opens a comment
+    dfa.next[S_START][C_SLASH] = S_SLASH;
+    dfa.next[S_SLASH][C_SLASH] = S_LINE_COMMENT;
+    dfa.next[S_SLASH][C_STAR] = S_BLOCK_COMMENT;
+    dfaToken(dfa, S_SLASH, T_DIV);
+    dfa.action[S_LINE_COMMENT] = A_LINE_COMMENT;
+    dfa.action[S_BLOCK_COMMENT] = A_BLOCK_COMMENT;
+
+    dfa.next[S_START][C_STAR] = S_STAR;
+    dfa.next[S_START][C_PLUS] = S_PLUS;
+    dfa.next[S_START][C_MINUS] = S_MINUS;
+    dfa.next[S_START][C_LPAREN] = S_LPAREN;
+    dfa.next[S_START][C_RPAREN] = S_RPAREN;
+    dfa.next[S_START][C_LBRACE] = S_LBRACE;
+    dfa.next[S_START][C_RBRACE] = S_RBRACE;
+    dfa.next[S_START][C_SEMICOLON] = S_SEMICOLON;
+    dfa.next[S_START][C_COLON] = S_COLON;
+    dfaToken(dfa, S_STAR, T_MUL);
+    dfaToken(dfa, S_PLUS, T_PLUS);
+    dfaToken(dfa, S_MINUS, T_MINUS);
+    dfaToken(dfa, S_LPAREN, T_LPAREN);
+    dfaToken(dfa, S_RPAREN, T_RPAREN);
+    dfaToken(dfa, S_LBRACE, T_LBRACE);
+    dfaToken(dfa, S_RBRACE, T_RBRACE);
+    dfaToken(dfa, S_SEMICOLON, T_SEMICOLON);
+    dfaToken(dfa, S_COLON, T_COLON);
+
+    return dfa;
+}
+
+constexpr DfaTables LEXER_DFA = buildDfaTables();
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <cstdint>
+#include <string_view>
+#include "./lexer.h"
+
+using namespace std;
+
+// Keyword recognition through a perfect hash built at compile time. Every
+// keyword lands in its own slot of a 64-entry table, so classifying a word
+// costs one hash and at most one string compare regardless of how many
+// keywords there are. The static_assert below fails the build if a new
+// keyword collides with an existing one; retune keywordHash() if it does.
+
+struct Keyword
+{
+    string_view text;
+    TokenType type;
+};
+
+constexpr Keyword KEYWORDS[] = {
+    {"int", T_INT},         {"float", T_FLOAT},     {"double", T_DOUBLE},
+    {"string", T_STRING},   {"char", T_CHAR},       {"bool", T_BOOL},
+    {"true", T_TRUE},       {"false", T_FALSE},     {"else", T_ELSE},
+    {"return", T_RETURN},   {"agar", T_AGAR},       {"if", T_IF},
+    {"magar", T_MAGAR},     {"while", T_WHILE},     {"for", T_FOR},
+    {"switch", T_SWITCH},   {"case", T_CASE},       {"break", T_BREAK},
+    {"continue", T_CONTINUE}, {"default", T_DEFAULT}, {"do", T_DO},
+    {"cout", T_STANDARD_OUTPUT_STREAM}, {"cin", T_STARNDARD_INPUT_STREAM},
+    {"void", T_VOID},
+};
+
+constexpr size_t KEYWORD_TABLE_SIZE = 64;
+constexpr size_t KEYWORD_MIN_LENGTH = 2;
+constexpr size_t KEYWORD_MAX_LENGTH = 8;
+
+constexpr uint32_t keywordHash(string_view word)
+{
+    return (static_cast<uint32_t>(word.size())
+            + static_cast<unsigned char>(word.front()) * 5u
+            + static_cast<unsigned char>(word.back()) * 18u) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+struct KeywordTable
+{
+    Keyword slots[KEYWORD_TABLE_SIZE];
+    bool perfect;
+};
+
+constexpr KeywordTable buildKeywordTable()
+{
+    KeywordTable table{};
+    table.perfect = true;
+    for (auto &slot : table.slots) slot = Keyword{"", T_ID};
+    for (const auto &keyword : KEYWORDS)
+    {
+        Keyword &slot = table.slots[keywordHash(keyword.text)];
+        if (!slot.text.empty()) table.perfect = false;
+        if (keyword.text.size() < KEYWORD_MIN_LENGTH || keyword.text.size() > KEYWORD_MAX_LENGTH) table.perfect = false;
+        slot = keyword;
+    }
+    return table;
+}
+
+constexpr KeywordTable KEYWORD_TABLE = buildKeywordTable();
+
+static_assert(KEYWORD_TABLE.perfect, "keywordHash() is no longer collision free");
+
+// Returns the keyword's token type, or T_ID for ordinary identifiers
+inline TokenType lookupKeyword(string_view word)
+{
+    if (word.size() < KEYWORD_MIN_LENGTH || word.size() > KEYWORD_MAX_LENGTH) return T_ID;
+    const Keyword &slot = KEYWORD_TABLE.slots[keywordHash(word)];
+    return slot.text == word ? slot.type : T_ID;
+}
+
+#endif
@@ -1,97 +1,147 @@
 #include "./lexer.h"
+#include "./keywords.h"
+#include "./scan.h"
 #include<vector>
 #include <iomanip>
+#include<stdexcept>
 
 using namespace std;
 
-Lexer::Lexer(const string &src) : src(src), pos(0), lineNumber(1) {}
+Lexer::Lexer(string_view src, StringPool &pool, Diagnostics &diagnostics, LexerEngine engine)
+        : src(src), pool(pool), diagnostics(diagnostics), engine(engine), pos(0), lineNumber(1), lookaheadHead(0), lookaheadCount(0) {}
+
+Token Lexer::makeToken(TokenType type, size_t start, size_t length, uint32_t symbol) const
+{
+    return Token{type, static_cast<uint32_t>(lineNumber), static_cast<uint32_t>(start),
+                 static_cast<uint32_t>(length), symbol};
+}
+
+Token Lexer::takeToken(TokenType type, size_t length)
+{
+    Token token = makeToken(type, pos, length);
+    pos += length;
+    return token;
+}
+
+Token Lexer::makeEofToken() const
+{
+    // A final line without a trailing newline still counts as a line
+    int eofLine = lineNumber;
+    if (!src.empty() && src.back() != '\n') eofLine++;
+    return Token{T_EOF, static_cast<uint32_t>(eofLine), static_cast<uint32_t>(src.size()), 0, StringPool::NO_SYMBOL};
+}
+
+string_view Lexer::tokenValue(const Token &token) const
+{
+    if (token.symbol != StringPool::NO_SYMBOL) return pool.view(token.symbol);
+    return src.substr(token.offset, token.length);
+}
 
 vector<Token> Lexer::tokenize()
 {
     vector<Token> tokens;
+    do
+    {
+        tokens.push_back(scanToken());
+    } while (tokens.back().type != T_EOF);
+    return tokens;
+}
+
+Token Lexer::scanToken()
+{
+    return engine == LexerEngine::DFA ? scanDfa() : scanIfChain();
+}
+
+const Token &Lexer::peek(size_t k)
+{
+    if (k >= LOOKAHEAD_CAPACITY)
+    {
+        throw logic_error("Internal error: lookahead of " + to_string(k) + " tokens exceeds the lexer buffer");
+    }
+    while (lookaheadCount <= k)
+    {
+        lookahead[(lookaheadHead + lookaheadCount) % LOOKAHEAD_CAPACITY] = scanToken();
+        lookaheadCount++;
+    }
+    return lookahead[(lookaheadHead + k) % LOOKAHEAD_CAPACITY];
+}
+
+Token Lexer::next()
+{
+    Token token = peek();
+    lookaheadHead = (lookaheadHead + 1) % LOOKAHEAD_CAPACITY;
+    lookaheadCount--;
+    return token;
+}
+
+Token Lexer::scanIfChain()
+{
     while (pos < src.size())
     {
         char current = src[pos];
-        // Handle new line
-        if (current == '\n')
-        {
-            lineNumber++;
-            pos++;
-            continue;
-        }
-        // Handle spaces
+        // Handle spaces and new lines. Most gaps between tokens are a single
+        // blank; longer runs (indentation, blank lines) go to the bulk scanner.
         if (isspace(current))
         {
+            if (current == '\n') lineNumber++;
             pos++;
+            if (pos < src.size() && isspace(src[pos]))
+            {
+                int newlines = 0;
+                pos = scanWhitespace(src.data(), pos, src.size(), newlines);
+                lineNumber += newlines;
+            }
             continue;
         }
         // Hanlde Preprocessor Directives
         if (current == '#')
         {
             size_t start = pos;
-            while (pos < src.size() && src[pos] != '\n') pos++;
-            string directive = src.substr(start, pos - start);
-            tokens.push_back(Token{T_PREPROCESSOR, directive, lineNumber});
-            continue;
+            pos = scanLineEnd(src.data(), pos, src.size());
+            return makeToken(T_PREPROCESSOR, start, pos - start);
         }
         
         // Handle ==
         if (current == '=' && pos + 1 < src.size() && src[pos + 1] == '=')
         {
-            tokens.push_back(Token{T_EQ, "==", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_EQ, 2);
         }
         // Handle !=
         if (current == '!' && pos + 1 < src.size() && src[pos + 1] == '=')
         {
-            tokens.push_back(Token{T_NE, "!=", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_NE, 2);
         }
         // Handle <<
         if (current == '<' && pos + 1 < src.size() && src[pos + 1] == '<')
         {
-            tokens.push_back(Token{T_STREAM_INSERTION_OPERATOR, "<<", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_STREAM_INSERTION_OPERATOR, 2);
         }
         // Handle >>
         if (current == '>' && pos + 1 < src.size() && src[pos + 1] == '>')
         {
-            tokens.push_back(Token{T_EXTRACTION_OPERATOR, ">>", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_EXTRACTION_OPERATOR, 2);
         }
         // Handle &&
         if (current == '&' && pos + 1 < src.size() && src[pos + 1] == '&')
         {
-            tokens.push_back(Token{T_LOGICAL_AND, "&&", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_LOGICAL_AND, 2);
         }
         // Handle ||
         if (current == '|' && pos + 1 < src.size() && src[pos + 1] == '|')
         {
-            tokens.push_back(Token{T_LOGICAL_OR, "||", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_LOGICAL_OR, 2);
         }
 
         // Handle <=
         if (current == '<' && pos + 1 < src.size() && src[pos + 1] == '=')
         {
-            tokens.push_back(Token{T_LE, "<=", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_LE, 2);
         }
 
         // Handle >=
         if (current == '>' && pos + 1 < src.size() && src[pos + 1] == '=')
         {
-            tokens.push_back(Token{T_GE, ">=", lineNumber});
-            pos += 2;
-            continue;
+            return takeToken(T_GE, 2);
         }
 
         // Check for comments, Single Line and MultiLine
@@ -107,84 +157,58 @@ vector<Token> Lexer::tokenize()
         if (isdigit(current))
         {
             bool isFloat = false;
-            string number = consumeNumber(isFloat);
+            string_view number = consumeNumber(isFloat);
             TokenType type = isFloat ? T_FLOAT : T_NUM;
-            tokens.push_back(Token{type, number, lineNumber});
-            continue;
+            return makeToken(type, number.data() - src.data(), number.size());
         }
 
         // Handle String
         if (current == '"') // Start of a string
         {
-            string strValue = consumeString();
-            tokens.push_back(Token{T_STRING, strValue, lineNumber});
-            continue;
+            uint32_t symbol = StringPool::NO_SYMBOL;
+            string_view strValue = consumeString(symbol);
+            return makeToken(T_STRING, strValue.data() - src.data(), strValue.size(), symbol);
         }
         // Handle Colon
         if (current == ':') 
         {
-            tokens.push_back(Token{T_COLON, ":", lineNumber});
-            pos ++;
-            continue;
+            return takeToken(T_COLON, 1);
         }
 
         if (isalpha(current))
         {
-            string word = consumeWord();
-            TokenType type = T_ID;
-
-            if (word == "int") type = T_INT;
-            else if (word == "float") type = T_FLOAT;
-            else if (word == "double") type = T_DOUBLE;
-            else if (word == "string") type = T_STRING;
-            else if (word == "char") type = T_CHAR;
-            else if (word == "bool") type = T_BOOL;
-            else if (word == "true") type = T_TRUE;
-            else if (word == "false") type = T_FALSE;
-            else if (word == "else") type = T_ELSE;
-            else if (word == "return") type = T_RETURN;
-            else if (word == "agar") type = T_AGAR;
-            else if (word == "if") type = T_IF;
-            else if (word == "magar") type = T_MAGAR;
-            else if (word == "while") type = T_WHILE;
-            else if (word == "for") type = T_FOR;
-            else if (word == "switch") type = T_SWITCH;
-            else if (word == "case") type = T_CASE;
-            else if (word == "break") type = T_BREAK;
-            else if (word == "continue") type = T_CONTINUE;
-            else if (word == "default") type = T_DEFAULT;
-            else if (word == "do") type = T_DO;
-            else if (word == "cout") type = T_STANDARD_OUTPUT_STREAM;
-            else if (word == "cin") type = T_STARNDARD_INPUT_STREAM;
-            else if (word == "void") type = T_VOID;
-
-            tokens.push_back(Token{type, word, lineNumber});
-            continue;
+            string_view word = consumeWord();
+            TokenType type = lookupKeyword(word);
+
+            // Only identifiers are interned; keywords are fully described by their type
+            uint32_t symbol = type == T_ID ? pool.intern(word) : StringPool::NO_SYMBOL;
+            return makeToken(type, word.data() - src.data(), word.size(), symbol);
         }
 
         switch (current)
         {
-        case '=': tokens.push_back(Token{T_ASSIGN, "=", lineNumber}); break;
-        case '+': tokens.push_back(Token{T_PLUS, "+", lineNumber}); break;
-        case '-': tokens.push_back(Token{T_MINUS, "-", lineNumber}); break;
-        case '*': tokens.push_back(Token{T_MUL, "*", lineNumber}); break;
-        case '/': tokens.push_back(Token{T_DIV, "/", lineNumber}); break;
-        case '(': tokens.push_back(Token{T_LPAREN, "(", lineNumber}); break;
-        case ')': tokens.push_back(Token{T_RPAREN, ")", lineNumber}); break;
-        case '{': tokens.push_back(Token{T_LBRACE, "{", lineNumber}); break;
-        case '}': tokens.push_back(Token{T_RBRACE, "}", lineNumber}); break;
-        case ';': tokens.push_back(Token{T_SEMICOLON, ";", lineNumber}); break;
-        case '>': tokens.push_back(Token{T_GT, ">", lineNumber}); break;
-        case '<': tokens.push_back(Token{T_LT, "<", lineNumber}); break;
-        default: cout << "Unexpected character: " << current << " at line " << lineNumber << endl; exit(1);
+        case '=': return takeToken(T_ASSIGN, 1);
+        case '+': return takeToken(T_PLUS, 1);
+        case '-': return takeToken(T_MINUS, 1);
+        case '*': return takeToken(T_MUL, 1);
+        case '/': return takeToken(T_DIV, 1);
+        case '(': return takeToken(T_LPAREN, 1);
+        case ')': return takeToken(T_RPAREN, 1);
+        case '{': return takeToken(T_LBRACE, 1);
+        case '}': return takeToken(T_RBRACE, 1);
+        case ';': return takeToken(T_SEMICOLON, 1);
+        case '>': return takeToken(T_GT, 1);
+        case '<': return takeToken(T_LT, 1);
+        default:
+            diagnostics.error(lineNumber, string("Lexical error: unexpected character '") + current + "'");
+            pos++;
+            break;
         }
-        pos++;
     }
-    tokens.push_back(Token{T_EOF, "", lineNumber});
-    return tokens;
+    return makeEofToken();
 }
 
-string Lexer::consumeNumber(bool &isFloat)
+string_view Lexer::consumeNumber(bool &isFloat)
 {
     size_t start = pos;
     bool hasDecimalPoint = false;
@@ -201,7 +225,7 @@ string Lexer::consumeNumber(bool &isFloat)
     {
         isFloat = true;
         pos++;
-        if (src[pos] == '+' || src[pos] == '-') pos++;
+        if (pos < src.size() && (src[pos] == '+' || src[pos] == '-')) pos++;
         while (pos < src.size() && isdigit(src[pos])) pos++;
     }
     isFloat = hasDecimalPoint || isFloat;
@@ -209,7 +233,7 @@ string Lexer::consumeNumber(bool &isFloat)
 }
 
 
-string Lexer::consumeWord()
+string_view Lexer::consumeWord()
 {
     size_t start = pos;
     while (pos < src.size() && isalnum(src[pos]))
@@ -217,39 +241,54 @@ string Lexer::consumeWord()
     return src.substr(start, pos - start);
 }
 
-string Lexer::consumeString()
+string_view Lexer::consumeString(uint32_t &symbol)
 {
     size_t start = ++pos; // Skip the initial quote (")
+
+    // Most literals have no escapes and are returned as a slice of the source.
+    // Only when an escape has to be rewritten is the decoded text built up
+    // and interned.
     string result;
+    bool escaped = false;
 
     while (pos < src.size())
     {
+        // Jump straight to the next quote or backslash
+        size_t next = scanStringSpecial(src.data(), pos, src.size());
+        if (escaped) result.append(src.data() + pos, next - pos);
+        pos = next;
+        if (pos >= src.size()) break;
+
         char current = src[pos];
 
-        if (current == '\\' && pos + 1 < src.size()) // Handle escape sequences
+        if (current == '\\' && pos + 1 < src.size() && (src[pos + 1] == '"' || src[pos + 1] == '\\'))
         {
-            char next = src[pos + 1];
-            if (next == '"' || next == '\\') // Escaped quote or backslash
+            // Escaped quote or backslash
+            if (!escaped)
             {
-                result += next;
-                pos += 2;
-                continue;
+                result.assign(src.data() + start, pos - start);
+                escaped = true;
             }
+            result += src[pos + 1];
+            pos += 2;
         }
         else if (current == '"') // End of string
         {
+            string_view raw = src.substr(start, pos - start);
             pos++; // Move past the closing quote
-            return result;
+            if (escaped) symbol = pool.intern(result);
+            return raw;
         }
         else
         {
-            result += current;
+            if (escaped) result += current;
             pos++;
         }
     }
 
-    cout << "Unterminated string at line " << lineNumber << endl;
-    exit(1); // Error: Unterminated string
+    // The rest of the source is the string
+    diagnostics.error(lineNumber, "Lexical error: unterminated string");
+    return src.substr(start);
 }
 
 void Lexer::skipComments()
@@ -258,17 +297,13 @@ void Lexer::skipComments()
     {
         if (src[pos + 1] == '/')
         {
-            pos += 2;
-            while (pos < src.size() && src[pos] != '\n') pos++;
+            pos = scanLineEnd(src.data(), pos + 2, src.size());
         }
         else if (src[pos + 1] == '*')
         {
-            pos += 2;
-            while (pos < src.size() && !(src[pos] == '*' && pos + 1 < src.size() && src[pos + 1] == '/'))
-            {
-                if (src[pos] == '\n') lineNumber++;
-                pos++;
-            }
+            int newlines = 0;
+            pos = scanBlockCommentEnd(src.data(), pos + 2, src.size(), newlines);
+            lineNumber += newlines;
             pos += 2; // Skip closing */
         }
     }
@@ -331,7 +366,7 @@ string Lexer::tokenTypeToString(TokenType type) {
 
 
 
-void Lexer::printTokenizer(const vector<Token> &tokens)
+void Lexer::printTokenizer(ostream &out)
 {
     // Clear the screen
     // system("cls"); 
@@ -342,43 +377,36 @@ void Lexer::printTokenizer(const vector<Token> &tokens)
     const int lineWidth = 10;
 
     // Print top border
-    cout << "+" << string(typeWidth + 2, '-') 
+    out << "+" << string(typeWidth + 2, '-') 
         << "+" << string(valueWidth + 2, '-') 
         << "+" << string(lineWidth + 2, '-') 
         << "+" << endl;
 
     // Print header row
-    cout << "| " << left << setw(typeWidth) << "Token Type"
+    out << "| " << left << setw(typeWidth) << "Token Type"
         << " | " << left << setw(valueWidth) << "Token Value"
         << " | " << left << setw(lineWidth) << "Line No."
         << " |" << endl;
 
     // Print header separator
-    cout << "+" << string(typeWidth + 2, '-') 
+    out << "+" << string(typeWidth + 2, '-') 
         << "+" << string(valueWidth + 2, '-') 
         << "+" << string(lineWidth + 2, '-') 
         << "+" << endl;
 
-    // Check if tokens are empty
-    if (tokens.empty())
+    // Print each token as it is scanned, up to and including EOF
+    Token token;
+    do
     {
-        cout << "| " << left << setw(typeWidth + valueWidth + lineWidth + 7)
-            << "No tokens available." << " |" << endl;
-    }
-    else
-    {
-        // Print each token
-        for (const auto &token : tokens)
-        {
-            cout << "| " << left << setw(typeWidth) << tokenTypeToString(token.type)
-                << " | " << left << setw(valueWidth) << ("\"" + token.value + "\"")
-                << " | " << left << setw(lineWidth) << token.lineNumber
-                << " |" << endl;
-        }
-    }
+        token = next();
+        out << "| " << left << setw(typeWidth) << tokenTypeToString(token.type)
+            << " | " << left << setw(valueWidth) << ("\"" + string(tokenValue(token)) + "\"")
+            << " | " << left << setw(lineWidth) << token.lineNumber
+            << " |" << endl;
+    } while (token.type != T_EOF);
 
     // Print bottom border
-    cout << "+" << string(typeWidth + 2, '-') 
+    out << "+" << string(typeWidth + 2, '-') 
         << "+" << string(valueWidth + 2, '-') 
         << "+" << string(lineWidth + 2, '-') 
         << "+" << endl;
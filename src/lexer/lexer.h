@@ -2,13 +2,17 @@
 #define LEXER_H
 
 #include <iostream>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
+#include "./stringPool.h"
+#include "../diagnostics/diagnostics.h"
 
 using namespace std;
 
 
-enum TokenType
+enum TokenType : uint8_t
 {
     // T_LE <=
     // T_NE !=
@@ -31,28 +35,74 @@ enum TokenType
 };
 
 
+// Tokens do not own their text. The lexeme is the slice [offset, offset +
+// length) of the source buffer; identifiers, and string literals whose
+// escapes had to be rewritten, also carry an id into the shared StringPool.
+// Use Lexer::tokenValue() to get the spelling back.
 struct Token
 {
-    TokenType type;
-    string value;
-    int lineNumber;
+    TokenType type : 8;
+    uint32_t lineNumber : 24;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t symbol;
+};
+
+static_assert(sizeof(Token) == 16, "Token should stay at 16 bytes");
+
+// The lexer has two interchangeable engines that produce identical token
+// streams: the original hand-written if-chain, and a table-driven DFA
+// (see dfa.h) that classifies each byte with one table lookup.
+enum class LexerEngine
+{
+    IF_CHAIN,
+    DFA
 };
 
 class Lexer
 {
+    public:
+        // How far peek() can look past the next token
+        static constexpr size_t LOOKAHEAD_CAPACITY = 8;
+
     private:
-        string src;
+        string_view src;
+        StringPool &pool;
+        Diagnostics &diagnostics;
+        LexerEngine engine;
         size_t pos;
         int lineNumber;
+
+        // Tokens scanned ahead of the parser but not yet consumed
+        Token lookahead[LOOKAHEAD_CAPACITY];
+        size_t lookaheadHead;
+        size_t lookaheadCount;
+
+        Token makeToken(TokenType type, size_t start, size_t length, uint32_t symbol = StringPool::NO_SYMBOL) const;
+        Token takeToken(TokenType type, size_t length);
+        Token makeEofToken() const;
+        Token scanIfChain();
+        Token scanDfa();
     public:
-        Lexer(const string &src);
+        // Characters that start no token and unterminated strings are
+        // reported to `diagnostics` and skipped
+        Lexer(string_view src, StringPool &pool, Diagnostics &diagnostics, LexerEngine engine = LexerEngine::IF_CHAIN);
         vector<Token> tokenize();
-        string consumeNumber(bool &isFloat);
-        string consumeWord();
-        string consumeString();
+        Token scanToken();
+
+        // Pull interface: tokens are scanned on demand into a small ring
+        // buffer, so a consumer never holds more than LOOKAHEAD_CAPACITY
+        // tokens. Once the input is exhausted both keep returning T_EOF.
+        const Token &peek(size_t k = 0);
+        Token next();
+
+        string_view consumeNumber(bool &isFloat);
+        string_view consumeWord();
+        string_view consumeString(uint32_t &symbol);
         void skipComments();
+        string_view tokenValue(const Token &token) const;
         string tokenTypeToString(TokenType type);
-        void printTokenizer(const vector<Token> &tokens);
+        void printTokenizer(ostream &out = cout);
         
 
 };
@@ -0,0 +1,145 @@
+#include "./scan.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_SIMD 1
+typedef __m256i ScanVector;
+static const size_t SCAN_WIDTH = 32;
+static const uint32_t SCAN_FULL_MASK = 0xFFFFFFFFu;
+
+static inline ScanVector loadVector(const char *p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+static inline uint32_t maskEqual(ScanVector v, char c)
+{
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+}
+static inline uint32_t maskWhitespace(ScanVector v)
+{
+    // ' ' or '\t'..'\r': v - 9 <= 4 as unsigned bytes
+    __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(9));
+    __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(control, space)));
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SIMD 1
+typedef __m128i ScanVector;
+static const size_t SCAN_WIDTH = 16;
+static const uint32_t SCAN_FULL_MASK = 0xFFFFu;
+
+static inline ScanVector loadVector(const char *p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+static inline uint32_t maskEqual(ScanVector v, char c)
+{
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+}
+static inline uint32_t maskWhitespace(ScanVector v)
+{
+    // ' ' or '\t'..'\r': v - 9 <= 4 as unsigned bytes
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(9));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(control, space)));
+}
+#endif
+
+#ifdef SCAN_SIMD
+static inline unsigned lowestBit(uint32_t mask)
+{
+    return static_cast<unsigned>(__builtin_ctz(mask));
+}
+static inline int bitCount(uint32_t mask)
+{
+    return __builtin_popcount(mask);
+}
+#endif
+
+static inline bool isSpaceByte(char c)
+{
+    return c == ' ' || (static_cast<unsigned char>(c) - 9u) <= 4u;
+}
+
+size_t scanWhitespace(const char *data, size_t pos, size_t end, int &newlines)
+{
+#ifdef SCAN_SIMD
+    while (pos + SCAN_WIDTH <= end)
+    {
+        ScanVector v = loadVector(data + pos);
+        uint32_t stop = ~maskWhitespace(v) & SCAN_FULL_MASK;
+        uint32_t lines = maskEqual(v, '\n');
+        if (stop)
+        {
+            unsigned k = lowestBit(stop);
+            newlines += bitCount(lines & ((1u << k) - 1));
+            return pos + k;
+        }
+        newlines += bitCount(lines);
+        pos += SCAN_WIDTH;
+    }
+#endif
+    while (pos < end && isSpaceByte(data[pos]))
+    {
+        if (data[pos] == '\n') newlines++;
+        pos++;
+    }
+    return pos;
+}
+
+size_t scanLineEnd(const char *data, size_t pos, size_t end)
+{
+    if (pos >= end) return end;
+    const void *hit = memchr(data + pos, '\n', end - pos);
+    return hit ? static_cast<const char *>(hit) - data : end;
+}
+
+size_t scanBlockCommentEnd(const char *data, size_t pos, size_t end, int &newlines)
+{
+#ifdef SCAN_SIMD
+    while (pos + SCAN_WIDTH <= end)
+    {
+        ScanVector v = loadVector(data + pos);
+        uint32_t stars = maskEqual(v, '*');
+        uint32_t lines = maskEqual(v, '\n');
+        while (stars)
+        {
+            unsigned k = lowestBit(stars);
+            if (pos + k + 1 < end && data[pos + k + 1] == '/')
+            {
+                newlines += bitCount(lines & ((1u << k) - 1));
+                return pos + k;
+            }
+            stars &= stars - 1;
+        }
+        newlines += bitCount(lines);
+        pos += SCAN_WIDTH;
+    }
+#endif
+    while (pos < end && !(data[pos] == '*' && pos + 1 < end && data[pos + 1] == '/'))
+    {
+        if (data[pos] == '\n') newlines++;
+        pos++;
+    }
+    return pos;
+}
+
+size_t scanStringSpecial(const char *data, size_t pos, size_t end)
+{
+#ifdef SCAN_SIMD
+    while (pos + SCAN_WIDTH <= end)
+    {
+        ScanVector v = loadVector(data + pos);
+        uint32_t hits = maskEqual(v, '"') | maskEqual(v, '\\');
+        if (hits) return pos + lowestBit(hits);
+        pos += SCAN_WIDTH;
+    }
+#endif
+    while (pos < end && data[pos] != '"' && data[pos] != '\\') pos++;
+    return pos;
+}
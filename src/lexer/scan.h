@@ -0,0 +1,28 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+
+// Bulk scanning kernels used by the lexer for the byte runs that carry no
+// tokens: whitespace, comment bodies and string literal contents. Each
+// kernel takes the buffer, a start index and the buffer size, and returns
+// the index where the run stops. Kernels that can cross lines also add the
+// number of '\n' they stepped over to `newlines`.
+//
+// The vector width is picked at compile time: 32 bytes with AVX2 (build with
+// -mavx2 or -march=native), 16 bytes with SSE2 (every x86-64 target), and a
+// plain byte loop everywhere else.
+
+// First index at or after pos that is not isspace() in the C locale
+size_t scanWhitespace(const char *data, size_t pos, size_t end, int &newlines);
+
+// Index of the next '\n', or end
+size_t scanLineEnd(const char *data, size_t pos, size_t end);
+
+// Index of the '*' that opens the next "*/", or end if there is none
+size_t scanBlockCommentEnd(const char *data, size_t pos, size_t end, int &newlines);
+
+// Index of the next '"' or '\\', or end
+size_t scanStringSpecial(const char *data, size_t pos, size_t end);
+
+#endif
@@ -0,0 +1,89 @@
+#include "./sourceBuffer.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_BUFFER_MMAP 1
+#endif
+
+using namespace std;
+
+SourceBuffer::SourceBuffer() : data(""), length(0), mapped(false) {}
+
+SourceBuffer::~SourceBuffer()
+{
+    close();
+}
+
+bool SourceBuffer::open(const string &filename)
+{
+    close();
+#ifdef SOURCE_BUFFER_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            // The lexer walks the file front to back exactly once
+            madvise(addr, info.st_size, MADV_SEQUENTIAL);
+            ::close(fd);
+            data = static_cast<const char *>(addr);
+            length = info.st_size;
+            mapped = true;
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+    return readWhole(filename);
+}
+
+void SourceBuffer::close()
+{
+#ifdef SOURCE_BUFFER_MMAP
+    if (mapped)
+    {
+        munmap(const_cast<char *>(data), length);
+    }
+#endif
+    fallback.clear();
+    fallback.shrink_to_fit();
+    data = "";
+    length = 0;
+    mapped = false;
+}
+
+bool SourceBuffer::readWhole(const string &filename)
+{
+    ifstream inputFile(filename, ios::binary);
+    if (!inputFile.is_open()) return false;
+
+    // Size the buffer once when the stream can tell us how big it is,
+    // then pull everything in with one read
+    inputFile.seekg(0, ios::end);
+    streamoff size = inputFile.tellg();
+    if (size > 0)
+    {
+        fallback.resize(size);
+        inputFile.seekg(0, ios::beg);
+        inputFile.read(&fallback[0], size);
+        fallback.resize(inputFile.gcount());
+    }
+    else
+    {
+        inputFile.clear();
+        inputFile.seekg(0, ios::beg);
+        fallback.assign(istreambuf_iterator<char>(inputFile), istreambuf_iterator<char>());
+    }
+
+    data = fallback.data();
+    length = fallback.size();
+    return true;
+}
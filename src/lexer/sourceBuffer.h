@@ -0,0 +1,37 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Read-only view of a source file. On POSIX systems the file is mapped
+// straight into memory, so the lexer scans the page cache without copying
+// it; anything that cannot be mapped (pipes, empty files, other platforms)
+// is loaded with a single bulk read instead.
+class SourceBuffer
+{
+    public:
+        SourceBuffer();
+        ~SourceBuffer();
+
+        SourceBuffer(const SourceBuffer &) = delete;
+        SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+        bool open(const string &filename);
+        void close();
+
+        string_view view() const { return string_view(data, length); }
+        size_t size() const { return length; }
+
+    private:
+        const char *data;
+        size_t length;
+        bool mapped;
+        string fallback;
+
+        bool readWhole(const string &filename);
+};
+
+#endif
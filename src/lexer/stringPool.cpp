@@ -0,0 +1,92 @@
+#include "./stringPool.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+StringPool::StringPool() : slots(256, NO_SYMBOL), chunkUsed(0), chunkCapacity(0) {}
+
+uint32_t StringPool::hash(string_view text)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : text)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint32_t StringPool::find(string_view text) const
+{
+    uint32_t h = hash(text);
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask; slots[i] != NO_SYMBOL; i = (i + 1) & mask)
+    {
+        uint32_t id = slots[i];
+        if (hashes[id] == h && strings[id] == text) return id;
+    }
+    return NO_SYMBOL;
+}
+
+uint32_t StringPool::intern(string_view text)
+{
+    uint32_t h = hash(text);
+    size_t mask = slots.size() - 1;
+    size_t i = h & mask;
+    for (; slots[i] != NO_SYMBOL; i = (i + 1) & mask)
+    {
+        uint32_t id = slots[i];
+        if (hashes[id] == h && strings[id] == text) return id;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(string_view(store(text), text.size()));
+    hashes.push_back(h);
+    slots[i] = id;
+
+    // Keep the table at most half full so probe chains stay short
+    if (strings.size() * 2 > slots.size()) grow();
+    return id;
+}
+
+const char *StringPool::store(string_view text)
+{
+    if (chunks.empty() || text.size() > chunkCapacity - chunkUsed)
+    {
+        // Oversized strings get a chunk of their own
+        chunkCapacity = text.size() > CHUNK_SIZE ? text.size() : CHUNK_SIZE;
+        chunks.emplace_back(new char[chunkCapacity]);
+        chunkUsed = 0;
+    }
+    char *dest = chunks.back().get() + chunkUsed;
+    if (!text.empty()) memcpy(dest, text.data(), text.size());
+    chunkUsed += text.size();
+    return dest;
+}
+
+void StringPool::grow()
+{
+    vector<uint32_t> bigger(slots.size() * 2, NO_SYMBOL);
+    size_t mask = bigger.size() - 1;
+    for (uint32_t id = 0; id < strings.size(); id++)
+    {
+        size_t i = hashes[id] & mask;
+        while (bigger[i] != NO_SYMBOL) i = (i + 1) & mask;
+        bigger[i] = id;
+    }
+    slots.swap(bigger);
+}
+
+void StringPool::clear()
+{
+    strings.clear();
+    hashes.clear();
+    fill(slots.begin(), slots.end(), NO_SYMBOL);
+    // Every chunk holds at least CHUNK_SIZE bytes, so that much of the
+    // first one can be reused whatever its size
+    if (chunks.size() > 1) chunks.resize(1);
+    chunkUsed = 0;
+    chunkCapacity = chunks.empty() ? 0 : CHUNK_SIZE;
+}
@@ -0,0 +1,46 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Interns strings and hands out dense 32-bit ids. Each distinct spelling is
+// stored once, in large chunks that never move, so the views returned by
+// view() stay valid for the lifetime of the pool.
+class StringPool
+{
+    public:
+        static constexpr uint32_t NO_SYMBOL = 0xFFFFFFFFu;
+
+        StringPool();
+
+        uint32_t intern(string_view text);
+        uint32_t find(string_view text) const;
+        string_view view(uint32_t id) const { return strings[id]; }
+        size_t size() const { return strings.size(); }
+
+        // Forgets every string, keeping the first chunk and the table's
+        // capacity for whatever is interned next
+        void clear();
+
+    private:
+        static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+        vector<string_view> strings;
+        vector<uint32_t> hashes;
+        vector<uint32_t> slots;
+        vector<unique_ptr<char[]>> chunks;
+        size_t chunkUsed;
+        size_t chunkCapacity;
+
+        static uint32_t hash(string_view text);
+        const char *store(string_view text);
+        void grow();
+};
+
+#endif
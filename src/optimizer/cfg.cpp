@@ -0,0 +1,207 @@
+#include "./cfg.h"
+using namespace std;
+
+bool isConditionalJump(Opcode op)
+{
+    return op == Opcode::IF_GOTO || op == Opcode::AGAR_GOTO || op == Opcode::IF_NOT_GOTO;
+}
+
+bool isJump(Opcode op)
+{
+    return op == Opcode::GOTO || isConditionalJump(op);
+}
+
+void ControlFlowGraph::build(const IntermediateCodeGnerator &icg)
+{
+    blocks.clear();
+    labelBlocks.assign(icg.operandKinds.size(), NO_BLOCK);
+
+    size_t count = icg.size();
+    size_t begin = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Opcode op = icg.opcodes[i];
+        if (op == Opcode::LABEL && i > begin)
+        {
+            blocks.push_back(BasicBlock{begin, i, {}, {}});
+            begin = i;
+        }
+        if (op == Opcode::LABEL && i == begin)
+        {
+            labelBlocks[icg.results[i]] = static_cast<uint32_t>(blocks.size());
+        }
+        if (isJump(op) || op == Opcode::RETURN)
+        {
+            blocks.push_back(BasicBlock{begin, i + 1, {}, {}});
+            begin = i + 1;
+        }
+    }
+    if (begin < count || blocks.empty())
+    {
+        blocks.push_back(BasicBlock{begin, count, {}, {}});
+    }
+
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        BasicBlock &block = blocks[b];
+        Opcode last = block.end > block.begin ? icg.opcodes[block.end - 1] : Opcode::LABEL;
+
+        if (isJump(last))
+        {
+            uint32_t target = blockOfLabel(icg.results[block.end - 1]);
+            if (target != NO_BLOCK) block.successors.push_back(target);
+        }
+        // Everything but a goto or a return may fall through
+        if (last != Opcode::GOTO && last != Opcode::RETURN && b + 1 < blocks.size())
+        {
+            if (block.successors.empty() || block.successors[0] != b + 1)
+                block.successors.push_back(b + 1);
+        }
+    }
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        for (uint32_t successor : blocks[b].successors)
+        {
+            blocks[successor].predecessors.push_back(b);
+        }
+    }
+}
+
+uint32_t ControlFlowGraph::blockOfLabel(OperandId label) const
+{
+    return label < labelBlocks.size() ? labelBlocks[label] : NO_BLOCK;
+}
+
+vector<bool> ControlFlowGraph::reachable() const
+{
+    vector<bool> seen(blocks.size(), false);
+    vector<uint32_t> work;
+    if (!blocks.empty())
+    {
+        seen[0] = true;
+        work.push_back(0);
+    }
+    while (!work.empty())
+    {
+        uint32_t b = work.back();
+        work.pop_back();
+        for (uint32_t successor : blocks[b].successors)
+        {
+            if (!seen[successor])
+            {
+                seen[successor] = true;
+                work.push_back(successor);
+            }
+        }
+    }
+    return seen;
+}
+
+vector<uint32_t> ControlFlowGraph::reversePostorder() const
+{
+    vector<uint32_t> order;
+    if (blocks.empty()) return order;
+
+    // Iterative depth-first search; each stack entry remembers how many of
+    // its successors have been visited
+    vector<bool> seen(blocks.size(), false);
+    vector<pair<uint32_t, size_t>> stack;
+    stack.push_back({0, 0});
+    seen[0] = true;
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        const vector<uint32_t> &successors = blocks[top.first].successors;
+        if (top.second < successors.size())
+        {
+            uint32_t next = successors[top.second++];
+            if (!seen[next])
+            {
+                seen[next] = true;
+                stack.push_back({next, 0});
+            }
+        }
+        else
+        {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    return vector<uint32_t>(order.rbegin(), order.rend());
+}
+
+// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+void ControlFlowGraph::computeDominators()
+{
+    vector<uint32_t> order = reversePostorder();
+    vector<uint32_t> position(blocks.size(), NO_BLOCK);
+    for (uint32_t i = 0; i < order.size(); i++) position[order[i]] = i;
+
+    idom.assign(blocks.size(), NO_BLOCK);
+    if (order.empty()) return;
+    idom[0] = 0;
+
+    auto intersect = [&](uint32_t a, uint32_t b) {
+        while (a != b)
+        {
+            while (position[a] > position[b]) a = idom[a];
+            while (position[b] > position[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++)
+        {
+            uint32_t b = order[i];
+            uint32_t dominator = NO_BLOCK;
+            for (uint32_t predecessor : blocks[b].predecessors)
+            {
+                if (idom[predecessor] == NO_BLOCK) continue;
+                dominator = dominator == NO_BLOCK ? predecessor : intersect(predecessor, dominator);
+            }
+            if (dominator != idom[b])
+            {
+                idom[b] = dominator;
+                changed = true;
+            }
+        }
+    }
+
+    dominatorChildren.assign(blocks.size(), {});
+    for (uint32_t b : order)
+    {
+        if (b != 0) dominatorChildren[idom[b]].push_back(b);
+    }
+}
+
+bool ControlFlowGraph::dominates(uint32_t a, uint32_t b) const
+{
+    if (idom[b] == NO_BLOCK) return false;
+    while (b != a && b != 0) b = idom[b];
+    return b == a;
+}
+
+vector<vector<uint32_t>> ControlFlowGraph::dominanceFrontiers() const
+{
+    vector<vector<uint32_t>> frontiers(blocks.size());
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        if (idom[b] == NO_BLOCK || blocks[b].predecessors.size() < 2) continue;
+        for (uint32_t predecessor : blocks[b].predecessors)
+        {
+            uint32_t runner = predecessor;
+            while (runner != NO_BLOCK && idom[runner] != NO_BLOCK && runner != idom[b])
+            {
+                vector<uint32_t> &frontier = frontiers[runner];
+                if (frontier.empty() || frontier.back() != b) frontier.push_back(b);
+                if (runner == 0) break;
+                runner = idom[runner];
+            }
+        }
+    }
+    return frontiers;
+}
@@ -0,0 +1,56 @@
+#ifndef CONTROL_FLOW_GRAPH_H
+#define CONTROL_FLOW_GRAPH_H
+#include<cstdint>
+#include<vector>
+#include "../intermediate/icg.h"
+using namespace std;
+
+// A basic block is a run of instructions [begin, end) that is only entered
+// at its first instruction and only left after its last one. Blocks start
+// at the first instruction, at every label and after every jump or return.
+struct BasicBlock
+{
+    size_t begin;
+    size_t end;
+    vector<uint32_t> successors;
+    vector<uint32_t> predecessors;
+};
+
+class ControlFlowGraph
+{
+public:
+    static constexpr uint32_t NO_BLOCK = 0xFFFFFFFFu;
+
+    // Blocks in instruction order; block 0 is the entry
+    vector<BasicBlock> blocks;
+
+    void build(const IntermediateCodeGnerator &icg);
+
+    // Block that starts with the given label, or NO_BLOCK
+    uint32_t blockOfLabel(OperandId label) const;
+
+    // Blocks that can be reached from the entry
+    vector<bool> reachable() const;
+
+    // Reachable blocks, each before its successors except along back edges
+    vector<uint32_t> reversePostorder() const;
+
+    // Immediate dominator of every block (the entry is its own), NO_BLOCK
+    // for unreachable blocks. Filled in by computeDominators().
+    vector<uint32_t> idom;
+    vector<vector<uint32_t>> dominatorChildren;
+
+    void computeDominators();
+    bool dominates(uint32_t a, uint32_t b) const;
+
+    // Blocks where the dominance of each block ends; needs computeDominators()
+    vector<vector<uint32_t>> dominanceFrontiers() const;
+
+private:
+    vector<uint32_t> labelBlocks;   // indexed by OperandId
+};
+
+bool isJump(Opcode op);
+bool isConditionalJump(Opcode op);
+
+#endif
@@ -0,0 +1,232 @@
+#include "./constFold.h"
+#include "./cfg.h"
+#include<cstdint>
+#include<cstdlib>
+using namespace std;
+
+static bool isBinary(Opcode op)
+{
+    return op >= Opcode::ADD && op <= Opcode::OR;
+}
+
+ConstantFolder::Constant ConstantFolder::parse(const IntermediateCodeGnerator &icg, OperandId id) const
+{
+    Constant constant;
+    if (id == NO_OPERAND || icg.operandKinds[id] != OperandKind::CONSTANT)
+    {
+        return constant;
+    }
+
+    const string &text = icg.operandName(id);
+    if (text == "true" || text == "false")
+    {
+        constant.kind = Constant::BOOLEAN;
+        constant.boolean = text == "true";
+        return constant;
+    }
+
+    size_t digits = text.size() - (text[0] == '-' ? 1 : 0);
+    if (digits > 0 && digits <= 18 && text.find_first_not_of("0123456789", text[0] == '-' ? 1 : 0) == string::npos)
+    {
+        constant.kind = Constant::INTEGER;
+        constant.integer = stoll(text);
+        return constant;
+    }
+
+    // Anything strtod cannot consume whole (e.g. a string literal) stays unknown
+    char *end = nullptr;
+    double real = strtod(text.c_str(), &end);
+    if (!text.empty() && *end == '\0')
+    {
+        constant.kind = Constant::REAL;
+        constant.real = real;
+    }
+    return constant;
+}
+
+OperandId ConstantFolder::fold(IntermediateCodeGnerator &icg, Opcode op, const Constant &lhs, const Constant &rhs)
+{
+    bool bothIntegers = lhs.kind == Constant::INTEGER && rhs.kind == Constant::INTEGER;
+    bool bothNumbers = (lhs.kind == Constant::INTEGER || lhs.kind == Constant::REAL) &&
+                       (rhs.kind == Constant::INTEGER || rhs.kind == Constant::REAL);
+    double lhsReal = lhs.kind == Constant::INTEGER ? (double)lhs.integer : lhs.real;
+    double rhsReal = rhs.kind == Constant::INTEGER ? (double)rhs.integer : rhs.real;
+
+    switch (op)
+    {
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::DIV:
+        {
+            if (!bothIntegers) return NO_OPERAND;
+            long long value;
+            if (op == Opcode::ADD) value = lhs.integer + rhs.integer;
+            else if (op == Opcode::SUB) value = lhs.integer - rhs.integer;
+            else if (op == Opcode::MUL) value = lhs.integer * rhs.integer;
+            else
+            {
+                if (rhs.integer == 0) return NO_OPERAND;
+                value = lhs.integer / rhs.integer;
+            }
+            if (value < INT32_MIN || value > INT32_MAX) return NO_OPERAND;
+            return icg.constant(to_string(value));
+        }
+        case Opcode::LT:
+        case Opcode::GT:
+        case Opcode::LE:
+        case Opcode::GE:
+        case Opcode::EQ:
+        case Opcode::NE:
+        {
+            int order;
+            if (bothIntegers)
+                order = lhs.integer < rhs.integer ? -1 : lhs.integer > rhs.integer ? 1 : 0;
+            else if (bothNumbers)
+                order = lhsReal < rhsReal ? -1 : lhsReal > rhsReal ? 1 : 0;
+            else if (lhs.kind == Constant::BOOLEAN && rhs.kind == Constant::BOOLEAN && (op == Opcode::EQ || op == Opcode::NE))
+                order = lhs.boolean == rhs.boolean ? 0 : 1;
+            else
+                return NO_OPERAND;
+
+            bool result;
+            switch (op)
+            {
+                case Opcode::LT: result = order < 0; break;
+                case Opcode::GT: result = order > 0; break;
+                case Opcode::LE: result = order <= 0; break;
+                case Opcode::GE: result = order >= 0; break;
+                case Opcode::EQ: result = order == 0; break;
+                default:         result = order != 0; break;
+            }
+            return icg.constant(result ? "true" : "false");
+        }
+        case Opcode::AND:
+        case Opcode::OR:
+        {
+            if (lhs.kind == Constant::NONE || rhs.kind == Constant::NONE) return NO_OPERAND;
+            bool lhsTrue = lhs.kind == Constant::BOOLEAN ? lhs.boolean : lhsReal != 0;
+            bool rhsTrue = rhs.kind == Constant::BOOLEAN ? rhs.boolean : rhsReal != 0;
+            bool result = op == Opcode::AND ? (lhsTrue && rhsTrue) : (lhsTrue || rhsTrue);
+            return icg.constant(result ? "true" : "false");
+        }
+        default:
+            return NO_OPERAND;
+    }
+}
+
+bool ConstantFolder::run(IntermediateCodeGnerator &icg)
+{
+    size_t count = icg.size();
+    size_t operandCount = icg.operandKinds.size();
+    bool changed = false;
+
+    // Constant held by each temporary, for the whole program, and by each
+    // variable, until the end of the current basic block
+    vector<OperandId> known(operandCount, NO_OPERAND);
+    vector<OperandId> knownVariables;
+    vector<bool> erased(count, false);
+
+    auto endBlock = [&]() {
+        for (OperandId variable : knownVariables) known[variable] = NO_OPERAND;
+        knownVariables.clear();
+    };
+
+    auto substitute = [&](OperandId &id) {
+        if (id == NO_OPERAND || id >= operandCount || known[id] == NO_OPERAND) return;
+        id = known[id];
+        changed = true;
+    };
+
+    // Records what an instruction stores into its result
+    auto define = [&](OperandId result, OperandId value) {
+        if (icg.operandKinds[result] == OperandKind::TEMP)
+        {
+            known[result] = value;
+        }
+        else if (icg.operandKinds[result] == OperandKind::VARIABLE)
+        {
+            if (known[result] == NO_OPERAND && value != NO_OPERAND) knownVariables.push_back(result);
+            known[result] = value;
+        }
+    };
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Opcode op = icg.opcodes[i];
+        if (op == Opcode::LABEL)
+        {
+            endBlock();
+            continue;
+        }
+
+        substitute(icg.arg1s[i]);
+        substitute(icg.arg2s[i]);
+
+        if (op == Opcode::COPY)
+        {
+            OperandId source = icg.arg1s[i];
+            define(icg.results[i], icg.operandKinds[source] == OperandKind::CONSTANT ? source : NO_OPERAND);
+        }
+        else if (isBinary(op))
+        {
+            OperandId value = fold(icg, op, parse(icg, icg.arg1s[i]), parse(icg, icg.arg2s[i]));
+            if (value != NO_OPERAND)
+            {
+                icg.opcodes[i] = Opcode::COPY;
+                icg.arg1s[i] = value;
+                icg.arg2s[i] = NO_OPERAND;
+                changed = true;
+            }
+            define(icg.results[i], value);
+        }
+        else if (isConditionalJump(op))
+        {
+            Constant condition = parse(icg, icg.arg1s[i]);
+            if (condition.kind != Constant::NONE)
+            {
+                bool truth = condition.kind == Constant::BOOLEAN ? condition.boolean
+                           : condition.kind == Constant::INTEGER ? condition.integer != 0
+                           : condition.real != 0;
+                if (truth != (op == Opcode::IF_NOT_GOTO))
+                {
+                    icg.opcodes[i] = Opcode::GOTO;
+                    icg.arg1s[i] = NO_OPERAND;
+                }
+                else
+                {
+                    erased[i] = true;
+                }
+                changed = true;
+            }
+            endBlock();
+        }
+        else
+        {
+            // GOTO and RETURN
+            endBlock();
+        }
+    }
+
+    // Temporaries whose constant was forwarded to every use are no longer read
+    vector<uint32_t> uses(operandCount, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (erased[i]) continue;
+        if (icg.arg1s[i] != NO_OPERAND && icg.arg1s[i] < operandCount) uses[icg.arg1s[i]]++;
+        if (icg.arg2s[i] != NO_OPERAND && icg.arg2s[i] < operandCount) uses[icg.arg2s[i]]++;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        OperandId result = icg.results[i];
+        if (icg.opcodes[i] == Opcode::COPY && icg.operandKinds[result] == OperandKind::TEMP &&
+            uses[result] == 0 && icg.operandKinds[icg.arg1s[i]] == OperandKind::CONSTANT)
+        {
+            erased[i] = true;
+            changed = true;
+        }
+    }
+
+    icg.eraseInstructions(erased);
+    return changed;
+}
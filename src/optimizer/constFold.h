@@ -0,0 +1,40 @@
+#ifndef CONSTANT_FOLDING_H
+#define CONSTANT_FOLDING_H
+#include<string>
+#include<vector>
+#include "../intermediate/icg.h"
+using namespace std;
+
+// Evaluates operators whose operands are known constants and forwards
+// those constants to later uses.
+//
+// Temporaries are assigned exactly once, so a temporary that receives a
+// constant is replaced everywhere after its definition, and the definition
+// itself is dropped once nothing reads it. Variables can be reassigned, so
+// their constants are only forwarded to the end of the basic block.
+// Conditional jumps on a constant become a plain goto or disappear.
+//
+// Integer arithmetic is only folded when the result fits in 32 bits; an
+// overflow or a division by zero is left for run time. Floating point
+// operands are folded in comparisons only, so that no floating point value
+// has to be re-spelled in the generated code.
+class ConstantFolder
+{
+public:
+    // Returns true if the code changed
+    bool run(IntermediateCodeGnerator &icg);
+
+private:
+    struct Constant
+    {
+        enum Kind { NONE, INTEGER, REAL, BOOLEAN } kind = NONE;
+        long long integer = 0;
+        double real = 0;
+        bool boolean = false;
+    };
+
+    Constant parse(const IntermediateCodeGnerator &icg, OperandId id) const;
+    OperandId fold(IntermediateCodeGnerator &icg, Opcode op, const Constant &lhs, const Constant &rhs);
+};
+
+#endif
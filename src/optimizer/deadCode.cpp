@@ -0,0 +1,167 @@
+#include "./deadCode.h"
+#include<cstdint>
+using namespace std;
+
+static Opcode invertJump(Opcode op)
+{
+    return op == Opcode::IF_NOT_GOTO ? Opcode::IF_GOTO : Opcode::IF_NOT_GOTO;
+}
+
+// True if `label` is defined in the run of labels starting at `from`, i.e.
+// control falling through from just before `from` arrives at it
+static bool labelFollows(const IntermediateCodeGnerator &icg, size_t from, OperandId label)
+{
+    for (size_t i = from; i < icg.size() && icg.opcodes[i] == Opcode::LABEL; i++)
+    {
+        if (icg.results[i] == label) return true;
+    }
+    return false;
+}
+
+bool DeadCodeEliminator::run(IntermediateCodeGnerator &icg)
+{
+    bool changed = false;
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+        progress |= threadJumps(icg);
+        progress |= removeUnreachableBlocks(icg);
+        progress |= removeRedundantJumps(icg);
+        progress |= removeUnusedLabels(icg);
+        progress |= removeDeadTemps(icg);
+        changed |= progress;
+    }
+    return changed;
+}
+
+bool DeadCodeEliminator::threadJumps(IntermediateCodeGnerator &icg)
+{
+    vector<size_t> labelAt(icg.operandKinds.size(), SIZE_MAX);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        if (icg.opcodes[i] == Opcode::LABEL) labelAt[icg.results[i]] = i;
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        if (!isJump(icg.opcodes[i])) continue;
+
+        // Follow chains of `L: goto M`, giving up on cycles
+        OperandId target = icg.results[i];
+        for (size_t hops = 0; hops < icg.size(); hops++)
+        {
+            size_t at = labelAt[target];
+            if (at == SIZE_MAX) break;
+            while (at < icg.size() && icg.opcodes[at] == Opcode::LABEL) at++;
+            if (at == icg.size() || icg.opcodes[at] != Opcode::GOTO || icg.results[at] == target) break;
+            target = icg.results[at];
+        }
+        if (target != icg.results[i])
+        {
+            icg.results[i] = target;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool DeadCodeEliminator::removeUnreachableBlocks(IntermediateCodeGnerator &icg)
+{
+    ControlFlowGraph cfg;
+    cfg.build(icg);
+    vector<bool> reachable = cfg.reachable();
+
+    bool changed = false;
+    vector<bool> erased(icg.size(), false);
+    for (uint32_t b = 0; b < cfg.blocks.size(); b++)
+    {
+        if (reachable[b]) continue;
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++)
+        {
+            erased[i] = true;
+            changed = true;
+        }
+    }
+    if (changed) icg.eraseInstructions(erased);
+    return changed;
+}
+
+bool DeadCodeEliminator::removeRedundantJumps(IntermediateCodeGnerator &icg)
+{
+    bool changed = false;
+    vector<bool> erased(icg.size(), false);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        Opcode op = icg.opcodes[i];
+        if (!isJump(op)) continue;
+
+        if (labelFollows(icg, i + 1, icg.results[i]))
+        {
+            // Taken or not, control ends up at the next instruction
+            erased[i] = true;
+            changed = true;
+        }
+        else if (isConditionalJump(op) && i + 1 < icg.size() && icg.opcodes[i + 1] == Opcode::GOTO &&
+                 labelFollows(icg, i + 2, icg.results[i]))
+        {
+            // if c goto A; goto B; A:   becomes   if !c goto B; A:
+            icg.opcodes[i] = invertJump(op);
+            icg.results[i] = icg.results[i + 1];
+            erased[i + 1] = true;
+            changed = true;
+            i++;
+        }
+    }
+    if (changed) icg.eraseInstructions(erased);
+    return changed;
+}
+
+bool DeadCodeEliminator::removeUnusedLabels(IntermediateCodeGnerator &icg)
+{
+    vector<bool> used(icg.operandKinds.size(), false);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        if (isJump(icg.opcodes[i])) used[icg.results[i]] = true;
+    }
+
+    bool changed = false;
+    vector<bool> erased(icg.size(), false);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        if (icg.opcodes[i] == Opcode::LABEL && !used[icg.results[i]])
+        {
+            erased[i] = true;
+            changed = true;
+        }
+    }
+    if (changed) icg.eraseInstructions(erased);
+    return changed;
+}
+
+bool DeadCodeEliminator::removeDeadTemps(IntermediateCodeGnerator &icg)
+{
+    vector<uint32_t> uses(icg.operandKinds.size(), 0);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        if (icg.arg1s[i] != NO_OPERAND) uses[icg.arg1s[i]]++;
+        if (icg.arg2s[i] != NO_OPERAND) uses[icg.arg2s[i]]++;
+    }
+
+    bool changed = false;
+    vector<bool> erased(icg.size(), false);
+    for (size_t i = 0; i < icg.size(); i++)
+    {
+        Opcode op = icg.opcodes[i];
+        bool computes = op == Opcode::COPY || (op >= Opcode::ADD && op <= Opcode::OR);
+        OperandId result = icg.results[i];
+        if (computes && icg.operandKinds[result] == OperandKind::TEMP && uses[result] == 0)
+        {
+            erased[i] = true;
+            changed = true;
+        }
+    }
+    if (changed) icg.eraseInstructions(erased);
+    return changed;
+}
@@ -0,0 +1,31 @@
+#ifndef DEAD_CODE_ELIMINATION_H
+#define DEAD_CODE_ELIMINATION_H
+#include<vector>
+#include "../intermediate/icg.h"
+#include "./cfg.h"
+using namespace std;
+
+// Cleans up the control flow left behind by lowering and folding:
+//   - jumps to a label whose block only jumps on are threaded to the final
+//     target,
+//   - blocks the entry cannot reach are removed,
+//   - jumps to the next instruction are removed, and a conditional jump
+//     over an unconditional one is inverted into a single jump,
+//   - labels nothing jumps to are removed,
+//   - temporaries that are computed but never read are removed.
+// The steps feed each other, so they are repeated until nothing changes.
+class DeadCodeEliminator
+{
+public:
+    // Returns true if the code changed
+    bool run(IntermediateCodeGnerator &icg);
+
+private:
+    bool threadJumps(IntermediateCodeGnerator &icg);
+    bool removeUnreachableBlocks(IntermediateCodeGnerator &icg);
+    bool removeRedundantJumps(IntermediateCodeGnerator &icg);
+    bool removeUnusedLabels(IntermediateCodeGnerator &icg);
+    bool removeDeadTemps(IntermediateCodeGnerator &icg);
+};
+
+#endif
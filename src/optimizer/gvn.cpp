@@ -0,0 +1,182 @@
+#include "./gvn.h"
+using namespace std;
+
+static bool isCommutative(Opcode op)
+{
+    return op == Opcode::ADD || op == Opcode::MUL || op == Opcode::EQ ||
+           op == Opcode::NE || op == Opcode::AND || op == Opcode::OR;
+}
+
+GlobalValueNumbering::ValueNumber GlobalValueNumbering::freshValue()
+{
+    leaders.push_back(NO_OPERAND);
+    return nextValue++;
+}
+
+GlobalValueNumbering::ValueNumber GlobalValueNumbering::valueOf(OperandId id)
+{
+    if (id == NO_OPERAND || icg->operandKinds[id] == OperandKind::LABEL) return NO_VALUE;
+
+    if (isSsaOperand(*icg, id) && !reaching[id].empty()) return reaching[id].back();
+
+    // A temporary read where none of its definitions reaches for certain
+    // could hold anything
+    if (icg->operandKinds[id] == OperandKind::TEMP) return freshValue();
+
+    // Constants, and variables still holding their value from program start
+    if (fixedValues[id] == NO_VALUE)
+    {
+        fixedValues[id] = freshValue();
+        if (icg->operandKinds[id] == OperandKind::CONSTANT) leaders[fixedValues[id]] = id;
+    }
+    return fixedValues[id];
+}
+
+void GlobalValueNumbering::define(OperandId id, ValueNumber value)
+{
+    if (!isSsaOperand(*icg, id)) return;
+    reaching[id].push_back(value);
+    pushedDefinitions.push_back(id);
+}
+
+void GlobalValueNumbering::lead(ValueNumber value, OperandId id)
+{
+    if (icg->operandKinds[id] != OperandKind::TEMP || ssa.definitionCount[id] != 1) return;
+    if (leaders[value] != NO_OPERAND) return;
+    leaders[value] = id;
+    ledValues.push_back(value);
+}
+
+void GlobalValueNumbering::rewriteUse(OperandId &id)
+{
+    if (!isSsaOperand(*icg, id)) return;
+    OperandId leader = leaders[valueOf(id)];
+    if (leader != NO_OPERAND && leader != id)
+    {
+        id = leader;
+        changed = true;
+    }
+}
+
+void GlobalValueNumbering::numberBlock(uint32_t block)
+{
+    for (OperandId id : ssa.phis[block])
+    {
+        define(id, freshValue());
+    }
+
+    for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++)
+    {
+        Opcode op = icg->opcodes[i];
+        if (op == Opcode::LABEL || op == Opcode::GOTO) continue;
+
+        rewriteUse(icg->arg1s[i]);
+        rewriteUse(icg->arg2s[i]);
+        if (!definesResult(op)) continue;
+
+        OperandId result = icg->results[i];
+        if (op == Opcode::COPY)
+        {
+            ValueNumber value = valueOf(icg->arg1s[i]);
+            define(result, value);
+            lead(value, result);
+            continue;
+        }
+
+        ValueNumber lhs = valueOf(icg->arg1s[i]);
+        ValueNumber rhs = valueOf(icg->arg2s[i]);
+        if (isCommutative(op) && lhs > rhs) swap(lhs, rhs);
+
+        Expression expression{op, lhs, rhs};
+        auto found = expressions.find(expression);
+        if (found != expressions.end())
+        {
+            // Already computed on every path to here
+            ValueNumber value = found->second;
+            OperandId leader = leaders[value];
+            if (leader != NO_OPERAND && leader != result)
+            {
+                icg->opcodes[i] = Opcode::COPY;
+                icg->arg1s[i] = leader;
+                icg->arg2s[i] = NO_OPERAND;
+                changed = true;
+            }
+            define(result, value);
+            lead(value, result);
+            continue;
+        }
+
+        ValueNumber value = freshValue();
+        expressions.emplace(expression, value);
+        addedExpressions.push_back(expression);
+        define(result, value);
+        lead(value, result);
+    }
+}
+
+bool GlobalValueNumbering::run(IntermediateCodeGnerator &code)
+{
+    icg = &code;
+    changed = false;
+
+    cfg.build(code);
+    cfg.computeDominators();
+    ssa.build(code, cfg);
+
+    size_t operandCount = code.operandKinds.size();
+    nextValue = 0;
+    fixedValues.assign(operandCount, NO_VALUE);
+    reaching.assign(operandCount, {});
+    leaders.clear();
+    expressions.clear();
+    pushedDefinitions.clear();
+    ledValues.clear();
+    addedExpressions.clear();
+
+    // Preorder walk of the dominator tree. Each entry on the stack is a
+    // block and, once its children have been pushed, the undo log sizes to
+    // restore when leaving it.
+    struct Visit
+    {
+        uint32_t block;
+        bool leaving;
+        size_t definitions, leaders, expressions;
+    };
+    vector<Visit> stack;
+    if (!cfg.blocks.empty()) stack.push_back({0, false, 0, 0, 0});
+    while (!stack.empty())
+    {
+        Visit visit = stack.back();
+        stack.pop_back();
+
+        if (visit.leaving)
+        {
+            while (pushedDefinitions.size() > visit.definitions)
+            {
+                reaching[pushedDefinitions.back()].pop_back();
+                pushedDefinitions.pop_back();
+            }
+            while (ledValues.size() > visit.leaders)
+            {
+                leaders[ledValues.back()] = NO_OPERAND;
+                ledValues.pop_back();
+            }
+            while (addedExpressions.size() > visit.expressions)
+            {
+                expressions.erase(addedExpressions.back());
+                addedExpressions.pop_back();
+            }
+            continue;
+        }
+
+        stack.push_back({visit.block, true, pushedDefinitions.size(), ledValues.size(), addedExpressions.size()});
+        numberBlock(visit.block);
+        const vector<uint32_t> &children = cfg.dominatorChildren[visit.block];
+        for (auto child = children.rbegin(); child != children.rend(); ++child)
+        {
+            stack.push_back({*child, false, 0, 0, 0});
+        }
+    }
+
+    return changed;
+}
@@ -0,0 +1,78 @@
+#ifndef GLOBAL_VALUE_NUMBERING_H
+#define GLOBAL_VALUE_NUMBERING_H
+#include<cstdint>
+#include<unordered_map>
+#include<cstddef>
+#include<vector>
+#include "../intermediate/icg.h"
+#include "./cfg.h"
+#include "./ssa.h"
+using namespace std;
+
+// Dominator-based global value numbering over the SSA form.
+//
+// Every definition gets a value number: copies share the number of their
+// source, a phi gets a fresh one, and an operator gets the number already
+// given to the same operator on the same numbers in a dominating block.
+// When that happens the instruction becomes a copy of the temporary that
+// first computed the value (common subexpression elimination). Uses are
+// rewritten to the constant or temporary that leads their value number,
+// which propagates constants and copies across blocks.
+//
+// Only constants and temporaries assigned exactly once lead a value: a
+// variable may be reassigned later, while a single-assignment temporary
+// still holds its value anywhere its definition dominates.
+class GlobalValueNumbering
+{
+public:
+    // Returns true if the code changed
+    bool run(IntermediateCodeGnerator &icg);
+
+private:
+    typedef uint32_t ValueNumber;
+    static constexpr ValueNumber NO_VALUE = 0xFFFFFFFFu;
+
+    struct Expression
+    {
+        Opcode op;
+        ValueNumber lhs;
+        ValueNumber rhs;
+        bool operator==(const Expression &other) const
+        {
+            return op == other.op && lhs == other.lhs && rhs == other.rhs;
+        }
+    };
+
+    struct ExpressionHash
+    {
+        size_t operator()(const Expression &e) const
+        {
+            return (size_t)e.op * 0x9E3779B97F4A7C15ull ^ (size_t)e.lhs * 0xC2B2AE3D27D4EB4Full ^ e.rhs;
+        }
+    };
+
+    IntermediateCodeGnerator *icg;
+    ControlFlowGraph cfg;
+    SsaForm ssa;
+    bool changed;
+
+    ValueNumber nextValue;
+    vector<ValueNumber> fixedValues;            // constants and entry values, by OperandId
+    vector<vector<ValueNumber>> reaching;       // definition stack by OperandId
+    vector<OperandId> leaders;                  // by ValueNumber
+    unordered_map<Expression, ValueNumber, ExpressionHash> expressions;
+
+    // Undo logs for leaving a dominator subtree
+    vector<OperandId> pushedDefinitions;
+    vector<ValueNumber> ledValues;
+    vector<Expression> addedExpressions;
+
+    ValueNumber freshValue();
+    ValueNumber valueOf(OperandId id);
+    void define(OperandId id, ValueNumber value);
+    void lead(ValueNumber value, OperandId id);
+    void rewriteUse(OperandId &id);
+    void numberBlock(uint32_t block);
+};
+
+#endif
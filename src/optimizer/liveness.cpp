@@ -0,0 +1,51 @@
+#include "./liveness.h"
+#include "./ssa.h"
+using namespace std;
+
+void Liveness::compute(const IntermediateCodeGnerator &icg, const ControlFlowGraph &cfg)
+{
+    size_t words = (icg.operandKinds.size() + 63) / 64;
+    size_t blockCount = cfg.blocks.size();
+
+    // Operands each block reads before assigning them, and operands it assigns
+    vector<vector<uint64_t>> uses(blockCount, vector<uint64_t>(words, 0));
+    vector<vector<uint64_t>> defs(blockCount, vector<uint64_t>(words, 0));
+    for (uint32_t b = 0; b < blockCount; b++)
+    {
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++)
+        {
+            for (OperandId arg : {icg.arg1s[i], icg.arg2s[i]})
+            {
+                if (isSsaOperand(icg, arg) && !contains(defs[b], arg)) insert(uses[b], arg);
+            }
+            if (definesResult(icg.opcodes[i])) insert(defs[b], icg.results[i]);
+        }
+    }
+
+    liveIn.assign(blockCount, vector<uint64_t>(words, 0));
+    liveOut.assign(blockCount, vector<uint64_t>(words, 0));
+
+    // Visiting blocks in reverse order reaches the fixed point in few rounds
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (uint32_t b = static_cast<uint32_t>(blockCount); b-- > 0;)
+        {
+            vector<uint64_t> &out = liveOut[b];
+            for (uint32_t successor : cfg.blocks[b].successors)
+            {
+                for (size_t w = 0; w < words; w++) out[w] |= liveIn[successor][w];
+            }
+            for (size_t w = 0; w < words; w++)
+            {
+                uint64_t in = uses[b][w] | (out[w] & ~defs[b][w]);
+                if (in != liveIn[b][w])
+                {
+                    liveIn[b][w] = in;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
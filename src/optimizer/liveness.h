@@ -0,0 +1,32 @@
+#ifndef LIVENESS_H
+#define LIVENESS_H
+#include<cstdint>
+#include<vector>
+#include "../intermediate/icg.h"
+#include "./cfg.h"
+using namespace std;
+
+// Backward dataflow over the CFG: an operand is live at a point if some
+// path from there reads it before assigning it. Only variables and
+// temporaries are tracked. Sets are bit vectors indexed by OperandId.
+class Liveness
+{
+public:
+    vector<vector<uint64_t>> liveIn;    // by block
+    vector<vector<uint64_t>> liveOut;
+
+    void compute(const IntermediateCodeGnerator &icg, const ControlFlowGraph &cfg);
+
+    static bool contains(const vector<uint64_t> &set, OperandId id)
+    {
+        return (set[id >> 6] >> (id & 63)) & 1;
+    }
+
+private:
+    static void insert(vector<uint64_t> &set, OperandId id)
+    {
+        set[id >> 6] |= uint64_t(1) << (id & 63);
+    }
+};
+
+#endif
@@ -0,0 +1,467 @@
+#include "./loops.h"
+#include "./ssa.h"
+#include<algorithm>
+#include<unordered_map>
+using namespace std;
+
+static constexpr size_t NO_INDEX = SIZE_MAX;
+
+vector<Loop> findLoops(const ControlFlowGraph &cfg)
+{
+    size_t blockCount = cfg.blocks.size();
+    vector<bool> reachable = cfg.reachable();
+    vector<Loop> loops;
+    vector<uint32_t> loopOfHeader(blockCount, ControlFlowGraph::NO_BLOCK);
+
+    for (uint32_t block = 0; block < blockCount; block++)
+    {
+        if (!reachable[block]) continue;
+        for (uint32_t header : cfg.blocks[block].successors)
+        {
+            if (!reachable[header] || !cfg.dominates(header, block)) continue;
+
+            if (loopOfHeader[header] == ControlFlowGraph::NO_BLOCK)
+            {
+                loopOfHeader[header] = static_cast<uint32_t>(loops.size());
+                loops.push_back({header, {}, {}, vector<bool>(blockCount, false)});
+                loops.back().contains[header] = true;
+            }
+            Loop &loop = loops[loopOfHeader[header]];
+            loop.latches.push_back(block);
+
+            // Everything that reaches the latch without passing the header
+            vector<uint32_t> worklist;
+            if (!loop.contains[block])
+            {
+                loop.contains[block] = true;
+                worklist.push_back(block);
+            }
+            while (!worklist.empty())
+            {
+                uint32_t current = worklist.back();
+                worklist.pop_back();
+                for (uint32_t predecessor : cfg.blocks[current].predecessors)
+                {
+                    if (reachable[predecessor] && !loop.contains[predecessor])
+                    {
+                        loop.contains[predecessor] = true;
+                        worklist.push_back(predecessor);
+                    }
+                }
+            }
+        }
+    }
+
+    for (Loop &loop : loops)
+    {
+        for (uint32_t block = 0; block < blockCount; block++)
+        {
+            if (loop.contains[block]) loop.blocks.push_back(block);
+        }
+    }
+    stable_sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    return loops;
+}
+
+size_t LoopOptimizer::preheaderInsertion(const Loop &loop) const
+{
+    uint32_t header = loop.header;
+    if (header == 0 || loop.contains[header - 1]) return NO_INDEX;
+
+    bool enteredFromAbove = false;
+    for (uint32_t predecessor : cfg.blocks[header].predecessors)
+    {
+        if (loop.contains[predecessor]) continue;
+        if (predecessor != header - 1) return NO_INDEX;
+        enteredFromAbove = true;
+    }
+
+    size_t begin = cfg.blocks[header].begin;
+    if (!enteredFromAbove || begin == 0 || icg->opcodes[begin] != Opcode::LABEL) return NO_INDEX;
+
+    // Before a goto into the header, or before its label when the block
+    // above falls through
+    size_t last = begin - 1;
+    Opcode op = icg->opcodes[last];
+    if (op == Opcode::GOTO) return icg->results[last] == icg->results[begin] ? last : NO_INDEX;
+    if (isConditionalJump(op) && icg->results[last] == icg->results[begin]) return NO_INDEX;
+    return begin;
+}
+
+bool LoopOptimizer::unroll(const Loop &loop)
+{
+    IntermediateCodeGnerator &code = *icg;
+
+    // A header block and a single body block right below it
+    if (loop.blocks.size() != 2 || loop.latches.size() != 1) return false;
+    uint32_t header = loop.header;
+    uint32_t body = loop.latches[0];
+    if (body != header + 1) return false;
+    size_t preheader = preheaderInsertion(loop);
+    if (preheader == NO_INDEX) return false;
+
+    const BasicBlock &headerBlock = cfg.blocks[header];
+    const BasicBlock &bodyBlock = cfg.blocks[body];
+    size_t exitJump = headerBlock.end - 1;
+    size_t backJump = bodyBlock.end - 1;
+    if (!isConditionalJump(code.opcodes[exitJump]) || code.opcodes[backJump] != Opcode::GOTO) return false;
+    OperandId exitLabel = code.results[exitJump];
+    uint32_t exitBlock = cfg.blockOfLabel(exitLabel);
+    if (exitBlock == ControlFlowGraph::NO_BLOCK || loop.contains[exitBlock]) return false;
+
+    // The header only computes temporaries for its test, from constants
+    // and a single variable, the induction variable
+    OperandId induction = NO_OPERAND;
+    for (size_t i = headerBlock.begin + 1; i < exitJump; i++)
+    {
+        if (!definesResult(code.opcodes[i]) || code.operandKinds[code.results[i]] != OperandKind::TEMP) return false;
+        for (OperandId arg : {code.arg1s[i], code.arg2s[i]})
+        {
+            if (arg == NO_OPERAND || code.operandKinds[arg] != OperandKind::VARIABLE) continue;
+            if (induction != NO_OPERAND && induction != arg) return false;
+            induction = arg;
+        }
+    }
+    if (induction == NO_OPERAND) return false;
+
+    // Temporaries may not be read outside the part of the loop that
+    // assigns them, since the copies rename them
+    auto usedOnlyWithin = [&](size_t begin, size_t end) {
+        unordered_map<OperandId, uint32_t> inside;
+        for (size_t i = begin; i < end; i++)
+        {
+            for (OperandId arg : {code.arg1s[i], code.arg2s[i]})
+            {
+                if (arg != NO_OPERAND && code.operandKinds[arg] == OperandKind::TEMP) inside[arg]++;
+            }
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+            OperandId result = code.results[i];
+            if (!definesResult(code.opcodes[i]) || code.operandKinds[result] != OperandKind::TEMP) continue;
+            if (definitions[result] != 1 || inside[result] != uses[result]) return false;
+        }
+        return true;
+    };
+    if (!usedOnlyWithin(headerBlock.begin, exitJump + 1)) return false;
+    if (!usedOnlyWithin(bodyBlock.begin, backJump)) return false;
+
+    // The body assigns the induction variable once, by a constant step
+    int64_t step = 0;
+    uint32_t inductionDefinitions = 0;
+    for (size_t i = bodyBlock.begin; i < backJump; i++)
+    {
+        Opcode op = code.opcodes[i];
+        if (op == Opcode::LABEL || isJump(op) || op == Opcode::RETURN) return false;
+        if (!definesResult(op) || code.results[i] != induction) continue;
+
+        inductionDefinitions++;
+        size_t update = i;
+        if (op == Opcode::COPY && code.operandKinds[code.arg1s[i]] == OperandKind::TEMP)
+        {
+            // i = t, with t = i + c computed just before
+            update = NO_INDEX;
+            for (size_t j = bodyBlock.begin; j < i; j++)
+            {
+                if (definesResult(code.opcodes[j]) && code.results[j] == code.arg1s[i]) update = j;
+            }
+            if (update == NO_INDEX) return false;
+        }
+
+        int32_t constant = 0;
+        Opcode updateOp = code.opcodes[update];
+        if (updateOp == Opcode::ADD && code.arg1s[update] == induction && code.integerConstant(code.arg2s[update], constant)) step = constant;
+        else if (updateOp == Opcode::ADD && code.arg2s[update] == induction && code.integerConstant(code.arg1s[update], constant)) step = constant;
+        else if (updateOp == Opcode::SUB && code.arg1s[update] == induction && code.integerConstant(code.arg2s[update], constant)) step = -int64_t(constant);
+        else return false;
+    }
+    if (inductionDefinitions != 1) return false;
+
+    // The start value is a constant assigned just before the loop
+    int32_t start = 0;
+    bool started = false;
+    for (size_t i = preheader; i-- > cfg.blocks[header - 1].begin;)
+    {
+        if (!definesResult(code.opcodes[i]) || code.results[i] != induction) continue;
+        started = code.opcodes[i] == Opcode::COPY && code.integerConstant(code.arg1s[i], start);
+        break;
+    }
+    if (!started) return false;
+
+    // Run the header test to count the trips
+    auto wrap = [](int64_t value) { return static_cast<int64_t>(static_cast<int32_t>(static_cast<uint32_t>(value))); };
+    int64_t value = start;
+    uint32_t trips = 0;
+    for (;;)
+    {
+        unordered_map<OperandId, int64_t> temps;
+        auto evaluate = [&](OperandId id, int64_t &out) {
+            int32_t constant = 0;
+            if (id == induction) out = value;
+            else if (code.integerConstant(id, constant)) out = constant;
+            else if (temps.count(id)) out = temps[id];
+            else return false;
+            return true;
+        };
+
+        for (size_t i = headerBlock.begin + 1; i < exitJump; i++)
+        {
+            Opcode op = code.opcodes[i];
+            int64_t lhs = 0, rhs = 0, result = 0;
+            if (!evaluate(code.arg1s[i], lhs)) return false;
+            if (op != Opcode::COPY && !evaluate(code.arg2s[i], rhs)) return false;
+            switch (op)
+            {
+                case Opcode::COPY: result = lhs; break;
+                case Opcode::ADD:  result = wrap(lhs + rhs); break;
+                case Opcode::SUB:  result = wrap(lhs - rhs); break;
+                case Opcode::MUL:  result = wrap(lhs * rhs); break;
+                case Opcode::LT:   result = lhs < rhs; break;
+                case Opcode::GT:   result = lhs > rhs; break;
+                case Opcode::LE:   result = lhs <= rhs; break;
+                case Opcode::GE:   result = lhs >= rhs; break;
+                case Opcode::EQ:   result = lhs == rhs; break;
+                case Opcode::NE:   result = lhs != rhs; break;
+                case Opcode::AND:  result = lhs != 0 && rhs != 0; break;
+                case Opcode::OR:   result = lhs != 0 || rhs != 0; break;
+                default:           return false;
+            }
+            temps[code.results[i]] = result;
+        }
+
+        int64_t condition = 0;
+        if (!evaluate(code.arg1s[exitJump], condition)) return false;
+        bool exits = (condition != 0) != (code.opcodes[exitJump] == Opcode::IF_NOT_GOTO);
+        if (exits) break;
+
+        if (++trips > MAX_UNROLLED_TRIPS) return false;
+        value = wrap(value + step);
+    }
+
+    size_t bodySize = backJump - bodyBlock.begin;
+    if (trips * bodySize > MAX_UNROLLED_SIZE) return false;
+
+    // Replace the loop by its label, one renamed copy of the body per trip
+    // and a jump to the exit
+    struct Quad
+    {
+        Opcode op;
+        OperandId result, arg1, arg2;
+    };
+    vector<Quad> unrolled;
+    unrolled.push_back({Opcode::LABEL, code.results[headerBlock.begin], NO_OPERAND, NO_OPERAND});
+    for (uint32_t trip = 0; trip < trips; trip++)
+    {
+        unordered_map<OperandId, OperandId> renamed;
+        auto rename = [&](OperandId id) {
+            auto found = renamed.find(id);
+            return found == renamed.end() ? id : found->second;
+        };
+        for (size_t i = bodyBlock.begin; i < backJump; i++)
+        {
+            OperandId arg1 = rename(code.arg1s[i]);
+            OperandId arg2 = rename(code.arg2s[i]);
+            OperandId result = code.results[i];
+            if (code.operandKinds[result] == OperandKind::TEMP)
+            {
+                renamed[result] = code.newTemp();
+                result = renamed[result];
+            }
+            unrolled.push_back({code.opcodes[i], result, arg1, arg2});
+        }
+    }
+    unrolled.push_back({Opcode::GOTO, exitLabel, NO_OPERAND, NO_OPERAND});
+
+    vector<bool> erased(code.size(), false);
+    for (size_t i = headerBlock.begin; i < bodyBlock.end; i++) erased[i] = true;
+    code.eraseInstructions(erased);
+    for (size_t k = 0; k < unrolled.size(); k++)
+    {
+        const Quad &quad = unrolled[k];
+        code.insertInstruction(headerBlock.begin + k, quad.op, quad.result, quad.arg1, quad.arg2);
+    }
+    return true;
+}
+
+bool LoopOptimizer::hoistInvariants(const Loop &loop)
+{
+    IntermediateCodeGnerator &code = *icg;
+    size_t preheader = preheaderInsertion(loop);
+    if (preheader == NO_INDEX) return false;
+
+    vector<uint32_t> loopDefinitions(code.operandKinds.size(), 0);
+    for (uint32_t block : loop.blocks)
+    {
+        for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++)
+        {
+            if (definesResult(code.opcodes[i])) loopDefinitions[code.results[i]]++;
+        }
+    }
+
+    auto invariant = [&](OperandId id) {
+        return id == NO_OPERAND || code.operandKinds[id] == OperandKind::CONSTANT || loopDefinitions[id] == 0;
+    };
+
+    // Hoisting one temporary can make those computed from it invariant too,
+    // and they are found in that order
+    vector<bool> hoisted(code.size(), false);
+    vector<size_t> order;
+    bool found = true;
+    while (found)
+    {
+        found = false;
+        for (uint32_t block : loop.blocks)
+        {
+            for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++)
+            {
+                Opcode op = code.opcodes[i];
+                OperandId result = code.results[i];
+                if (hoisted[i] || !definesResult(op)) continue;
+                if (code.operandKinds[result] != OperandKind::TEMP || definitions[result] != 1) continue;
+                if (!invariant(code.arg1s[i]) || !invariant(code.arg2s[i])) continue;
+
+                // Division may trap, so it only runs ahead when it cannot:
+                // by zero, and INT_MIN / -1 overflows
+                int32_t divisor = 0;
+                if (op == Opcode::DIV &&
+                    (!code.integerConstant(code.arg2s[i], divisor) || divisor == 0 || divisor == -1))
+                    continue;
+
+                hoisted[i] = true;
+                order.push_back(i);
+                loopDefinitions[result]--;
+                found = true;
+            }
+        }
+    }
+    if (order.empty()) return false;
+
+    vector<Opcode> ops;
+    vector<OperandId> results, arg1s, arg2s;
+    size_t before = preheader;
+    for (size_t i : order)
+    {
+        ops.push_back(code.opcodes[i]);
+        results.push_back(code.results[i]);
+        arg1s.push_back(code.arg1s[i]);
+        arg2s.push_back(code.arg2s[i]);
+        if (i < preheader) before--;
+    }
+    code.eraseInstructions(hoisted);
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        code.insertInstruction(before + k, ops[k], results[k], arg1s[k], arg2s[k]);
+    }
+    return true;
+}
+
+bool LoopOptimizer::reduceStrength(const Loop &loop)
+{
+    IntermediateCodeGnerator &code = *icg;
+    size_t preheader = preheaderInsertion(loop);
+    if (preheader == NO_INDEX) return false;
+
+    // Where each operand is assigned inside the loop, if exactly once
+    size_t operandCount = code.operandKinds.size();
+    vector<uint32_t> loopDefinitions(operandCount, 0);
+    vector<size_t> definedAt(operandCount, NO_INDEX);
+    for (uint32_t block : loop.blocks)
+    {
+        for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++)
+        {
+            if (!definesResult(code.opcodes[i])) continue;
+            loopDefinitions[code.results[i]]++;
+            definedAt[code.results[i]] = i;
+        }
+    }
+
+    // Constant step of a variable assigned once in the loop as i = i + c,
+    // or as i = t with t = i + c
+    auto stepOf = [&](OperandId variable, int64_t &step) {
+        if (code.operandKinds[variable] != OperandKind::VARIABLE || loopDefinitions[variable] != 1) return false;
+        size_t update = definedAt[variable];
+        if (code.opcodes[update] == Opcode::COPY)
+        {
+            OperandId temp = code.arg1s[update];
+            if (code.operandKinds[temp] != OperandKind::TEMP || loopDefinitions[temp] != 1) return false;
+            update = definedAt[temp];
+        }
+        int32_t constant = 0;
+        Opcode op = code.opcodes[update];
+        if (op == Opcode::ADD && code.arg1s[update] == variable && code.integerConstant(code.arg2s[update], constant)) step = constant;
+        else if (op == Opcode::ADD && code.arg2s[update] == variable && code.integerConstant(code.arg1s[update], constant)) step = constant;
+        else if (op == Opcode::SUB && code.arg1s[update] == variable && code.integerConstant(code.arg2s[update], constant)) step = -int64_t(constant);
+        else return false;
+        return true;
+    };
+
+    for (uint32_t block : loop.blocks)
+    {
+        for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++)
+        {
+            if (code.opcodes[i] != Opcode::MUL || code.operandKinds[code.results[i]] != OperandKind::TEMP) continue;
+
+            OperandId variable = code.arg1s[i];
+            int32_t factor = 0;
+            if (!code.integerConstant(code.arg2s[i], factor))
+            {
+                variable = code.arg2s[i];
+                if (!code.integerConstant(code.arg1s[i], factor)) continue;
+            }
+            int64_t step = 0;
+            if (!stepOf(variable, step)) continue;
+            int64_t increment = step * factor;
+            if (increment < INT32_MIN || increment > INT32_MAX) continue;
+
+            // j = i * k before the loop, j = j + step * k after every
+            // assignment to i, and the product becomes a copy of j
+            OperandId reduced = code.newVariable("_iv");
+            size_t after = definedAt[variable] + 1;
+            code.opcodes[i] = Opcode::COPY;
+            code.arg1s[i] = reduced;
+            code.arg2s[i] = NO_OPERAND;
+
+            OperandId incrementConstant = code.constant(to_string(increment));
+            OperandId factorConstant = code.constant(to_string(factor));
+            if (after > preheader)
+            {
+                code.insertInstruction(after, Opcode::ADD, reduced, reduced, incrementConstant);
+                code.insertInstruction(preheader, Opcode::MUL, reduced, variable, factorConstant);
+            }
+            else
+            {
+                code.insertInstruction(preheader, Opcode::MUL, reduced, variable, factorConstant);
+                code.insertInstruction(after, Opcode::ADD, reduced, reduced, incrementConstant);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LoopOptimizer::run(IntermediateCodeGnerator &code)
+{
+    icg = &code;
+    cfg.build(code);
+    cfg.computeDominators();
+
+    size_t operandCount = code.operandKinds.size();
+    definitions.assign(operandCount, 0);
+    uses.assign(operandCount, 0);
+    for (size_t i = 0; i < code.size(); i++)
+    {
+        if (definesResult(code.opcodes[i])) definitions[code.results[i]]++;
+        if (code.arg1s[i] != NO_OPERAND) uses[code.arg1s[i]]++;
+        if (code.arg2s[i] != NO_OPERAND) uses[code.arg2s[i]]++;
+    }
+
+    // Every transformation moves instructions, so the CFG is rebuilt after
+    // each one by the next call
+    for (const Loop &loop : findLoops(cfg))
+    {
+        if (unroll(loop) || hoistInvariants(loop) || reduceStrength(loop)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+#ifndef LOOPS_H
+#define LOOPS_H
+#include<cstdint>
+#include<vector>
+#include "../intermediate/icg.h"
+#include "./cfg.h"
+using namespace std;
+
+// A natural loop: the blocks that reach a back edge into `header` without
+// passing through it. Back edges sharing a header form one loop.
+struct Loop
+{
+    uint32_t header;
+    vector<uint32_t> blocks;    // sorted, header included
+    vector<uint32_t> latches;   // sources of the back edges
+    vector<bool> contains;      // by block
+};
+
+// Needs cfg.computeDominators(). Inner loops come before outer ones.
+vector<Loop> findLoops(const ControlFlowGraph &cfg);
+
+// Loop transformations, applied to one loop per call:
+//
+//  - Full unrolling of a loop whose trip count is a small constant: a
+//    header that only tests an induction variable, a straight-line body,
+//    and a constant start value just before the loop. The body is copied
+//    once per iteration, with fresh temporaries in each copy, and constant
+//    folding then evaluates the copies.
+//  - Loop-invariant code motion: temporaries computed from operands the
+//    loop never assigns move to the preheader.
+//  - Strength reduction: `t = i * k`, where i only changes by a constant
+//    step, becomes a copy of a new variable that starts at i * k in the
+//    preheader and is stepped by step * k right after i is.
+//
+// Code can only be placed before a loop when its header has a single
+// predecessor outside the loop, directly in front of it.
+class LoopOptimizer
+{
+public:
+    static constexpr uint32_t MAX_UNROLLED_TRIPS = 16;
+    static constexpr size_t MAX_UNROLLED_SIZE = 64;
+
+    // Returns true if the code changed
+    bool run(IntermediateCodeGnerator &icg);
+
+private:
+    IntermediateCodeGnerator *icg = nullptr;
+    ControlFlowGraph cfg;
+    vector<uint32_t> definitions;   // by operand, whole program
+    vector<uint32_t> uses;
+
+    size_t preheaderInsertion(const Loop &loop) const;
+    bool unroll(const Loop &loop);
+    bool hoistInvariants(const Loop &loop);
+    bool reduceStrength(const Loop &loop);
+};
+
+#endif
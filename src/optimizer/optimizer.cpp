@@ -0,0 +1,30 @@
+#include "./optimizer.h"
+#include "./constFold.h"
+#include "./deadCode.h"
+#include "./gvn.h"
+#include "./loops.h"
+using namespace std;
+
+Optimizer::Optimizer(int level) : level(level) {}
+
+void Optimizer::run(IntermediateCodeGnerator &icg)
+{
+    if (level < 1) return;
+
+    ConstantFolder folder;
+    DeadCodeEliminator deadCode;
+    GlobalValueNumbering valueNumbering;
+    LoopOptimizer loops;
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = folder.run(icg);
+        changed = deadCode.run(icg) || changed;
+        if (level >= 2)
+        {
+            changed = valueNumbering.run(icg) || changed;
+            changed = loops.run(icg) || changed;
+        }
+    }
+}
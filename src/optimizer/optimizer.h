@@ -0,0 +1,26 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+#include "../intermediate/icg.h"
+using namespace std;
+
+// The optimization pipeline selected by -O0, -O1 or -O2:
+//   -O0  no passes, the TAC goes to the backend as lowered
+//   -O1  constant folding and propagation, dead code and jump cleanup
+//   -O2  -O1 plus SSA based global value numbering, and loop unrolling,
+//        invariant code motion and strength reduction
+// The passes feed each other, so they are repeated until none of them
+// changes the code.
+class Optimizer
+{
+public:
+    static constexpr int DEFAULT_LEVEL = 1;
+
+    explicit Optimizer(int level = DEFAULT_LEVEL);
+
+    void run(IntermediateCodeGnerator &icg);
+
+private:
+    int level;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "./ssa.h"
+using namespace std;
+
+bool isSsaOperand(const IntermediateCodeGnerator &icg, OperandId id)
+{
+    if (id == NO_OPERAND) return false;
+    OperandKind kind = icg.operandKinds[id];
+    return kind == OperandKind::VARIABLE || kind == OperandKind::TEMP;
+}
+
+bool definesResult(Opcode op)
+{
+    return op >= Opcode::COPY && op <= Opcode::OR;
+}
+
+void SsaForm::build(const IntermediateCodeGnerator &icg, const ControlFlowGraph &cfg)
+{
+    size_t operandCount = icg.operandKinds.size();
+    size_t blockCount = cfg.blocks.size();
+
+    // Blocks that assign each operand
+    definitionCount.assign(operandCount, 0);
+    vector<vector<uint32_t>> definingBlocks(operandCount);
+    for (uint32_t b = 0; b < blockCount; b++)
+    {
+        if (cfg.idom[b] == ControlFlowGraph::NO_BLOCK) continue;
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++)
+        {
+            if (!definesResult(icg.opcodes[i])) continue;
+            OperandId result = icg.results[i];
+            definitionCount[result]++;
+            vector<uint32_t> &blocks = definingBlocks[result];
+            if (blocks.empty() || blocks.back() != b) blocks.push_back(b);
+        }
+    }
+
+    vector<vector<uint32_t>> frontiers = cfg.dominanceFrontiers();
+    phis.assign(blockCount, {});
+
+    // Worklist over the iterated dominance frontier; `placed` and `queued`
+    // hold the operand last handled for each block so they need no reset
+    vector<OperandId> placed(blockCount, NO_OPERAND);
+    vector<OperandId> queued(blockCount, NO_OPERAND);
+    vector<uint32_t> work;
+    for (OperandId id = 0; id < operandCount; id++)
+    {
+        // A temporary assigned once in one block needs no phi
+        if (definingBlocks[id].empty()) continue;
+        if (icg.operandKinds[id] == OperandKind::TEMP && definitionCount[id] == 1) continue;
+
+        for (uint32_t b : definingBlocks[id])
+        {
+            queued[b] = id;
+            work.push_back(b);
+        }
+        while (!work.empty())
+        {
+            uint32_t b = work.back();
+            work.pop_back();
+            for (uint32_t frontier : frontiers[b])
+            {
+                if (placed[frontier] == id) continue;
+                placed[frontier] = id;
+                phis[frontier].push_back(id);
+                if (queued[frontier] != id)
+                {
+                    queued[frontier] = id;
+                    work.push_back(frontier);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef SSA_FORM_H
+#define SSA_FORM_H
+#include<cstdint>
+#include<vector>
+#include "../intermediate/icg.h"
+#include "./cfg.h"
+using namespace std;
+
+// Static single assignment view of the TAC. The quadruples themselves are
+// not renamed: passes walk the dominator tree keeping a stack of reaching
+// definitions per operand, and a phi says that at the start of a block
+// the operand may hold any of several definitions. Phis are placed at the
+// iterated dominance frontier of each operand's definitions (minimal SSA).
+class SsaForm
+{
+public:
+    // Variables and temporaries merged at the start of each block
+    vector<vector<OperandId>> phis;
+
+    // Number of instructions that assign each operand
+    vector<uint32_t> definitionCount;
+
+    // Needs cfg.computeDominators()
+    void build(const IntermediateCodeGnerator &icg, const ControlFlowGraph &cfg);
+};
+
+// Variables and temporaries are renamed; constants and labels are not
+bool isSsaOperand(const IntermediateCodeGnerator &icg, OperandId id);
+
+// Instructions that assign their result operand
+bool definesResult(Opcode op);
+
+#endif
@@ -1,678 +1,635 @@
 #include<vector>
-#include "../assembly/acg.h"
-#include "../intermediate/icg.h"
-#include "../symboltable/symbTable.h"
+#include "../ast/ast.h"
 #include "../lexer/lexer.h"
 #include "./parser.h"
-#include<unordered_set>
 #include<iostream>
 #include<string>
 using namespace std;
 
 
-Parser::Parser(const vector<Token> &tokens, SymbolTable &symTable, IntermediateCodeGnerator &icg)
-        : tokens(tokens), pos(0), symTable(symTable), icg(icg) {}
+Parser::Parser(Lexer &lexer, Arena &arena, Diagnostics &diagnostics)
+        : lexer(lexer), arena(arena), diagnostics(diagnostics) {}
 
-void Parser::parseProgram()
+Program *Parser::parseProgram()
 {
-    while (tokens[pos].type != T_EOF)
+    vector<Stmt *> statements;
+    while (lexer.peek().type != T_EOF)
     {
-        parseStatement();
+        if (Stmt *statement = parseTopLevelStatement())
+        {
+            statements.push_back(statement);
+        }
     }
+
+    Program *program = arena.make<Program>();
+    program->statements = arena.makeList(statements);
+    return program;
 }
 
-void Parser::parseStatement()
+Stmt *Parser::parseTopLevelStatement()
 {
-    if (tokens[pos].type == T_INT || tokens[pos].type == T_FLOAT || 
-        tokens[pos].type == T_DOUBLE || tokens[pos].type == T_STRING || 
-        tokens[pos].type == T_CHAR || tokens[pos].type == T_BOOL)
+    Stmt *statement = parseStatementOrRecover();
+    if (statement == nullptr && lexer.peek().type == T_RBRACE)
     {
-        parseDeclarationOrDeclarationAssignment();
+        // Recovery stops at a '}', which at the top level closes nothing
+        lexer.next();
     }
-    else if (tokens[pos].type == T_ID)
+    return statement;
+}
+
+Stmt *Parser::parseStatement()
+{
+    NestingLevel level(*this);
+    if (lexer.peek().type == T_INT || lexer.peek().type == T_FLOAT ||
+        lexer.peek().type == T_DOUBLE || lexer.peek().type == T_STRING ||
+        lexer.peek().type == T_CHAR || lexer.peek().type == T_BOOL)
     {
-        parseAssignment();
+        return parseDeclarationOrDeclarationAssignment();
     }
-    else if (tokens[pos].type == T_VOID)
+    else if (lexer.peek().type == T_ID)
     {
-        parseVoidFunction();
+        return parseAssignment();
     }
-    else if (tokens[pos].type == T_IF)
+    else if (lexer.peek().type == T_VOID)
     {
-        parseIfStatement();
+        return parseVoidFunction();
     }
-    else if (tokens[pos].type == T_SWITCH)
+    else if (lexer.peek().type == T_IF)
     {
-        parseSwitchStatement();
+        return parseIfStatement();
     }
-    else if (tokens[pos].type == T_RETURN)
+    else if (lexer.peek().type == T_SWITCH)
     {
-        parseReturnStatement();
+        return parseSwitchStatement();
     }
-    else if (tokens[pos].type == T_LBRACE)
+    else if (lexer.peek().type == T_RETURN)
     {
-        parseBlock();
+        return parseReturnStatement();
     }
-    else if (tokens[pos].type == T_AGAR)
+    else if (lexer.peek().type == T_LBRACE)
     {
-        parseAgarStatement();
+        return parseBlock();
     }
-    else if (tokens[pos].type == T_WHILE)
+    else if (lexer.peek().type == T_AGAR)
     {
-        parseWhileStatement();
+        return parseAgarStatement();
     }
-    else if (tokens[pos].type == T_FOR)
+    else if (lexer.peek().type == T_WHILE)
     {
-        parseForStatement();
+        return parseWhileStatement();
     }
-    else if(tokens[pos].type == T_BREAK){
-        parseBreakStatement();
+    else if (lexer.peek().type == T_FOR)
+    {
+        return parseForStatement();
     }
-    else if (tokens[pos].type == T_DO)
+    else if(lexer.peek().type == T_BREAK){
+        return parseBreakStatement();
+    }
+    else if (lexer.peek().type == T_DO)
     {
-        parseDoWhileStatement();
+        return parseDoWhileStatement();
     }
-    else if (tokens[pos].type == T_STANDARD_OUTPUT_STREAM)
+    else if (lexer.peek().type == T_STANDARD_OUTPUT_STREAM)
     {
-        parsePrintStatement();
+        return parsePrintStatement();
     }
-    else if (tokens[pos].type == T_STARNDARD_INPUT_STREAM)
+    else if (lexer.peek().type == T_STARNDARD_INPUT_STREAM)
     {
-        parseInputStatement();
+        return parseInputStatement();
     }
     else
     {
-        cout << "Syntax error: unexpected token '" << tokens[pos].value << "' at line " << tokens[pos].lineNumber << endl;
-        exit(1);
+        syntaxError("Syntax error: unexpected " + tokenValue(lexer.peek()));
+    }
+}
+
+// Records the error at the current token and abandons the statement
+void Parser::syntaxError(const string &message)
+{
+    diagnostics.error(lexer.peek().lineNumber, message);
+    throw SyntaxError{};
+}
+
+Parser::NestingLevel::NestingLevel(Parser &parser, int levels) : parser(parser)
+{
+    for (int i = 0; i < levels; i++) deeper();
+}
+
+void Parser::NestingLevel::deeper()
+{
+    if (parser.nesting == MAX_NESTING)
+    {
+        parser.syntaxError("Syntax error: nesting deeper than " + to_string(MAX_NESTING) + " levels");
+    }
+    parser.nesting++;
+    levels++;
+}
+
+// Skips to where the next statement can start: past a ';', or up to a '}'
+// that closes the enclosing block. Blocks opened on the way are skipped
+// whole, so a bad statement with a body does not cut the block short.
+void Parser::synchronize()
+{
+    int depth = 0;
+    while (lexer.peek().type != T_EOF)
+    {
+        TokenType type = lexer.peek().type;
+        if (type == T_SEMICOLON && depth == 0)
+        {
+            lexer.next();
+            return;
+        }
+        if (type == T_RBRACE)
+        {
+            if (depth == 0) return;
+            lexer.next();
+            if (--depth == 0) return;
+            continue;
+        }
+        if (type == T_LBRACE) depth++;
+        lexer.next();
+    }
+}
+
+// nullptr when the statement had a syntax error
+Stmt *Parser::parseStatementOrRecover()
+{
+    try
+    {
+        return parseStatement();
+    }
+    catch (const SyntaxError &)
+    {
+        synchronize();
+        return nullptr;
     }
 }
 
-void Parser::parseVoidFunction(){
+Stmt *Parser::parseVoidFunction(){
+    VoidFunctionStmt *function = makeStmt<VoidFunctionStmt>(StmtKind::VOID_FUNCTION);
     expect(T_VOID);
+    function->symbol = lexer.peek().symbol;
+    function->name = lexer.tokenValue(lexer.peek());
     expect(T_ID);
     expect(T_LPAREN);
     expect(T_RPAREN);
-    parseBlock();
+    function->body = parseBlock();
+    return function;
 }
-void Parser::parseInputStatement(){
+Stmt *Parser::parseInputStatement(){
+    InputStmt *input = makeStmt<InputStmt>(StmtKind::INPUT);
     expect(T_STARNDARD_INPUT_STREAM);
     expect(T_EXTRACTION_OPERATOR);
+    input->symbol = lexer.peek().symbol;
+    input->name = lexer.tokenValue(lexer.peek());
     expect(T_ID);
     expect(T_SEMICOLON);
+    return input;
 }
-void Parser::parsePrintStatement(){
+Stmt *Parser::parsePrintStatement(){
+    PrintStmt *print = makeStmt<PrintStmt>(StmtKind::PRINT);
     expect(T_STANDARD_OUTPUT_STREAM);
     expect(T_STREAM_INSERTION_OPERATOR);
+    print->text = lexer.tokenValue(lexer.peek());
     expect(T_STRING);
     expect(T_SEMICOLON);
+    return print;
 }
-void Parser::parseDoWhileStatement()
+Stmt *Parser::parseDoWhileStatement()
 {
+    DoWhileStmt *loop = makeStmt<DoWhileStmt>(StmtKind::DO_WHILE);
+
     // Parse 'do' keyword
     expect(T_DO);
 
-    // Generate start label for the do-while loop
-    string startLabel = icg.newTemp() + "_do_while_start";
-    icg.addInstruction(startLabel + ":");
-
     // Parse the body of the do-while loop
-    parseBlock();
+    loop->body = parseBlock();
 
     // Expect 'while' keyword
     expect(T_WHILE);
     expect(T_LPAREN);
 
-    // Generate label for condition check
-    string conditionLabel = icg.newTemp() + "_do_while_condition";
-    icg.addInstruction(conditionLabel + ":");
-
     // Parse the condition expression
-    string conditionExpr = parseExpression();
+    loop->condition = parseExpression();
     expect(T_RPAREN);
     expect(T_SEMICOLON);
-
-    // Generate condition check instruction
-    string conditionTemp = icg.newTemp();
-    icg.addInstruction(conditionTemp + " = " + conditionExpr);
-
-    // Generate conditional jump back to start of loop
-    string endLabel = icg.newTemp() + "_do_while_end";
-    icg.addInstruction("if !" + conditionTemp + " goto " + endLabel);
-    icg.addInstruction("goto " + startLabel);
-    icg.addInstruction(endLabel + ":");
+    return loop;
 }
 
-void Parser::parseBreakStatement(){
+Stmt *Parser::parseBreakStatement(){
+    Stmt *statement = makeStmt<Stmt>(StmtKind::BREAK);
     expect(T_BREAK);
     expect(T_SEMICOLON);
+    return statement;
 }
-void Parser::parseSwitchStatement()
+Stmt *Parser::parseSwitchStatement()
 {
+    SwitchStmt *switchStmt = makeStmt<SwitchStmt>(StmtKind::SWITCH);
+
     // Parse 'switch' keyword
     expect(T_SWITCH);
     expect(T_LPAREN);
-    
+
     // Parse the switch expression (what we're switching on)
-    string switchExpr = parseExpression();
+    switchStmt->subject = parseExpression();
     expect(T_RPAREN);
-    
+
     // Expect opening brace of switch block
     expect(T_LBRACE);
-    
+
     // Flag to track if default case has been seen
     bool hasDefaultCase = false;
-    
-    // Generate labels for switch statement
-    string endSwitchLabel = icg.newTemp() + "_switch_end";
-    
+
     // Parse cases
-    while (tokens[pos].type != T_RBRACE && tokens[pos].type != T_EOF)
+    vector<SwitchCase> cases;
+    while (lexer.peek().type != T_RBRACE && lexer.peek().type != T_EOF)
     {
-        if (tokens[pos].type == T_CASE)
+        if (lexer.peek().type == T_CASE)
         {
             // Parse case
             expect(T_CASE);
-            
+
             // Parse case expression (can be a literal or constant expression)
-            string caseExpr = parseExpression();
-            
+            SwitchCase switchCase;
+            switchCase.label = parseExpression();
+
             // Expect colon after case
             expect(T_COLON);
-            
-            // Generate a unique label for this case
-            string caseLabel = icg.newTemp() + "_case";
-            
-            // Add comparison instruction
-            string compareTemp = icg.newTemp();
-            icg.addInstruction(compareTemp + " = " + switchExpr + " == " + caseExpr);
-            
-            // Add conditional jump
-            string nextCaseLabel = icg.newTemp() + "_next_case";
-            icg.addInstruction("if !" + compareTemp + " goto " + nextCaseLabel);
-            
+
             // Parse statements in this case block
-            while (tokens[pos].type != T_CASE && 
-                   tokens[pos].type != T_DEFAULT && 
-                   tokens[pos].type != T_RBRACE)
+            vector<Stmt *> body;
+            while (lexer.peek().type != T_CASE &&
+                   lexer.peek().type != T_DEFAULT &&
+                   lexer.peek().type != T_RBRACE &&
+                   lexer.peek().type != T_EOF)
             {
-                parseStatement();
+                if (Stmt *statement = parseStatementOrRecover()) body.push_back(statement);
             }
-            
-            // Add unconditional jump to end of switch
-            icg.addInstruction("goto " + endSwitchLabel);
-            
-            // Label for next case
-            icg.addInstruction(nextCaseLabel + ":");
+            switchCase.body = arena.makeList(body);
+            cases.push_back(switchCase);
         }
-        else if (tokens[pos].type == T_DEFAULT)
+        else if (lexer.peek().type == T_DEFAULT)
         {
             // Ensure only one default case
             if (hasDefaultCase) {
-                cout << "Syntax error: Multiple default cases in switch statement" << endl;
-                exit(1);
+                syntaxError("Syntax error: Multiple default cases in switch statement");
             }
-            
+
             expect(T_DEFAULT);
             expect(T_COLON);
-            
+
             hasDefaultCase = true;
-            
+
             // Parse statements in default case block
-            while (tokens[pos].type != T_RBRACE)
+            vector<Stmt *> body;
+            while (lexer.peek().type != T_RBRACE && lexer.peek().type != T_EOF)
             {
-                parseStatement();
+                if (Stmt *statement = parseStatementOrRecover()) body.push_back(statement);
             }
+            cases.push_back(SwitchCase{nullptr, arena.makeList(body)});
         }
         else
         {
             break;
         }
     }
-    
-    // Add end switch label
-    icg.addInstruction(endSwitchLabel + ":");
-    
+    switchStmt->cases = arena.makeList(cases);
+
     // Close switch block
     expect(T_RBRACE);
+    return switchStmt;
 }
 
 
-string Parser::parseIncrementDecrement(){
-    if (tokens[pos].type == T_ID) {
-        string var = tokens[pos].value;
+ForStepStmt *Parser::parseIncrementDecrement(){
+    if (lexer.peek().type == T_ID) {
+        ForStepStmt *step = makeStmt<ForStepStmt>(StmtKind::FOR_STEP);
+        step->symbol = lexer.peek().symbol;
+        step->name = lexer.tokenValue(lexer.peek());
         expect(T_ID);
-        if (tokens[pos].type == T_PLUS && tokens[pos + 1].type == T_PLUS) {
-            string incrementCode = var + " = " + var + " + 1"; // TAC for increment
-            icg.addInstruction(incrementCode);
-            pos += 2;
-            return incrementCode;
-        } else if (tokens[pos].type == T_MINUS && tokens[pos + 1].type == T_MINUS) {
-            string decrementCode = var + " = " + var + " - 1"; // icg for decrement
-            icg.addInstruction(decrementCode);
-            pos += 2;
-            return decrementCode;
-        } else if (tokens[pos].type == T_ASSIGN) {
-            pos++;
-            string expr = parseExpression();
-            string assignmentCode = var + " = " + expr; // icg for assignment
-            icg.addInstruction(assignmentCode);
-            return assignmentCode; // Return the icg for assignment
+        if (lexer.peek().type == T_PLUS && lexer.peek(1).type == T_PLUS) {
+            step->op = T_PLUS; // i++
+            lexer.next();
+            lexer.next();
+            return step;
+        } else if (lexer.peek().type == T_MINUS && lexer.peek(1).type == T_MINUS) {
+            step->op = T_MINUS; // i--
+            lexer.next();
+            lexer.next();
+            return step;
+        } else if (lexer.peek().type == T_ASSIGN) {
+            lexer.next();
+            step->op = T_ASSIGN;
+            step->value = parseExpression();
+            return step;
         } else {
-            cout << "Syntax error: invalid increment/decrement in 'for' loop at line " << tokens[pos].lineNumber << endl;
-            exit(1);
+            syntaxError("Syntax error: invalid increment/decrement in 'for' loop");
         }
     } else {
-        cout << "Syntax error: expected increment/decrement expression in 'for' loop at lineNumber " << tokens[pos].lineNumber << endl;
-        exit(1);
+        syntaxError("Syntax error: expected increment/decrement expression in 'for' loop");
     }
 }
 
-void Parser::parseInitialization(){
-    if (tokens[pos].type == T_ID) {
-        parseAssignment();
+Stmt *Parser::parseInitialization(){
+    if (lexer.peek().type == T_ID) {
+        return parseAssignment();
     } else {
-        cout << "Syntax error: expected initialization statement in 'for' loop at line " << tokens[pos].lineNumber << endl;
-        exit(1);
+        syntaxError("Syntax error: expected initialization statement in 'for' loop");
     }
 }
 
-void Parser::parseForStatement() {
-    string initLabel = "L" + to_string(icg.tempCount++);
-    string startLabel = "L" + to_string(icg.tempCount++);
-    string endLabel = "L" + to_string(icg.tempCount++);
+Stmt *Parser::parseForStatement() {
+    ForStmt *loop = makeStmt<ForStmt>(StmtKind::FOR);
 
     // for (i = 0; i < 5; i = i + 1){}
     expect(T_FOR);
     expect(T_LPAREN);
 
     // parseInitialization();
-    parseDeclarationOrDeclarationAssignment();
-    icg.addInstruction(initLabel + ":");
+    loop->init = parseDeclarationOrDeclarationAssignment();
 
-    string condition = parseExpression();
-    icg.addInstruction("if " + condition + " goto " + endLabel);
+    loop->condition = parseExpression();
 
     expect(T_SEMICOLON);
-    string incrementCode = parseIncrementDecrement();
+    loop->step = parseIncrementDecrement();
 
     expect(T_RPAREN);
-    
-    icg.addInstruction(startLabel + ":");
-    parseBlock();  // Parse the body of the loop
-    icg.addInstruction(incrementCode);
-    icg.addInstruction("goto " + initLabel);
-    icg.addInstruction(endLabel + ":");
+
+    loop->body = parseBlock();  // Parse the body of the loop
+    return loop;
 }
 
 
 
-void Parser::parseWhileStatement()
+Stmt *Parser::parseWhileStatement()
 {
-    string startLabel = "L" + to_string(icg.tempCount++);
-    string endLabel = "L" + to_string(icg.tempCount++);
-
-    icg.addInstruction("goto " + startLabel);
-    icg.addInstruction(startLabel + ":");
+    WhileStmt *loop = makeStmt<WhileStmt>(StmtKind::WHILE);
 
     expect(T_WHILE);
     expect(T_LPAREN);
-    string condition = parseExpression();
+    loop->condition = parseExpression();
     expect(T_RPAREN);
 
-    string temp = icg.newTemp();
-    icg.addInstruction(temp + " = " + condition);
-    
-    icg.addInstruction("if " + temp + " goto " + endLabel); 
-    icg.addInstruction("goto " + startLabel);
-    
-    parseBlock();
-    
-    icg.addInstruction("goto " + startLabel);
-    icg.addInstruction(endLabel + ":");
+    loop->body = parseBlock();
+    return loop;
 }
 
 
-void Parser::parseAgarStatement()
+Stmt *Parser::parseAgarStatement()
 {
+    IfStmt *agar = makeStmt<IfStmt>(StmtKind::AGAR);
+
     expect(T_AGAR);
-    expect(T_LPAREN); 
-    string cond = parseExpression();
+    expect(T_LPAREN);
+    agar->condition = parseExpression();
     expect(T_RPAREN);
 
-    string temp = icg.newTemp();
-    icg.addInstruction(temp + " = " + cond); 
-    icg.addInstruction("agar " + temp + " goto L1");
-    icg.addInstruction("goto L2");
-    icg.addInstruction("L1:");
+    agar->thenBranch = parseStatement();
 
-    parseStatement();
-
-    if (tokens[pos].type == T_MAGAR)
+    if (lexer.peek().type == T_MAGAR)
     { // If an `magar` part exists, handle it.
-        icg.addInstruction("goto L3");
-        icg.addInstruction("L2:");
         expect(T_MAGAR);
-        parseStatement();
-        icg.addInstruction("L3:");
-    }
-    else
-    {
-        icg.addInstruction("L2:");
+        agar->elseBranch = parseStatement();
     }
+    return agar;
 }
 
-void Parser::parseDeclarationOrDeclarationAssignment()
+DeclarationStmt *Parser::parseDeclarationOrDeclarationAssignment()
 {
+    DeclarationStmt *declaration = makeStmt<DeclarationStmt>(StmtKind::DECLARATION);
+
     // Determine the type of the variable
-    string varType;
-    switch(tokens[pos].type) {
-        case T_INT:    varType = "int"; break;
-        case T_FLOAT:  varType = "float"; break;
-        case T_DOUBLE: varType = "double"; break;
-        case T_STRING: varType = "string"; break;
-        case T_CHAR:   varType = "char"; break;
-        case T_BOOL:   varType = "bool"; break;
-        default: 
-            cout << "Unexpected type in declaration" << endl;
-            exit(1);
-    }
-    
+    switch(lexer.peek().type) {
+        case T_INT:
+        case T_FLOAT:
+        case T_DOUBLE:
+        case T_STRING:
+        case T_CHAR:
+        case T_BOOL:
+            declaration->varType = lexer.peek().type;
+            break;
+        default:
+            syntaxError("Syntax error: unexpected type in declaration");
+    }
+
     // Consume the type token
-    expect(tokens[pos].type);
-    
+    expect(lexer.peek().type);
+
     // Get the variable name
-    string varName = expectAndReturnValue(T_ID);
-    
-    // Declare the variable in the symbol table
-    symTable.declareVariable(varName, varType, Scope::GLOBAL);
-    
+    declaration->symbol = lexer.peek().symbol;
+    declaration->name = lexer.tokenValue(lexer.peek());
+    expect(T_ID);
+
     // Check if this is a declaration with assignment
-    if (tokens[pos].type == T_ASSIGN)
+    if (lexer.peek().type == T_ASSIGN)
     {
         // Consume the assignment token
         expect(T_ASSIGN);
-        
+
         // Handle different types of assignments
-        if(tokens[pos].type == T_STRING){
-            string strValue = expectAndReturnValue(T_STRING);
-            
-            // Validate type compatibility
-            if (varType != "string") {
-                throw runtime_error("Type mismatch: Cannot assign string to " + varType);
-            }
-            
-            // Set value in symbol table
-            symTable.setVariableValue<string>(varName, strValue);
-            
-            // Generate intermediate code
-            icg.addInstruction(varName + " = " + strValue);
+        if(lexer.peek().type == T_STRING){
+            declaration->form = ValueForm::STRING;
+            declaration->literal = lexer.tokenValue(lexer.peek());
+            expect(T_STRING);
         }
-        else if(tokens[pos].type == T_TRUE || tokens[pos].type == T_FALSE) {
+        else if(lexer.peek().type == T_TRUE || lexer.peek().type == T_FALSE) {
             // Handle boolean literals
-            string boolValue = expectAndReturnValue(tokens[pos].type);
-            
-            // Validate type compatibility
-            if (varType != "bool") {
-                throw runtime_error("Type mismatch: Cannot assign boolean to " + varType);
-            }
-            
-            // Convert string to bool
-            bool boolVal = (boolValue == "true");
-            
-            // Set value in symbol table
-            symTable.setVariableValue<bool>(varName, boolVal);
-            
-            // Generate intermediate code
-            icg.addInstruction(varName + " = " + boolValue);
+            declaration->form = ValueForm::BOOL;
+            declaration->literal = lexer.tokenValue(lexer.peek());
+            expect(lexer.peek().type);
         }
         else {
             // For numeric and other types
-            string expr = parseExpression();
-            
-            // Validate type compatibility would ideally happen in parseExpression()
-            // For now, we'll just generate the assignment
-            
-            // Set value based on type
-            if (varType == "int") {
-                int intVal = stoi(expr);
-                symTable.setVariableValue<int>(varName, intVal);
-            }
-            else if (varType == "float") {
-                float floatVal = stof(expr);
-                symTable.setVariableValue<float>(varName, floatVal);
-            }
-            else if (varType == "double") {
-                double doubleVal = stod(expr);
-                symTable.setVariableValue<double>(varName, doubleVal);
-            }
-            
-            // Generate intermediate code
-            icg.addInstruction(varName + " = " + expr);
+            declaration->form = ValueForm::EXPRESSION;
+            declaration->value = parseExpression();
         }
     }
-    
+
     // Expect semicolon to end the statement
     expect(T_SEMICOLON);
+    return declaration;
 }
 
-void Parser::parseAssignment()
+Stmt *Parser::parseAssignment()
 {
-    string varName = expectAndReturnValue(T_ID);
-    
-    // Verify variable is declared
-    if (!symTable.isDeclared(varName)) {
-        throw runtime_error("Semantic error: Variable '" + varName + "' not declared before assignment");
-    }
-    
-    // Get the variable's type for type checking
-    string varType = symTable.getVariableType(varName);
-    
+    AssignmentStmt *assignment = makeStmt<AssignmentStmt>(StmtKind::ASSIGNMENT);
+    assignment->symbol = lexer.peek().symbol;
+    assignment->name = lexer.tokenValue(lexer.peek());
+    expect(T_ID);
+
     // Consume assignment token
     expect(T_ASSIGN);
 
-    if(tokens[pos].type == T_TRUE || tokens[pos].type == T_FALSE) {
+    if(lexer.peek().type == T_TRUE || lexer.peek().type == T_FALSE) {
         // Handling of boolean literals
-        string boolValue = expectAndReturnValue(tokens[pos].type);
-        
-        // Validate type compatibility
-        if (varType != "bool") {
-            throw runtime_error("Type mismatch: Cannot assign boolean to " + varType);
-        }
-        
-        // Convert string to bool
-        bool boolVal = (boolValue == "true");
-        
-        // Set value in symbol table
-        symTable.setVariableValue<bool>(varName, boolVal);
-        
-        // Generate intermediate code
-        icg.addInstruction(varName + " = " + boolValue);
-    }
-    else if(tokens[pos].type == T_STRING){
-        string strValue = expectAndReturnValue(T_STRING);
-        
-        // Validate type compatibility
-        if (varType != "string") {
-            throw runtime_error("Type mismatch: Cannot assign string to " + varType);
-        }
-        
-        // Set value in symbol table
-        symTable.setVariableValue<string>(varName, strValue);
-        
-        // Generate intermediate code
-        icg.addInstruction(varName + " = " + strValue);
+        assignment->form = ValueForm::BOOL;
+        assignment->literal = lexer.tokenValue(lexer.peek());
+        expect(lexer.peek().type);
+    }
+    else if(lexer.peek().type == T_STRING){
+        assignment->form = ValueForm::STRING;
+        assignment->literal = lexer.tokenValue(lexer.peek());
+        expect(T_STRING);
     }
     else {
         // For numeric and other types
-        string expr = parseExpression();
-        
-        // Set value based on type
-        if (varType == "int") {
-            // int intVal = stoi(expr);
-            symTable.setVariableValue<string>(varName, expr);
-        }
-        else if (varType == "float") {
-            // float floatVal = stof(expr);
-            symTable.setVariableValue<string>(varName, expr);
-        }
-        else if (varType == "double") {
-            // double doubleVal = stod(expr);
-            symTable.setVariableValue<string>(varName, expr);
-        }
-        
-        // Generate intermediate code
-        icg.addInstruction(varName + " = " + expr);
+        assignment->form = ValueForm::EXPRESSION;
+        assignment->value = parseExpression();
     }
-    
+
     // Expect semicolon to end the statement
     expect(T_SEMICOLON);
+    return assignment;
 }
 
-void Parser::parseIfStatement()
+Stmt *Parser::parseIfStatement()
 {
+    IfStmt *ifStmt = makeStmt<IfStmt>(StmtKind::IF);
+
     expect(T_IF);
     expect(T_LPAREN);
-    string cond = parseExpression();
+    ifStmt->condition = parseExpression();
     expect(T_RPAREN);
 
-    string temp = icg.newTemp();
-    icg.addInstruction(temp + " = " + cond);
-
-    icg.addInstruction("if " + temp + " goto L1");
-    icg.addInstruction("goto L2");
-    icg.addInstruction("L1:");
+    ifStmt->thenBranch = parseStatement();
 
-    parseStatement();
-
-    if (tokens[pos].type == T_ELSE)
+    if (lexer.peek().type == T_ELSE)
     { // If an `else` part exists, handle it.
-        icg.addInstruction("goto L3");
-        icg.addInstruction("L2:");
         expect(T_ELSE);
-        parseStatement();
-        icg.addInstruction("L3:");
-    }
-    else
-    {
-        icg.addInstruction("L2:");
+        ifStmt->elseBranch = parseStatement();
     }
+    return ifStmt;
 }
 
-void Parser::parseReturnStatement()
+Stmt *Parser::parseReturnStatement()
 {
+    ReturnStmt *returnStmt = makeStmt<ReturnStmt>(StmtKind::RETURN);
     expect(T_RETURN);
-    string expr = parseExpression();
-    icg.addInstruction("return " + expr);
+    returnStmt->value = parseExpression();
     expect(T_SEMICOLON);
+    return returnStmt;
 }
 
-void Parser::parseBlock()
+BlockStmt *Parser::parseBlock()
 {
+    BlockStmt *block = makeStmt<BlockStmt>(StmtKind::BLOCK);
+    vector<Stmt *> statements;
     expect(T_LBRACE);
-    while (tokens[pos].type != T_RBRACE && tokens[pos].type != T_EOF)
+    while (lexer.peek().type != T_RBRACE && lexer.peek().type != T_EOF)
     {
-        parseStatement();
+        if (Stmt *statement = parseStatementOrRecover()) statements.push_back(statement);
     }
     expect(T_RBRACE);
+    block->statements = arena.makeList(statements);
+    return block;
 }
 
-string Parser::parseExpression()
+Expr *Parser::parseExpression()
 {
-    string term = parseTerm();
-    while (tokens[pos].type == T_PLUS || tokens[pos].type == T_MINUS)
-    {
-        TokenType op = tokens[pos++].type;
-        string nextTerm = parseTerm();
-        string temp = icg.newTemp();
-        icg.addInstruction(temp + " = " + term + (op == T_PLUS ? " + " : " - ") + nextTerm);
-        term = temp;
-    }
-        while (tokens[pos].type == T_GT || tokens[pos].type == T_LT || tokens[pos].type == T_EQ || tokens[pos].type == T_NE || tokens[pos].type == T_LE || tokens[pos].type == T_GE || tokens[pos].type == T_LOGICAL_AND || tokens[pos].type == T_LOGICAL_OR)
-    {
-        // pos++;
-        TokenType op = tokens[pos++].type;
-        string nextExpr = parseExpression();
-        string temp = icg.newTemp();
-        if (op == T_GT) {
-        icg.addInstruction(temp + " = " + term + " > " + nextExpr);
-        } else if (op == T_EQ) {
-            icg.addInstruction(temp + " = " + term + " == " + nextExpr);
-        } else if (op == T_LT) {
-            icg.addInstruction(temp + " = " + term + " < " + nextExpr);
-        } else if (op == T_NE) {
-            icg.addInstruction(temp + " = " + term + " != " + nextExpr);
-        } else if (op == T_LE) {
-            icg.addInstruction(temp + " = " + term + " <= " + nextExpr);
-        } else if (op == T_GE) {
-            icg.addInstruction(temp + " = " + term + " >= " + nextExpr);
-        } else if (op == T_LOGICAL_AND) {
-            icg.addInstruction(temp + " = " + term + " && " + nextExpr);
-        } else if (op == T_LOGICAL_OR) {
-            icg.addInstruction(temp + " = " + term + " || " + nextExpr);
-        }
-
-        term = temp;
+    NestingLevel level(*this);
+    Expr *term = parseTerm();
+    while (lexer.peek().type == T_PLUS || lexer.peek().type == T_MINUS)
+    {
+        level.deeper();
+        int lineNumber = lexer.peek().lineNumber;
+        TokenType op = lexer.next().type;
+        Expr *nextTerm = parseTerm();
+        term = makeBinary(op, term, nextTerm, lineNumber);
+    }
+        while (lexer.peek().type == T_GT || lexer.peek().type == T_LT || lexer.peek().type == T_EQ || lexer.peek().type == T_NE || lexer.peek().type == T_LE || lexer.peek().type == T_GE || lexer.peek().type == T_LOGICAL_AND || lexer.peek().type == T_LOGICAL_OR)
+    {
+        int lineNumber = lexer.peek().lineNumber;
+        TokenType op = lexer.next().type;
+        Expr *nextExpr = parseExpression();
+        term = makeBinary(op, term, nextExpr, lineNumber);
     }
     return term;
 }
 
-string Parser::parseTerm()
+Expr *Parser::parseTerm()
 {
-    string factor = parseFactor();
-    while (tokens[pos].type == T_MUL || tokens[pos].type == T_DIV)
+    NestingLevel level(*this, 0);
+    Expr *factor = parseFactor();
+    while (lexer.peek().type == T_MUL || lexer.peek().type == T_DIV)
     {
-        TokenType op = tokens[pos++].type;
-        string nextFactor = parseFactor();
-        string temp = icg.newTemp();
-        icg.addInstruction(temp + " = " + factor + (op == T_MUL ? " * " : " / ") + nextFactor);
-        factor = temp;
+        level.deeper();
+        int lineNumber = lexer.peek().lineNumber;
+        TokenType op = lexer.next().type;
+        Expr *nextFactor = parseFactor();
+        factor = makeBinary(op, factor, nextFactor, lineNumber);
     }
     return factor;
 }
 
-string Parser::parseFactor()
+Expr *Parser::parseFactor()
 {
-    if (tokens[pos].type == T_NUM)
+    if (lexer.peek().type == T_NUM)
     {
-        return tokens[pos++].value;
+        return makeLiteral(ExprKind::NUMBER, lexer.next());
     }
     // Handle float literals, e.g., "20.09774"
-    else if (tokens[pos].type == T_FLOAT) {
-        return tokens[pos++].value;
+    else if (lexer.peek().type == T_FLOAT) {
+        return makeLiteral(ExprKind::FLOAT, lexer.next());
     }
-    else if (tokens[pos].type == T_ID)
+    else if (lexer.peek().type == T_ID)
     {
-        return tokens[pos++].value;
-    }
-    else if (tokens[pos].type == T_TRUE || tokens[pos].type == T_FALSE)
+        Token token = lexer.next();
+        IdentifierExpr *identifier = arena.make<IdentifierExpr>();
+        identifier->kind = ExprKind::IDENTIFIER;
+        identifier->lineNumber = token.lineNumber;
+        identifier->name = lexer.tokenValue(token);
+        identifier->symbol = token.symbol;
+        return identifier;
+    }
+    else if (lexer.peek().type == T_TRUE || lexer.peek().type == T_FALSE)
     {
-        return tokens[pos++].value;
+        return makeLiteral(ExprKind::BOOL, lexer.next());
     }
-    else if (tokens[pos].type == T_LPAREN)
+    else if (lexer.peek().type == T_LPAREN)
     {
         expect(T_LPAREN);
-        string expr = parseExpression();
+        Expr *expr = parseExpression();
         expect(T_RPAREN);
         return expr;
     }
     else
     {
-        cout << "Syntax error: unexpected token '" << tokens[pos].value << "' at line " << tokens[pos].lineNumber << endl;
-        exit(1);
+        syntaxError("Syntax error: unexpected " + tokenValue(lexer.peek()));
     }
 }
+
+Expr *Parser::makeLiteral(ExprKind kind, const Token &token)
+{
+    LiteralExpr *literal = arena.make<LiteralExpr>();
+    literal->kind = kind;
+    literal->lineNumber = token.lineNumber;
+    literal->text = lexer.tokenValue(token);
+    return literal;
+}
+
+Expr *Parser::makeBinary(TokenType op, Expr *lhs, Expr *rhs, int lineNumber)
+{
+    BinaryExpr *binary = arena.make<BinaryExpr>();
+    binary->kind = ExprKind::BINARY;
+    binary->lineNumber = lineNumber;
+    binary->op = op;
+    binary->lhs = lhs;
+    binary->rhs = rhs;
+    return binary;
+}
+
 void Parser::expect(TokenType type)
 {
-    if (tokens[pos].type != type)
+    if (lexer.peek().type != type)
     {
-        cout << "Syntax error: expected '" << type << "' at line " << tokens[pos].lineNumber << endl;
-        exit(1);
+        syntaxError("Syntax error: expected " + lexer.tokenTypeToString(type) + " but found " + tokenValue(lexer.peek()));
     }
-    pos++;
+    lexer.next();
 }
-string Parser::expectAndReturnValue(TokenType type)
+
+// Spelling of a token for error messages
+string Parser::tokenValue(const Token &token) const
 {
-    string value = tokens[pos].value;
-    expect(type);
-    return value;
+    if (token.type == T_EOF) return "end of file";
+    return "'" + string(lexer.tokenValue(token)) + "'";
 }
\ No newline at end of file
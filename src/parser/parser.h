@@ -1,49 +1,98 @@
 #ifndef PARSER_H
 #define PARSER_H
 #include<vector>
-#include "../assembly/acg.h"
-#include "../intermediate/icg.h"
-#include "../symboltable/symbTable.h"
+#include "../ast/arena.h"
+#include "../ast/ast.h"
 #include "../lexer/lexer.h"
 #include<string>
 using namespace std;
 
+// Recursive descent parser. It pulls tokens from the Lexer and builds the
+// syntax tree in the given Arena; semantic checks and code generation
+// happen afterwards, when AstLowering walks the tree.
+//
+// Syntax errors go to `diagnostics`. The statement that has one is
+// dropped and parsing picks up after the next ';' or at the next '}'
+// (panic mode), so one pass reports every error; the tree is complete
+// only when there were none.
 class Parser
 {
 public:
     // Constructor
-    Parser(const vector<Token> &tokens, SymbolTable &symTable, IntermediateCodeGnerator &icg);
-    void parseProgram();
+    Parser(Lexer &lexer, Arena &arena, Diagnostics &diagnostics);
+    Program *parseProgram();
+
+    // The next top-level statement, or null when it had a syntax error or
+    // was a stray '}'; parseProgram() calls this until the end of input
+    Stmt *parseTopLevelStatement();
 
 private:
-    vector<Token> tokens;
-    size_t pos;
-    SymbolTable &symTable;
-    IntermediateCodeGnerator &icg;
-
-    void parseStatement();
-    string parseIncrementDecrement();
-    void parseInitialization();
-    void parseForStatement();
-    void parseWhileStatement();
-    void parseAgarStatement();
-    void parseDeclaration();
-    void parseAssignment();
-    void parseIfStatement();
-    void parseReturnStatement();
-    void parseBlock();
-    string parseExpression();
-    string parseTerm();
-    string parseFactor();
+    Lexer &lexer;
+    Arena &arena;
+    Diagnostics &diagnostics;
+
+    // Unwinds from a syntax error to the statement being parsed
+    struct SyntaxError {};
+
+    // Statements and expressions nest by recursion, here and in every pass
+    // over the tree, so nesting deeper than this is a syntax error rather
+    // than a stack overflow
+    static constexpr int MAX_NESTING = 256;
+    int nesting = 0;
+
+    // Levels of nesting held for as long as it lives: one to start with,
+    // and one more per deeper() for operators that chain to the left
+    class NestingLevel
+    {
+    public:
+        explicit NestingLevel(Parser &parser, int levels = 1);
+        ~NestingLevel() { parser.nesting -= levels; }
+        void deeper();
+
+    private:
+        Parser &parser;
+        int levels = 0;
+    };
+
+    [[noreturn]] void syntaxError(const string &message);
+    void synchronize();
+    Stmt *parseStatementOrRecover();
+
+    Stmt *parseStatement();
+    ForStepStmt *parseIncrementDecrement();
+    Stmt *parseInitialization();
+    Stmt *parseForStatement();
+    Stmt *parseWhileStatement();
+    Stmt *parseAgarStatement();
+    Stmt *parseAssignment();
+    Stmt *parseIfStatement();
+    Stmt *parseReturnStatement();
+    BlockStmt *parseBlock();
+    Expr *parseExpression();
+    Expr *parseTerm();
+    Expr *parseFactor();
     void expect(TokenType type);
-    string expectAndReturnValue(TokenType type);
-    void parseDeclarationOrDeclarationAssignment();
-    void parseSwitchStatement();
-    void parseBreakStatement();
-    void parseDoWhileStatement();
-    void parsePrintStatement();
-    void parseInputStatement();
-    void parseVoidFunction();
+    string tokenValue(const Token &token) const;
+    DeclarationStmt *parseDeclarationOrDeclarationAssignment();
+    Stmt *parseSwitchStatement();
+    Stmt *parseBreakStatement();
+    Stmt *parseDoWhileStatement();
+    Stmt *parsePrintStatement();
+    Stmt *parseInputStatement();
+    Stmt *parseVoidFunction();
+
+    Expr *makeLiteral(ExprKind kind, const Token &token);
+    Expr *makeBinary(TokenType op, Expr *lhs, Expr *rhs, int lineNumber);
+
+    // New statement node of the given kind, stamped with the current line
+    template <typename T>
+    T *makeStmt(StmtKind kind)
+    {
+        T *stmt = arena.make<T>();
+        stmt->kind = kind;
+        stmt->lineNumber = lexer.peek().lineNumber;
+        return stmt;
+    }
 
     // do while 
     // switch
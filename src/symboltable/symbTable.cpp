@@ -1,54 +1,148 @@
 // symbTable.cpp
 #include "symbTable.h"
+#include "../lexer/stringPool.h"
+#include <algorithm>
 
-void SymbolTable::declareVariable(const string &name, const string &type, Scope scope)
+static constexpr size_t INITIAL_SLOTS = 64;
+
+// Symbol ids are handed out sequentially, so a multiplicative hash spreads
+// neighbouring ids across the table
+static inline size_t slotIndex(uint32_t symbol, size_t mask)
+{
+    return (symbol * 2654435769u) & mask;
+}
+
+const char *varTypeName(VarType type)
 {
-    if (symbolTable.find(name) != symbolTable.end())
+    switch (type)
     {
-        throw runtime_error("Semantic error: Variable '" + name + "' is already declared.");
+        case VarType::INT:    return "int";
+        case VarType::FLOAT:  return "float";
+        case VarType::DOUBLE: return "double";
+        case VarType::STRING: return "string";
+        case VarType::CHAR:   return "char";
+        case VarType::BOOL:   return "bool";
     }
-    
-    SymbolTableEntry entry;
-    entry.name = name;
-    entry.type = type;
-    entry.scope = scope;
-    
-    symbolTable[name] = entry;
+    return "unknown";
 }
 
-string SymbolTable::getVariableType(const string &name) const
+SymbolTable::SymbolTable(StringPool &pool) : pool(pool), slots(INITIAL_SLOTS, Slot{StringPool::NO_SYMBOL, NO_HANDLE}), usedSlots(0) {}
+
+SymbolTable::Slot &SymbolTable::findSlot(uint32_t symbol)
 {
-    if (symbolTable.find(name) == symbolTable.end())
+    size_t mask = slots.size() - 1;
+    size_t index = slotIndex(symbol, mask);
+    while (slots[index].symbol != symbol && slots[index].symbol != StringPool::NO_SYMBOL)
     {
-        throw runtime_error("Semantic error: Variable '" + name + "' is not declared.");
+        index = (index + 1) & mask;
     }
-    return symbolTable.at(name).type;
+    return slots[index];
 }
 
-Scope SymbolTable::getVariableScope(const string &name) const
+const SymbolTable::Slot *SymbolTable::findSlotIfPresent(uint32_t symbol) const
 {
-    if (symbolTable.find(name) == symbolTable.end())
+    size_t mask = slots.size() - 1;
+    size_t index = slotIndex(symbol, mask);
+    while (slots[index].symbol != StringPool::NO_SYMBOL)
     {
-        throw runtime_error("Semantic error: Variable '" + name + "' is not declared.");
+        if (slots[index].symbol == symbol)
+        {
+            return &slots[index];
+        }
+        index = (index + 1) & mask;
     }
-    return symbolTable.at(name).scope;
+    return nullptr;
 }
 
-bool SymbolTable::isDeclared(const string &name) const
+void SymbolTable::grow()
 {
-    return symbolTable.find(name) != symbolTable.end();
+    vector<Slot> old(slots.size() * 2, Slot{StringPool::NO_SYMBOL, NO_HANDLE});
+    old.swap(slots);
+    for (const Slot &slot : old)
+    {
+        if (slot.symbol != StringPool::NO_SYMBOL)
+        {
+            findSlot(slot.symbol) = slot;
+        }
+    }
 }
 
-bool SymbolTable::isInitialized(const string &name) const
+SymbolHandle SymbolTable::declareVariable(uint32_t symbol, VarType type)
 {
-    if (symbolTable.find(name) == symbolTable.end())
+    // Keep the load factor at or below one half
+    if ((usedSlots + 1) * 2 > slots.size())
+    {
+        grow();
+    }
+
+    Slot &slot = findSlot(symbol);
+    if (slot.symbol == StringPool::NO_SYMBOL)
+    {
+        slot.symbol = symbol;
+        usedSlots++;
+    }
+    else if (slot.current != NO_HANDLE && entries[slot.current].depth == currentDepth())
     {
-        throw runtime_error("Semantic error: Variable '" + name + "' is not declared.");
+        throw runtime_error("Semantic error: Variable '" + string(pool.view(symbol)) + "' is already declared");
     }
-    return symbolTable.at(name).isInitialized;
+
+    SymbolTableEntry entry;
+    entry.type = type;
+    entry.valueTag = ValueTag::NONE;
+    entry.scope = currentDepth() == 0 ? Scope::GLOBAL : Scope::LOCAL;
+    entry.symbol = symbol;
+    entry.depth = currentDepth();
+    entry.shadowed = slot.current;
+    entries.push_back(entry);
+
+    SymbolHandle handle = static_cast<SymbolHandle>(entries.size() - 1);
+    slot.current = handle;
+    scopeEntries.push_back(handle);
+    return handle;
 }
 
-void SymbolTable::printSymbolTable() const
+SymbolHandle SymbolTable::lookup(uint32_t symbol) const
+{
+    const Slot *slot = findSlotIfPresent(symbol);
+    return slot == nullptr ? NO_HANDLE : slot->current;
+}
+
+string_view SymbolTable::name(SymbolHandle handle) const
+{
+    return pool.view(entries[handle].symbol);
+}
+
+uint32_t SymbolTable::internText(string_view text)
+{
+    return pool.intern(text);
+}
+
+string_view SymbolTable::text(uint32_t id) const
+{
+    return pool.view(id);
+}
+
+void SymbolTable::enterScope()
+{
+    scopeStarts.push_back(scopeEntries.size());
+}
+
+void SymbolTable::exitScope()
+{
+    // Uncover whatever the scope's declarations were hiding. A slot whose
+    // symbol is no longer visible keeps its key with no entry, so the
+    // probe sequences of other symbols stay intact.
+    size_t start = scopeStarts.back();
+    scopeStarts.pop_back();
+    while (scopeEntries.size() > start)
+    {
+        const SymbolTableEntry &closing = entries[scopeEntries.back()];
+        findSlot(closing.symbol).current = closing.shadowed;
+        scopeEntries.pop_back();
+    }
+}
+
+void SymbolTable::printSymbolTable(ostream &out) const
 {
     // Define column widths
     const int nameWidth = 20;
@@ -57,36 +151,47 @@ void SymbolTable::printSymbolTable() const
     const int valueWidth = 20;
 
     // Print top border
-    cout << "+" << string(nameWidth + 2, '-') 
-         << "+" << string(typeWidth + 2, '-')
-         << "+" << string(scopeWidth + 2, '-')
-         << "+" << string(valueWidth + 2, '-') << "+" << endl;
+    out << "+" << string(nameWidth + 2, '-') 
+        << "+" << string(typeWidth + 2, '-')
+        << "+" << string(scopeWidth + 2, '-')
+        << "+" << string(valueWidth + 2, '-') << "+" << endl;
 
     // Print header row
-    cout << "| " << left << setw(nameWidth) << "Variable Name"
-         << " | " << left << setw(typeWidth) << "Type"
-         << " | " << left << setw(scopeWidth) << "Scope"
-         << " | " << left << setw(valueWidth) << "Value" 
-         << " |" << endl;
+    out << "| " << left << setw(nameWidth) << "Variable Name"
+        << " | " << left << setw(typeWidth) << "Type"
+        << " | " << left << setw(scopeWidth) << "Scope"
+        << " | " << left << setw(valueWidth) << "Value" 
+        << " |" << endl;
 
     // Print header separator
-    cout << "+" << string(nameWidth + 2, '-') 
-         << "+" << string(typeWidth + 2, '-')
-         << "+" << string(scopeWidth + 2, '-')
-         << "+" << string(valueWidth + 2, '-') << "+" << endl;
+    out << "+" << string(nameWidth + 2, '-') 
+        << "+" << string(typeWidth + 2, '-')
+        << "+" << string(scopeWidth + 2, '-')
+        << "+" << string(valueWidth + 2, '-') << "+" << endl;
 
     // Check if the symbol table is empty
-    if (symbolTable.empty())
+    if (entries.empty())
     {
-        cout << "| " << setw(nameWidth + typeWidth + scopeWidth + valueWidth + 7) << "No symbols declared." << " |" << endl;
+        out << "| " << setw(nameWidth + typeWidth + scopeWidth + valueWidth + 7) << "No symbols declared." << " |" << endl;
     }
     else
     {
-        // Print each symbol
-        for (const auto &entry : symbolTable)
+        // Print each symbol, including those of closed scopes, ordered by
+        // name and then by declaration
+        vector<SymbolHandle> sorted;
+        sorted.reserve(entries.size());
+        for (SymbolHandle handle = 0; handle < entries.size(); handle++)
+        {
+            sorted.push_back(handle);
+        }
+        stable_sort(sorted.begin(), sorted.end(),
+                    [this](SymbolHandle a, SymbolHandle b) { return name(a) < name(b); });
+
+        for (SymbolHandle handle : sorted)
         {
+            const SymbolTableEntry *entry = &entries[handle];
             string scopeStr;
-            switch(entry.second.scope) {
+            switch(entry->scope) {
                 case Scope::GLOBAL: scopeStr = "GLOBAL"; break;
                 case Scope::LOCAL: scopeStr = "LOCAL"; break;
                 case Scope::PARAMETER: scopeStr = "PARAMETER"; break;
@@ -94,28 +199,18 @@ void SymbolTable::printSymbolTable() const
             }
 
             string valueStr = "Uninitialized";
-            if (entry.second.isInitialized) {
-                try {
-                    // Attempt to convert value to string based on type
-                    if (holds_alternative<int>(entry.second.value))
-                        valueStr = to_string(get<int>(entry.second.value));
-                    else if (holds_alternative<float>(entry.second.value))
-                        valueStr = to_string(get<float>(entry.second.value));
-                    else if (holds_alternative<double>(entry.second.value))
-                        valueStr = to_string(get<double>(entry.second.value));
-                    else if (holds_alternative<string>(entry.second.value))
-                        valueStr = get<string>(entry.second.value);
-                    else if (holds_alternative<char>(entry.second.value))
-                        valueStr = string(1, get<char>(entry.second.value));
-                    else if (holds_alternative<bool>(entry.second.value))
-                        valueStr = get<bool>(entry.second.value) ? "true" : "false";
-                } catch (...) {
-                    valueStr = "Error";
-                }
+            switch (entry->valueTag) {
+                case ValueTag::NONE: break;
+                case ValueTag::INT: valueStr = to_string(entry->intValue); break;
+                case ValueTag::FLOAT: valueStr = to_string(entry->floatValue); break;
+                case ValueTag::DOUBLE: valueStr = to_string(entry->doubleValue); break;
+                case ValueTag::TEXT: valueStr = string(pool.view(entry->textValue)); break;
+                case ValueTag::CHAR: valueStr = string(1, entry->charValue); break;
+                case ValueTag::BOOL: valueStr = entry->boolValue ? "true" : "false"; break;
             }
 
-            cout << "| " << left << setw(nameWidth) << entry.first
-                 << " | " << left << setw(typeWidth) << entry.second.type
+            out << "| " << left << setw(nameWidth) << name(handle)
+                 << " | " << left << setw(typeWidth) << varTypeName(entry->type)
                  << " | " << left << setw(scopeWidth) << scopeStr
                  << " | " << left << setw(valueWidth) << valueStr
                  << " |" << endl;
@@ -123,8 +218,8 @@ void SymbolTable::printSymbolTable() const
     }
 
     // Print bottom border
-    cout << "+" << string(nameWidth + 2, '-') 
-         << "+" << string(typeWidth + 2, '-')
-         << "+" << string(scopeWidth + 2, '-')
-         << "+" << string(valueWidth + 2, '-') << "+" << endl;
+    out << "+" << string(nameWidth + 2, '-') 
+        << "+" << string(typeWidth + 2, '-')
+        << "+" << string(scopeWidth + 2, '-')
+        << "+" << string(valueWidth + 2, '-') << "+" << endl;
 }
\ No newline at end of file
@@ -3,75 +3,133 @@
 #define SYMBOL_TABLE_H
 
 #include <iostream>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <string>
-#include <map>
-#include <variant>
+#include <string_view>
 #include <stdexcept>
 #include <iomanip>
 
 using namespace std;
 
-enum class Scope {
+enum class Scope : uint8_t {
     GLOBAL,
     LOCAL,
     PARAMETER,
     TEMPORARY
 };
 
+enum class VarType : uint8_t {
+    INT,
+    FLOAT,
+    DOUBLE,
+    STRING,
+    CHAR,
+    BOOL
+};
+
+const char *varTypeName(VarType type);
+
+// Which of the SymbolTableEntry value members is set
+enum class ValueTag : uint8_t {
+    NONE,       // not initialized
+    INT,
+    FLOAT,
+    DOUBLE,
+    TEXT,       // StringPool id: string literals and unevaluated expressions
+    CHAR,
+    BOOL
+};
+
+// Index of an entry in the SymbolTable. Entries are never removed, so a
+// handle stays valid after its scope has been closed.
+typedef uint32_t SymbolHandle;
+static constexpr SymbolHandle NO_HANDLE = 0xFFFFFFFFu;
+
+// 24 bytes: the name and any string value are StringPool ids rather than
+// owned strings
 class SymbolTableEntry {
 public:
-    string name;
-    string type;
+    uint32_t symbol;        // interned name, see StringPool
+    SymbolHandle shadowed;  // same name in an enclosing scope, or NO_HANDLE
+    uint32_t depth;         // scope nesting level, 0 is global
+    VarType type;
     Scope scope;
-    variant<int, float, double, string, char, bool> value;
-    bool isInitialized;
-
-    SymbolTableEntry() : isInitialized(false) {}
-    
-    template<typename T>
-    void setValue(T val) {
-        value = val;
-        isInitialized = true;
-    }
-
-    template<typename T>
-    T getValue() const {
-        if (!isInitialized) {
-            throw runtime_error("Variable not initialized");
-        }
-        return get<T>(value);
-    }
+    ValueTag valueTag;
+    union {
+        int32_t intValue;
+        float floatValue;
+        double doubleValue;
+        uint32_t textValue;
+        char charValue;
+        bool boolValue;
+    };
+
+    bool isInitialized() const { return valueTag != ValueTag::NONE; }
+
+    void setInt(int32_t val)    { intValue = val;    valueTag = ValueTag::INT; }
+    void setFloat(float val)    { floatValue = val;  valueTag = ValueTag::FLOAT; }
+    void setDouble(double val)  { doubleValue = val; valueTag = ValueTag::DOUBLE; }
+    void setText(uint32_t id)   { textValue = id;    valueTag = ValueTag::TEXT; }
+    void setChar(char val)      { charValue = val;   valueTag = ValueTag::CHAR; }
+    void setBool(bool val)      { boolValue = val;   valueTag = ValueTag::BOOL; }
 };
 
+static_assert(sizeof(SymbolTableEntry) <= 24, "SymbolTableEntry should stay compact");
+
+class StringPool;
+
+// Variables are looked up by their interned symbol id in an open
+// addressing table. Each slot holds the innermost visible declaration of
+// one symbol; declarations in nested scopes link to the one they shadow,
+// and closing a scope puts those back.
 class SymbolTable {
 public:
-    void declareVariable(const string &name, const string &type, Scope scope = Scope::LOCAL);
-    string getVariableType(const string &name) const;
-    Scope getVariableScope(const string &name) const;
-    
-    template<typename T>
-    void setVariableValue(const string &name, T value) {
-        if (symbolTable.find(name) == symbolTable.end()) {
-            throw runtime_error("Semantic error: Variable '" + name + "' is not declared.");
-        }
-        symbolTable[name].setValue(value);
-    }
-
-    template<typename T>
-    T getVariableValue(const string &name) const {
-        if (symbolTable.find(name) == symbolTable.end()) {
-            throw runtime_error("Semantic error: Variable '" + name + "' is not declared.");
-        }
-        return symbolTable.at(name).getValue<T>();
-    }
-
-    bool isDeclared(const string &name) const;
-    bool isInitialized(const string &name) const;
-    void printSymbolTable() const;
+    explicit SymbolTable(StringPool &pool);
+
+    // Declares a variable in the current scope. Redeclaring a name in the
+    // same scope is an error; an inner scope may shadow an outer one.
+    SymbolHandle declareVariable(uint32_t symbol, VarType type);
+
+    // The innermost visible declaration, or NO_HANDLE
+    SymbolHandle lookup(uint32_t symbol) const;
+
+    SymbolTableEntry &entry(SymbolHandle handle) { return entries[handle]; }
+    const SymbolTableEntry &entry(SymbolHandle handle) const { return entries[handle]; }
+
+    // Blocks and function bodies open a scope of their own
+    void enterScope();
+    void exitScope();
+    uint32_t currentDepth() const { return static_cast<uint32_t>(scopeStarts.size()); }
+
+    string_view name(SymbolHandle handle) const;
+
+    // Interns a string value for SymbolTableEntry::setText()
+    uint32_t internText(string_view text);
+    string_view text(uint32_t id) const;
+
+    void printSymbolTable(ostream &out = cout) const;
 
 private:
-    map<string, SymbolTableEntry> symbolTable;
+    struct Slot {
+        uint32_t symbol;
+        SymbolHandle current;
+    };
+
+    StringPool &pool;
+    deque<SymbolTableEntry> entries;
+    vector<Slot> slots;
+    size_t usedSlots;
+
+    // Entries declared in the open scopes, innermost last, and where each
+    // scope starts in that list
+    vector<SymbolHandle> scopeEntries;
+    vector<size_t> scopeStarts;
+
+    Slot &findSlot(uint32_t symbol);
+    const Slot *findSlotIfPresent(uint32_t symbol) const;
+    void grow();
 };
 
-#endif // SYMBOL_TABLE_H
\ No newline at end of file
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,281 @@
+// Differential test of the two ways of running a program: the TAC
+// interpreter (--run) and native code from the JIT (--jit), at -O0, -O1 and
+// -O2. Every run must end like the interpreter at -O0 does: with the same
+// return value and variables, or with the same runtime error. Inputs are
+// the files given on the command line plus random integer programs. Run it
+// with `make test`.
+#include "../src/driver/compiler.h"
+#include "../src/interpreter/interpreter.h"
+#include "../src/assembly/encoder.h"
+#include "../src/jit/jit.h"
+#include "../src/lexer/sourceBuffer.h"
+#include<map>
+#include<random>
+#include<sstream>
+#include<stdexcept>
+#include<string>
+#include<vector>
+
+using namespace std;
+
+namespace {
+
+struct Outcome
+{
+    string error;
+    int32_t status = 0;
+    map<string, string> variables;
+
+    bool operator==(const Outcome &other) const
+    {
+        return error == other.error && status == other.status && variables == other.variables;
+    }
+
+    // Only the variables `reference` has: the optimizer adds its own, like
+    // t7_iv, which the source never names
+    void keepVariablesOf(const Outcome &reference)
+    {
+        for (auto variable = variables.begin(); variable != variables.end();)
+        {
+            if (reference.variables.count(variable->first)) ++variable;
+            else variable = variables.erase(variable);
+        }
+    }
+
+    string describe() const
+    {
+        if (!error.empty()) return "error: " + error;
+        string text = "returned " + to_string(status);
+        for (const auto &variable : variables) text += ", " + variable.first + " = " + variable.second;
+        return text;
+    }
+};
+
+Outcome interpret(const IntermediateCodeGnerator &icg)
+{
+    Outcome outcome;
+    Interpreter interpreter;
+    interpreter.load(icg);
+    try
+    {
+        outcome.status = interpreter.run();
+    }
+    catch (const runtime_error &error)
+    {
+        outcome.error = error.what();
+        return outcome;
+    }
+
+    // "name = value" lines
+    ostringstream listing;
+    interpreter.printVariables(listing);
+    istringstream lines(listing.str());
+    for (string line; getline(lines, line);)
+    {
+        size_t equals = line.find(" = ");
+        outcome.variables[line.substr(0, equals)] = line.substr(equals + 3);
+    }
+    return outcome;
+}
+
+Outcome runNative(const CompileOptions &options, const IntermediateCodeGnerator &icg)
+{
+    Outcome outcome;
+    ostringstream log;
+    AssemblyCodeGenerator acg(Target::X86_64, true);
+    generateCode(options, icg, acg, log);
+    JitProgram jit;
+    try
+    {
+        X86Encoder encoder;
+        encoder.encode(acg.instructions);
+        jit.load(encoder, acg.dataSlots);
+        outcome.status = jit.run();
+    }
+    catch (const runtime_error &error)
+    {
+        outcome.error = error.what();
+        return outcome;
+    }
+    for (OperandId id = 0; id < icg.operandKinds.size(); id++)
+    {
+        if (icg.operandKinds[id] == OperandKind::VARIABLE)
+        {
+            outcome.variables[icg.operandName(id)] = to_string(jit.slotValue(id));
+        }
+    }
+    return outcome;
+}
+
+// Integer programs with nested ifs and bounded loops. Divisors are small
+// non-zero constants, so a program only traps where it is meant to.
+class ProgramGenerator
+{
+public:
+    explicit ProgramGenerator(uint32_t seed) : random(seed) {}
+
+    string program()
+    {
+        text.clear();
+        assignable.clear();
+        readable.clear();
+        names = 0;
+        size_t count = 3 + random() % 10;
+        for (size_t i = 0; i < count; i++) statement(0);
+        text += "return " + expression(2) + ";\n";
+        return text;
+    }
+
+private:
+    mt19937 random;
+    string text;
+    vector<string> assignable;
+    vector<string> readable;
+    int names = 0;
+
+    size_t pick(size_t count) { return random() % count; }
+
+    string expression(int depth)
+    {
+        static const char *const OPERATORS[] = {"+", "-", "*", "&&", "||", "<", ">", "<=", ">=", "==", "!="};
+        size_t choice = pick(depth <= 0 ? 2 : 5);
+        if (choice == 0 || readable.empty())
+        {
+            static const int32_t EDGES[] = {0, 1, 2, 7, 100, 65536, 2147483647};
+            int32_t value = pick(6) == 0 ? EDGES[pick(size(EDGES))] : static_cast<int32_t>(pick(20));
+            return to_string(value);
+        }
+        if (choice == 1) return readable[pick(readable.size())];
+        if (choice == 2) return "(" + expression(depth - 1) + " / " + to_string(1 + pick(9)) + ")";
+        return "(" + expression(depth - 1) + " " + OPERATORS[pick(size(OPERATORS))] + " " + expression(depth - 1) + ")";
+    }
+
+    void block(int depth)
+    {
+        size_t assignableCount = assignable.size();
+        size_t readableCount = readable.size();
+        text += "{\n";
+        size_t count = 1 + pick(3);
+        for (size_t i = 0; i < count; i++) statement(depth + 1);
+        text += "}\n";
+
+        // What the block declared goes out of scope with it
+        assignable.resize(assignableCount);
+        readable.resize(readableCount);
+    }
+
+    void statement(int depth)
+    {
+        size_t choice = pick(depth >= 2 ? 2 : 4);
+        if (choice == 0 || assignable.empty())
+        {
+            string name = "v" + to_string(names++);
+            text += "int " + name + " = " + expression(2) + ";\n";
+            assignable.push_back(name);
+            readable.push_back(name);
+        }
+        else if (choice == 1)
+        {
+            text += assignable[pick(assignable.size())] + " = " + expression(3) + ";\n";
+        }
+        else if (choice == 2)
+        {
+            text += "if (" + expression(2) + ") ";
+            block(depth);
+            if (pick(2) == 0)
+            {
+                text += "else ";
+                block(depth);
+            }
+        }
+        else
+        {
+            // The counter is never assigned in the body, so the loop ends
+            string counter = "c" + to_string(names++);
+            text += "int " + counter + " = 0;\n";
+            readable.push_back(counter);
+            text += "while (" + counter + " < " + to_string(pick(12)) + ") {\n";
+            size_t assignableCount = assignable.size();
+            size_t readableCount = readable.size();
+            size_t count = 1 + pick(3);
+            for (size_t i = 0; i < count; i++) statement(depth + 1);
+            assignable.resize(assignableCount);
+            readable.resize(readableCount);
+            text += counter + " = " + counter + " + 1;\n}\n";
+        }
+    }
+};
+
+bool check(const string &name, string_view source)
+{
+    Outcome reference;
+    bool haveReference = false;
+    for (int level = 0; level <= 2; level++)
+    {
+        CompileOptions options;
+        options.optimizationLevel = level;
+        options.listings = false;
+        CompileWorkspace workspace;
+        IntermediateCodeGnerator icg;
+        Diagnostics diagnostics;
+        ostringstream log;
+        if (!compileSource(options, source, workspace, icg, diagnostics, log))
+        {
+            cerr << name << ": does not compile" << endl << diagnostics.summary();
+            return false;
+        }
+
+        Outcome interpreted = interpret(icg);
+        if (!haveReference)
+        {
+            reference = interpreted;
+            haveReference = true;
+        }
+        Outcome native = runNative(options, icg);
+        interpreted.keepVariablesOf(reference);
+        native.keepVariablesOf(reference);
+        const pair<const char *, const Outcome *> runs[] = {{"--run", &interpreted}, {"--jit", &native}};
+        for (const auto &run : runs)
+        {
+            if (*run.second == reference) continue;
+            cerr << name << ": -O" << level << " " << run.first << " differs from -O0 --run" << endl;
+            cerr << "  expected: " << reference.describe() << endl;
+            cerr << "  found:    " << run.second->describe() << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    size_t failures = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        SourceBuffer buffer;
+        if (!buffer.open(argv[i]))
+        {
+            cerr << "Error opening file: " << argv[i] << endl;
+            return 1;
+        }
+        if (!check(argv[i], buffer.view())) failures++;
+    }
+
+    constexpr size_t GENERATED = 300;
+    ProgramGenerator generator(2024);
+    for (size_t i = 0; i < GENERATED; i++)
+    {
+        string source = generator.program();
+        if (!check("generated program " + to_string(i), source))
+        {
+            cerr << source;
+            failures++;
+        }
+    }
+
+    cout << "engineDiff: " << argc - 1 << " files and " << GENERATED << " generated programs at -O0..-O2, "
+         << failures << " differing" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Differential test of the two lexer engines: every input is tokenized by
+// the if-chain and by the DFA, and the two token dumps must be identical,
+// errors included. Inputs are the files given on the command line plus
+// random ones built from fragments of the language. Run it with
+// `make test`.
+#include "../src/lexer/lexer.h"
+#include "../src/lexer/sourceBuffer.h"
+#include<random>
+#include<sstream>
+#include<string>
+#include<vector>
+
+using namespace std;
+
+namespace {
+
+// One line per token, then the errors reported while scanning
+string dump(string_view source, LexerEngine engine)
+{
+    StringPool pool;
+    Diagnostics diagnostics;
+    Lexer lexer(source, pool, diagnostics, engine);
+    ostringstream out;
+    for (Token token = lexer.next();; token = lexer.next())
+    {
+        out << lexer.tokenTypeToString(token.type) << ' ' << token.lineNumber << ' ' << token.offset << ' '
+            << token.length << ' ' << lexer.tokenValue(token) << '\n';
+        if (token.type == T_EOF) break;
+    }
+    out << diagnostics.summary();
+    return out.str();
+}
+
+// Tokens, near-tokens and broken ones, glued with and without spaces
+string randomSource(mt19937 &random)
+{
+    static const char *const FRAGMENTS[] = {
+        "int", "float", "double", "string", "char", "bool", "true", "false", "if", "else", "agar", "magar",
+        "while", "for", "do", "switch", "case", "default", "break", "continue", "return", "void", "cout", "cin",
+        "x", "counter", "_tmp", "a1", "intx", "iff", "0", "42", "3.14", "1.", ".5", "007", "\"text\"",
+        "\"esc\\n\\\"q\\\"\"", "\"open", "'c'", "'\\n'", "=", "==", "!=", "<", "<=", ">", ">=", "<<", ">>", "&&",
+        "||", "&", "|", "!", "+", "-", "*", "/", "(", ")", "{", "}", ";", ":", "#include", "// line comment\n",
+        "/* block */", "/* open", "/", "*", "@", "$", "\t", "\r\n", "\n", " ", "  ",
+    };
+    string source;
+    size_t count = random() % 60;
+    for (size_t i = 0; i < count; i++)
+    {
+        source += FRAGMENTS[random() % size(FRAGMENTS)];
+        if (random() % 3 != 0) source += ' ';
+    }
+    // Any byte at all, now and then
+    if (random() % 8 == 0) source += static_cast<char>(random() % 256);
+    return source;
+}
+
+bool check(const string &name, string_view source)
+{
+    string ifChain = dump(source, LexerEngine::IF_CHAIN);
+    string dfa = dump(source, LexerEngine::DFA);
+    if (ifChain == dfa) return true;
+
+    istringstream left(ifChain);
+    istringstream right(dfa);
+    string leftLine;
+    string rightLine;
+    for (size_t line = 1;; line++)
+    {
+        bool more = static_cast<bool>(getline(left, leftLine));
+        more = static_cast<bool>(getline(right, rightLine)) || more;
+        if (leftLine != rightLine || !more)
+        {
+            cerr << name << ": the engines differ at token " << line << endl;
+            cerr << "  if-chain: " << leftLine << endl;
+            cerr << "  dfa:      " << rightLine << endl;
+            return false;
+        }
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    size_t failures = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        SourceBuffer buffer;
+        if (!buffer.open(argv[i]))
+        {
+            cerr << "Error opening file: " << argv[i] << endl;
+            return 1;
+        }
+        if (!check(argv[i], buffer.view())) failures++;
+    }
+
+    constexpr size_t GENERATED = 20000;
+    mt19937 random(2024);
+    for (size_t i = 0; i < GENERATED; i++)
+    {
+        string source = randomSource(random);
+        if (!check("generated input " + to_string(i), source))
+        {
+            cerr << "  input: \"" << source << "\"" << endl;
+            failures++;
+        }
+    }
+
+    cout << "lexerDiff: " << argc - 1 << " files and " << GENERATED << " generated inputs, " << failures
+         << " differing" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// The parser's nesting limit: sources nested far too deep, in every way
+// the grammar allows, must stop with a syntax error instead of overflowing
+// the stack, and ones nested just under the limit must still compile and
+// run. Run it with `make test`.
+#include "../src/driver/compiler.h"
+#include "../src/interpreter/interpreter.h"
+#include<sstream>
+#include<string>
+
+using namespace std;
+
+namespace {
+
+string repeat(const string &text, size_t count)
+{
+    string result;
+    result.reserve(text.size() * count);
+    for (size_t i = 0; i < count; i++) result += text;
+    return result;
+}
+
+string parentheses(size_t depth) { return "int x = " + repeat("(", depth) + "1" + repeat(")", depth) + ";\nreturn x;\n"; }
+string braces(size_t depth) { return "int x = 1;\n" + repeat("{", depth) + "x = 1;" + repeat("}", depth) + "\nreturn x;\n"; }
+string ifs(size_t depth) { return "int x = 1;\n" + repeat("if (x) ", depth) + "x = 1;\nreturn x;\n"; }
+string comparisons(size_t depth) { return "int x = 1" + repeat(" <= 1", depth) + ";\nreturn x;\n"; }
+string sums(size_t depth) { return "int x = 1" + repeat(" + 0", depth) + ";\nreturn x;\n"; }
+string products(size_t depth) { return "int x = 1" + repeat(" * 1", depth) + ";\nreturn x;\n"; }
+
+bool check(const string &name, const string &source, bool deep)
+{
+    for (int level = 0; level <= 2; level++)
+    {
+        CompileOptions options;
+        options.optimizationLevel = level;
+        options.listings = false;
+        CompileWorkspace workspace;
+        IntermediateCodeGnerator icg;
+        Diagnostics diagnostics;
+        ostringstream log;
+        bool compiled = compileSource(options, source, workspace, icg, diagnostics, log);
+        if (deep)
+        {
+            if (!compiled && diagnostics.summary().find("nesting deeper than") != string::npos) continue;
+            cerr << name << ": -O" << level << " does not report the nesting" << endl << diagnostics.summary();
+            return false;
+        }
+        if (!compiled)
+        {
+            cerr << name << ": -O" << level << " does not compile" << endl << diagnostics.summary();
+            return false;
+        }
+        Interpreter interpreter;
+        interpreter.load(icg);
+        if (interpreter.run() != 1)
+        {
+            cerr << name << ": -O" << level << " does not return 1" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main()
+{
+    const pair<const char *, string (*)(size_t)> shapes[] = {
+        {"parentheses", parentheses}, {"braces", braces}, {"ifs", ifs},
+        {"comparisons", comparisons}, {"sums", sums}, {"products", products},
+    };
+    size_t failures = 0;
+    for (const auto &shape : shapes)
+    {
+        if (!check(string(shape.first) + " 200 deep", shape.second(200), false)) failures++;
+        if (!check(string(shape.first) + " 300000 deep", shape.second(300000), true)) failures++;
+    }
+    cout << "parserNesting: " << size(shapes) << " shapes, " << failures << " failing" << endl;
+    return failures == 0 ? 0 : 1;
+}